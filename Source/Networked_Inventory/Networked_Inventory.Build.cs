@@ -36,6 +36,9 @@ public class Networked_Inventory : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"NetCore",
+				"DeveloperSettings",
+				"SQLiteCore",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
@@ -0,0 +1,606 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ContainerInventoryComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "GameFramework/Actor.h"
+#include "InventoryMemory.h"
+
+class FContainerMutationScope
+{
+public:
+	FContainerMutationScope(UContainerInventoryComponent* component) : Component(component)
+	{
+		Component->MutationDepth++;
+	}
+
+	~FContainerMutationScope()
+	{
+		if (--Component->MutationDepth == 0)
+		{
+			Component->EndMutation();
+		}
+	}
+
+private:
+	UContainerInventoryComponent* Component;
+};
+
+UContainerInventoryComponent::UContainerInventoryComponent()
+{
+	// No need to tick.
+	PrimaryComponentTick.bCanEverTick = false;
+
+	MutationDepth = 0;
+	bOwnerEntriesDirty = false;
+	bPublicEntriesDirty = false;
+	ChangedContainers = 0;
+	OpenContainers = 0;
+}
+
+void UContainerInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// On-demand containers are not properties; they go out through Client_ReceiveContainer/Client_UpdateContainers
+	FDoRepLifetimeParams params;
+	params.bIsPushBased = true;
+	params.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UContainerInventoryComponent, OwnerEntries, params);
+	params.Condition = COND_None;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UContainerInventoryComponent, PublicEntries, params);
+}
+
+TArray<FInventoryContainerEntry>& UContainerInventoryComponent::GetStorage(EInventoryContainerReplication replication)
+{
+	switch (replication)
+	{
+	case EInventoryContainerReplication::Everyone:
+		return PublicEntries;
+	case EInventoryContainerReplication::OnDemand:
+		return OnDemandEntries;
+	default:
+		return OwnerEntries;
+	}
+}
+
+const TArray<FInventoryContainerEntry>& UContainerInventoryComponent::GetStorage(EInventoryContainerReplication replication) const
+{
+	return const_cast<UContainerInventoryComponent*>(this)->GetStorage(replication);
+}
+
+bool UContainerInventoryComponent::HasAuthority() const
+{
+	const AActor* owner = GetOwner();
+	return owner == nullptr || owner->GetLocalRole() == ROLE_Authority;
+}
+
+bool UContainerInventoryComponent::HasRemoteClient() const
+{
+	const AActor* owner = GetOwner();
+	return owner != nullptr && owner->GetLocalRole() == ROLE_Authority && owner->GetNetConnection() != nullptr;
+}
+
+int32 UContainerInventoryComponent::FindContainer(const FName containerName) const
+{
+	const int32 numContainers = FMath::Min(Containers.Num(), MaxContainers);
+	for (int32 i = 0; i < numContainers; i++)
+	{
+		if (Containers[i].Name == containerName)
+		{
+			return i;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 UContainerInventoryComponent::GetQuantityAt(uint8 container, const FName itemCode) const
+{
+	const int32* index = EntryLookup.Find(FContainerItemKey(container, itemCode));
+	return index ? GetStorage(Containers[container].Replication)[*index].Quantity : 0;
+}
+
+EChangeStatus UContainerInventoryComponent::ModifyEntryAt(uint8 container, const FName itemCode, int32 quantity)
+{
+	const EInventoryContainerReplication replication = Containers[container].Replication;
+	TArray<FInventoryContainerEntry>& storage = GetStorage(replication);
+	const FContainerItemKey key(container, itemCode);
+
+	const int32* existingIndex = EntryLookup.Find(key);
+	if (existingIndex == nullptr && quantity <= 0)
+	{
+		return EChangeStatus::CouldNotMakeChange;
+	}
+
+	const int32 index = existingIndex ? *existingIndex : EntryLookup.Add(key, storage.Emplace(container, itemCode, 0));
+	storage[index].Quantity += quantity;
+	if (storage[index].Quantity <= 0)
+	{
+		EntryLookup.Remove(key);
+		RemoveStorageEntry(storage, index);
+	}
+
+	switch (replication)
+	{
+	case EInventoryContainerReplication::Everyone:
+		bPublicEntriesDirty = true;
+		break;
+	case EInventoryContainerReplication::OnDemand:
+		if (OpenContainers & (1u << container))
+		{
+			PendingOnDemandChanges.Add(key);
+		}
+		break;
+	default:
+		bOwnerEntriesDirty = true;
+		break;
+	}
+
+	ChangedContainers |= 1u << container;
+	return EChangeStatus::Success;
+}
+
+void UContainerInventoryComponent::RemoveStorageEntry(TArray<FInventoryContainerEntry>& storage, int32 index)
+{
+	storage.RemoveAtSwap(index);
+	if (index < storage.Num())
+	{
+		EntryLookup[FContainerItemKey(storage[index].Container, storage[index].ItemCode)] = index;
+	}
+}
+
+void UContainerInventoryComponent::RebuildLookup(EInventoryContainerReplication replication)
+{
+	for (auto it = EntryLookup.CreateIterator(); it; ++it)
+	{
+		const int32 container = it->Key.Get<0>();
+		if (!Containers.IsValidIndex(container) || Containers[container].Replication == replication)
+		{
+			it.RemoveCurrent();
+		}
+	}
+
+	const TArray<FInventoryContainerEntry>& storage = GetStorage(replication);
+	for (int32 i = 0; i < storage.Num(); i++)
+	{
+		EntryLookup.Add(FContainerItemKey(storage[i].Container, storage[i].ItemCode), i);
+	}
+}
+
+void UContainerInventoryComponent::EndMutation()
+{
+	if (bOwnerEntriesDirty)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UContainerInventoryComponent, OwnerEntries, this);
+		bOwnerEntriesDirty = false;
+	}
+
+	if (bPublicEntriesDirty)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UContainerInventoryComponent, PublicEntries, this);
+		bPublicEntriesDirty = false;
+	}
+
+	if (PendingOnDemandChanges.Num() > 0)
+	{
+		TArray<FInventoryContainerEntry> updates;
+		updates.Reserve(PendingOnDemandChanges.Num());
+		for (const FContainerItemKey& key : PendingOnDemandChanges)
+		{
+			updates.Emplace(key.Get<0>(), key.Get<1>(), GetQuantityAt(key.Get<0>(), key.Get<1>()));
+		}
+		PendingOnDemandChanges.Reset();
+
+		if (HasRemoteClient())
+		{
+			Client_UpdateContainers(updates);
+		}
+	}
+
+	const uint32 changedContainers = ChangedContainers;
+	ChangedContainers = 0;
+	BroadcastContainerChanges(changedContainers);
+}
+
+void UContainerInventoryComponent::BroadcastContainerChanges(uint32 changedContainers)
+{
+	for (int32 i = 0; changedContainers != 0 && i < Containers.Num(); i++, changedContainers >>= 1)
+	{
+		if (changedContainers & 1u)
+		{
+			OnContainerChanged.Broadcast(Containers[i].Name);
+		}
+	}
+}
+
+EChangeStatus UContainerInventoryComponent::ModifyContainer(const FName containerName, const FInventoryEntry& entryChange)
+{
+	if (!HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Containers can only be changed on the server. Ignoring change to item %s."), *entryChange.ItemCode.ToString());
+		return EChangeStatus::CouldNotMakeChange;
+	}
+
+	const int32 container = FindContainer(containerName);
+	if (container == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No container named %s. Ignoring change to item %s."), *containerName.ToString(), *entryChange.ItemCode.ToString());
+		return EChangeStatus::CouldNotMakeChange;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FContainerMutationScope mutationScope(this);
+	return ModifyEntryAt((uint8)container, entryChange.ItemCode, entryChange.Quantity);
+}
+
+EChangeGroupStatus UContainerInventoryComponent::ModifyContainers(const TArray<FInventoryContainerChange>& changes)
+{
+	if (!HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Containers can only be changed on the server. Ignoring %i changes."), changes.Num());
+		return EChangeGroupStatus::SomeChangesLost;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FContainerMutationScope mutationScope(this);
+
+	EChangeGroupStatus groupStatus = EChangeGroupStatus::AllSuccessful;
+	for (const FInventoryContainerChange& change : changes)
+	{
+		const int32 container = FindContainer(change.Container);
+		if (container == INDEX_NONE || ModifyEntryAt((uint8)container, change.ItemCode, change.Quantity) != EChangeStatus::Success)
+		{
+			groupStatus = EChangeGroupStatus::SomeChangesLost;
+		}
+	}
+
+	return groupStatus;
+}
+
+ETransferStatus UContainerInventoryComponent::MoveItem(const FName fromContainer, const FName toContainer, const FName itemCode, int32 quantity)
+{
+	if (!HasAuthority())
+	{
+		return ETransferStatus::NotAuthority;
+	}
+
+	const int32 from = FindContainer(fromContainer);
+	const int32 to = FindContainer(toContainer);
+	if (from == INDEX_NONE || to == INDEX_NONE || from == to)
+	{
+		return ETransferStatus::InvalidInventory;
+	}
+
+	if (quantity <= 0)
+	{
+		return ETransferStatus::InvalidQuantity;
+	}
+
+	if (GetQuantityAt((uint8)from, itemCode) < quantity)
+	{
+		return ETransferStatus::InsufficientQuantity;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FContainerMutationScope mutationScope(this);
+	ModifyEntryAt((uint8)from, itemCode, -quantity);
+	ModifyEntryAt((uint8)to, itemCode, quantity);
+	return ETransferStatus::Success;
+}
+
+int32 UContainerInventoryComponent::GetQuantityIn(const FName containerName, const FName itemCode) const
+{
+	const int32 container = FindContainer(containerName);
+	return container != INDEX_NONE ? GetQuantityAt((uint8)container, itemCode) : 0;
+}
+
+TArray<FInventoryEntry> UContainerInventoryComponent::GetContainerEntries(const FName containerName) const
+{
+	TArray<FInventoryEntry> entries;
+	const int32 container = FindContainer(containerName);
+	if (container == INDEX_NONE)
+	{
+		return entries;
+	}
+
+	for (const FInventoryContainerEntry& entry : GetStorage(Containers[container].Replication))
+	{
+		if (entry.Container == container)
+		{
+			entries.Emplace(entry.ItemCode, entry.Quantity);
+		}
+	}
+	return entries;
+}
+
+bool UContainerInventoryComponent::IsContainerAvailable(const FName containerName) const
+{
+	const int32 container = FindContainer(containerName);
+	if (container == INDEX_NONE)
+	{
+		return false;
+	}
+
+	return Containers[container].Replication != EInventoryContainerReplication::OnDemand || HasAuthority() || (OpenContainers & (1u << container)) != 0;
+}
+
+void UContainerInventoryComponent::OpenContainer(const FName containerName)
+{
+	const int32 container = FindContainer(containerName);
+	if (container == INDEX_NONE || Containers[container].Replication != EInventoryContainerReplication::OnDemand || HasAuthority())
+	{
+		return;  // The server always holds every container
+	}
+
+	Server_OpenContainer((uint8)container);
+}
+
+void UContainerInventoryComponent::CloseContainer(const FName containerName)
+{
+	const int32 container = FindContainer(containerName);
+	if (container == INDEX_NONE || Containers[container].Replication != EInventoryContainerReplication::OnDemand || HasAuthority())
+	{
+		return;
+	}
+
+	// Updates still in flight for it are ignored from here on
+	if (OpenContainers & (1u << container))
+	{
+		OpenContainers &= ~(1u << container);
+		ReplaceOnDemandContainer((uint8)container, TArray<FInventoryEntry>());
+		BroadcastContainerChanges(1u << container);
+	}
+	Server_CloseContainer((uint8)container);
+}
+
+void UContainerInventoryComponent::Server_OpenContainer_Implementation(uint8 container)
+{
+	if (container >= FMath::Min(Containers.Num(), MaxContainers) || Containers[container].Replication != EInventoryContainerReplication::OnDemand)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Client asked to open container %i, which is not an on-demand container."), container);
+		return;
+	}
+
+	OpenContainers |= 1u << container;
+
+	FInventoryEntryBatch batch;
+	for (const FInventoryContainerEntry& entry : OnDemandEntries)
+	{
+		if (entry.Container == container)
+		{
+			batch.Entries.Emplace(entry.ItemCode, entry.Quantity);
+		}
+	}
+	Client_ReceiveContainer(container, batch);
+}
+
+void UContainerInventoryComponent::Server_CloseContainer_Implementation(uint8 container)
+{
+	if (container < MaxContainers)
+	{
+		OpenContainers &= ~(1u << container);
+	}
+}
+
+void UContainerInventoryComponent::Client_ReceiveContainer_Implementation(uint8 container, const FInventoryEntryBatch& entries)
+{
+	if (HasAuthority() || !Containers.IsValidIndex(container) || container >= MaxContainers)
+	{
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	OpenContainers |= 1u << container;
+	ReplaceOnDemandContainer(container, entries.Entries);
+	BroadcastContainerChanges(1u << container);
+}
+
+void UContainerInventoryComponent::Client_UpdateContainers_Implementation(const TArray<FInventoryContainerEntry>& entries)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	uint32 changedContainers = 0;
+	for (const FInventoryContainerEntry& entry : entries)
+	{
+		if (entry.Container < MaxContainers && (OpenContainers & (1u << entry.Container)))
+		{
+			ApplyOnDemandEntry(entry);
+			changedContainers |= 1u << entry.Container;
+		}
+	}
+	BroadcastContainerChanges(changedContainers);
+}
+
+void UContainerInventoryComponent::ReplaceOnDemandContainer(uint8 container, const TArray<FInventoryEntry>& entries)
+{
+	OnDemandEntries.RemoveAll([container](const FInventoryContainerEntry& entry) { return entry.Container == container; });
+	for (const FInventoryEntry& entry : entries)
+	{
+		if (entry.Quantity > 0)
+		{
+			OnDemandEntries.Emplace(container, entry.ItemCode, entry.Quantity);
+		}
+	}
+	RebuildLookup(EInventoryContainerReplication::OnDemand);
+}
+
+void UContainerInventoryComponent::ApplyOnDemandEntry(const FInventoryContainerEntry& entry)
+{
+	const FContainerItemKey key(entry.Container, entry.ItemCode);
+	int32 index;
+	if (entry.Quantity <= 0)
+	{
+		if (EntryLookup.RemoveAndCopyValue(key, index))
+		{
+			RemoveStorageEntry(OnDemandEntries, index);
+		}
+	}
+	else if (const int32* existingIndex = EntryLookup.Find(key))
+	{
+		OnDemandEntries[*existingIndex].Quantity = entry.Quantity;
+	}
+	else
+	{
+		EntryLookup.Add(key, OnDemandEntries.Add(entry));
+	}
+}
+
+void UContainerInventoryComponent::OnRep_OwnerEntries(const TArray<FInventoryContainerEntry>& previousEntries)
+{
+	ApplyReplicatedStorage(EInventoryContainerReplication::OwnerOnly, previousEntries);
+}
+
+void UContainerInventoryComponent::OnRep_PublicEntries(const TArray<FInventoryContainerEntry>& previousEntries)
+{
+	ApplyReplicatedStorage(EInventoryContainerReplication::Everyone, previousEntries);
+}
+
+void UContainerInventoryComponent::ApplyReplicatedStorage(EInventoryContainerReplication replication, const TArray<FInventoryContainerEntry>& previousEntries)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	const TArray<FInventoryContainerEntry>& storage = GetStorage(replication);
+	uint32 changedContainers = 0;
+
+	// EntryLookup still indexes the previous entries at this point
+	for (const FInventoryContainerEntry& entry : storage)
+	{
+		const int32* previousIndex = EntryLookup.Find(FContainerItemKey(entry.Container, entry.ItemCode));
+		if (previousIndex == nullptr || !previousEntries.IsValidIndex(*previousIndex) || previousEntries[*previousIndex].Quantity != entry.Quantity)
+		{
+			changedContainers |= 1u << entry.Container;
+		}
+	}
+
+	RebuildLookup(replication);
+
+	for (const FInventoryContainerEntry& entry : previousEntries)
+	{
+		if (!EntryLookup.Contains(FContainerItemKey(entry.Container, entry.ItemCode)))
+		{
+			changedContainers |= 1u << entry.Container;
+		}
+	}
+
+	BroadcastContainerChanges(changedContainers);
+}
+
+void UContainerInventoryComponent::ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (Containers.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FInventoryContainerChange> changes;
+	changes.Reserve(inventoryChanges.Num());
+	for (const FInventoryEntry& entry : inventoryChanges)
+	{
+		changes.Emplace(Containers[0].Name, entry.ItemCode, entry.Quantity);
+	}
+	ModifyContainers(changes);
+}
+
+TFuture<FInventoryRequestResult> UContainerInventoryComponent::ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (!HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Containers can only be changed on the server. Rejecting request of %i entries."), inventoryChanges.Num());
+		return MakeCompletedRequest(EInventoryRequestOutcome::Rejected, MakeTuple(EChangeGroupStatus::SomeChangesLost, TArray<EChangeStatus>()));
+	}
+
+	if (Containers.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s has no containers to change. Rejecting request of %i entries."), *GetName(), inventoryChanges.Num());
+		return MakeCompletedRequest(EInventoryRequestOutcome::Rejected, MakeTuple(EChangeGroupStatus::SomeChangesLost, TArray<EChangeStatus>()));
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	TTuple<EChangeGroupStatus, TArray<EChangeStatus>> statuses(EChangeGroupStatus::AllSuccessful, TArray<EChangeStatus>());
+	{
+		FContainerMutationScope mutationScope(this);
+		statuses.Value.Reserve(inventoryChanges.Num());
+		for (const FInventoryEntry& entry : inventoryChanges)
+		{
+			const EChangeStatus status = ModifyEntryAt(0, entry.ItemCode, entry.Quantity);
+			if (status != EChangeStatus::Success)
+			{
+				statuses.Key = EChangeGroupStatus::SomeChangesLost;
+			}
+			statuses.Value.Add(status);
+		}
+	}
+
+	// Resolved after the batch is committed, so continuations see the replicated state
+	return MakeCompletedRequest(EInventoryRequestOutcome::Committed, statuses);
+}
+
+void UContainerInventoryComponent::AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	ModifyInventory(inventoryChanges);
+}
+
+void UContainerInventoryComponent::RemoveItemsFromInventory(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	TArray<FInventoryEntry> finalChanges;
+	finalChanges.Reserve(inventoryChanges.Num());
+	for (const FInventoryEntry& entry : inventoryChanges)
+	{
+		finalChanges.Emplace(entry.ItemCode, -entry.Quantity);  // Flip so it is removed rather than added
+	}
+	ModifyInventory(finalChanges);
+}
+
+FString UContainerInventoryComponent::ToString() const
+{
+	FString s = "{\n";
+	for (const FInventoryContainerSpec& spec : Containers)
+	{
+		s.Appendf(TEXT("\t%s: {\n"), *spec.Name.ToString());
+		for (const FInventoryEntry& entry : GetContainerEntries(spec.Name))
+		{
+			s.Appendf(TEXT("\t\t%s: %i\n"), *entry.ItemCode.ToString(), entry.Quantity);
+		}
+		s.Append(TEXT("\t}\n"));
+	}
+	s.Append(TEXT("}\n"));
+	return s;
+}
+
+void UContainerInventoryComponent::GetEntries(TArray<FInventoryEntry>& outEntries) const
+{
+	outEntries = Containers.Num() > 0 ? GetContainerEntries(Containers[0].Name) : TArray<FInventoryEntry>();
+}
+
+int32 UContainerInventoryComponent::GetQuantityFor(const FName itemCode) const
+{
+	return Containers.Num() > 0 ? GetQuantityAt(0, itemCode) : 0;
+}
+
+FInventoryMemoryUsage UContainerInventoryComponent::GetMemoryUsage() const
+{
+	FInventoryMemoryUsage usage;
+	usage.NumEntries = OwnerEntries.Num() + PublicEntries.Num() + OnDemandEntries.Num();
+	usage.AllocatedBytes = OwnerEntries.GetAllocatedSize() + PublicEntries.GetAllocatedSize() + OnDemandEntries.GetAllocatedSize()
+		+ EntryLookup.GetAllocatedSize() + PendingOnDemandChanges.GetAllocatedSize();
+	usage.UsedBytes = InventoryMemory::GetUsedSize(OwnerEntries) + InventoryMemory::GetUsedSize(PublicEntries) + InventoryMemory::GetUsedSize(OnDemandEntries)
+		+ InventoryMemory::GetUsedSize(EntryLookup) + PendingOnDemandChanges.GetAllocatedSize();
+	return usage;
+}
+
+void UContainerInventoryComponent::Shrink()
+{
+	check(MutationDepth == 0);
+
+	// Shrinking keeps element order, so nothing is marked dirty for replication
+	OwnerEntries.Shrink();
+	PublicEntries.Shrink();
+	OnDemandEntries.Shrink();
+	EntryLookup.Compact();
+	EntryLookup.Shrink();
+	PendingOnDemandChanges.Empty();
+}
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FileInventoryPersistenceBackend.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	// 2 added counters, 3 item expiries
+	constexpr uint32 InventoryFileVersion = 3;
+}
+
+FFileInventoryPersistenceBackend::FFileInventoryPersistenceBackend(const FString& directory) : Directory(directory)
+{
+	IFileManager::Get().MakeDirectory(*Directory, true);
+}
+
+bool FFileInventoryPersistenceBackend::SaveBatch(const TArray<FInventoryPersistenceRecord>& records)
+{
+	bool bAllSaved = true;
+	for (const FInventoryPersistenceRecord& record : records)
+	{
+		TArray<uint8> bytes;
+		FMemoryWriter writer(bytes);
+
+		uint32 version = InventoryFileVersion;
+		int32 count = record.Entries.Num();
+		writer << version;
+		writer << count;
+		for (const FInventoryEntry& entry : record.Entries)
+		{
+			FString itemCode = entry.ItemCode.ToString();
+			int32 quantity = entry.Quantity;
+			writer << itemCode;
+			writer << quantity;
+		}
+
+		int32 numCounters = record.Counters.Num();
+		writer << numCounters;
+		for (const FInventoryCounterValue& counter : record.Counters)
+		{
+			FString itemCode = counter.ItemCode.ToString();
+			int64 value = counter.Value;
+			writer << itemCode;
+			writer << value;
+		}
+
+		int32 numExpiries = record.Expiries.Num();
+		writer << numExpiries;
+		for (const FInventoryItemExpiry& expiry : record.Expiries)
+		{
+			FString itemCode = expiry.ItemCode.ToString();
+			int64 expiresUtcTicks = expiry.ExpiresUtc.GetTicks();
+			writer << itemCode;
+			writer << expiresUtcTicks;
+		}
+
+		// Write next to the old file and swap it in, so a crash never leaves a half-written inventory
+		const FString path = GetPathFor(record.InventoryId);
+		const FString tempPath = path + TEXT(".tmp");
+		if (!FFileHelper::SaveArrayToFile(bytes, *tempPath) || !IFileManager::Get().Move(*path, *tempPath, true, true))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not write inventory %s to %s."), *record.InventoryId, *path);
+			bAllSaved = false;
+		}
+	}
+
+	return bAllSaved;
+}
+
+EInventoryLoadResult FFileInventoryPersistenceBackend::Load(const FString& inventoryId, FInventoryPersistenceRecord& outRecord)
+{
+	const FString path = GetPathFor(inventoryId);
+	if (!IFileManager::Get().FileExists(*path))
+	{
+		return EInventoryLoadResult::NotFound;
+	}
+
+	TArray<uint8> bytes;
+	if (!FFileHelper::LoadFileToArray(bytes, *path))
+	{
+		return EInventoryLoadResult::Failed;
+	}
+
+	FMemoryReader reader(bytes);
+	uint32 version = 0;
+	int32 count = 0;
+	reader << version;
+	reader << count;
+
+	if (version < 1 || version > InventoryFileVersion || count < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Inventory file for %s is corrupt or from an unknown version (%u)."), *inventoryId, version);
+		return EInventoryLoadResult::Failed;
+	}
+
+	outRecord.InventoryId = inventoryId;
+	outRecord.Entries.Reset(count);
+	for (int32 i = 0; i < count && !reader.IsError(); i++)
+	{
+		FString itemCode;
+		int32 quantity = 0;
+		reader << itemCode;
+		reader << quantity;
+		outRecord.Entries.Emplace(FName(*itemCode), quantity);
+	}
+
+	outRecord.Counters.Reset();
+	if (version >= 2 && !reader.IsError())
+	{
+		int32 numCounters = 0;
+		reader << numCounters;
+		if (numCounters < 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Inventory file for %s is corrupt."), *inventoryId);
+			return EInventoryLoadResult::Failed;
+		}
+
+		outRecord.Counters.Reserve(numCounters);
+		for (int32 i = 0; i < numCounters && !reader.IsError(); i++)
+		{
+			FString itemCode;
+			int64 value = 0;
+			reader << itemCode;
+			reader << value;
+			outRecord.Counters.Emplace(FName(*itemCode), value);
+		}
+	}
+
+	outRecord.Expiries.Reset();
+	if (version >= 3 && !reader.IsError())
+	{
+		int32 numExpiries = 0;
+		reader << numExpiries;
+		if (numExpiries < 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Inventory file for %s is corrupt."), *inventoryId);
+			return EInventoryLoadResult::Failed;
+		}
+
+		outRecord.Expiries.Reserve(numExpiries);
+		for (int32 i = 0; i < numExpiries && !reader.IsError(); i++)
+		{
+			FString itemCode;
+			int64 expiresUtcTicks = 0;
+			reader << itemCode;
+			reader << expiresUtcTicks;
+			outRecord.Expiries.Emplace(FName(*itemCode), FDateTime(expiresUtcTicks));
+		}
+	}
+
+	return reader.IsError() ? EInventoryLoadResult::Failed : EInventoryLoadResult::Found;
+}
+
+FString FFileInventoryPersistenceBackend::GetPathFor(const FString& inventoryId) const
+{
+	return FPaths::Combine(Directory, FPaths::MakeValidFileName(inventoryId) + TEXT(".inv"));
+}
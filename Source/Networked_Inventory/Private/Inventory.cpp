@@ -2,9 +2,36 @@
 
 
 #include "Inventory.h"
+#include "InventoryMemory.h"
+#include "InventoryVerifier.h"
+#include "InventoryAggregateSubsystem.h"
+#include "InventoryInterface.h"
+
+class FInventoryBatchScope
+{
+public:
+	FInventoryBatchScope(UInventory* inventory) : Inventory(inventory)
+	{
+		Inventory->BatchDepth++;
+	}
+
+	~FInventoryBatchScope()
+	{
+		if (--Inventory->BatchDepth == 0)
+		{
+			Inventory->CommitBatch();
+		}
+	}
+
+private:
+	UInventory* Inventory;
+};
 
 TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UInventory::ModifyGroupOfEntries(const TArray<FInventoryEntry>& inventoryChanges)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
 	TArray<EChangeStatus> changeStatuses;
 	changeStatuses.Reserve(inventoryChanges.Num());
 
@@ -28,6 +55,9 @@ TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UInventory::ModifyGroupOfEntri
 
 TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UInventory::ModifyGroupOfEntries(const TMap<FName, int32>& inventoryChanges)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
 	TArray<EChangeStatus> changeStatuses;
 	changeStatuses.Reserve(inventoryChanges.Num());
 
@@ -54,19 +84,27 @@ TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UInventory::ModifyGroupOfEntri
 
 EAddStatus UInventory::AddNewEntry(const FInventoryEntry& entry)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
 	if (Contains(entry.ItemCode))
 	{
 		return EAddStatus::ItemAlreadyInInventory;
 	}
 
-	InventoryEntries[entry.ItemCode] = entry.Quantity;
+	InventoryEntries.Add(entry.ItemCode, entry.Quantity);
+	OnEntryChanged(entry.ItemCode, 0, entry.Quantity);
 
 	return EAddStatus::Success;
 }
 
 EChangeStatus UInventory::ModifyEntry(const FInventoryEntry& entryChange)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
 	int32& quantityRef = InventoryEntries.FindOrAdd(entryChange.ItemCode, 0);
+	const int32 oldQuantity = quantityRef;
 	quantityRef += entryChange.Quantity;
 
 	check(quantityRef == InventoryEntries[entryChange.ItemCode]);
@@ -75,18 +113,24 @@ EChangeStatus UInventory::ModifyEntry(const FInventoryEntry& entryChange)
 	{
 		UE_LOG(LogTemp, Log, TEXT("Non-positive quantity for item %s. Quantity: %i. Removing..."), *entryChange.ItemCode.ToString(), entryChange.Quantity);
 
-		ERemovalStatus status = RemoveItem(entryChange.ItemCode);
+		ERemovalStatus status = RemoveEntry(entryChange.ItemCode, oldQuantity);
 		if (status != ERemovalStatus::Success)
 		{
 			return EChangeStatus::CouldNotMakeChange;
 		}
+
+		return EChangeStatus::Success;
 	}
 
+	OnEntryChanged(entryChange.ItemCode, oldQuantity, quantityRef);
+
 	return EChangeStatus::Success;
 }
 
 TArray<ERemovalStatus> UInventory::RemoveGroupOfItems(const TArray<FName>& itemsToRemove)
 {
+	FInventoryBatchScope batchScope(this);
+
 	TArray<ERemovalStatus> removalStatuses;
 	removalStatuses.Reserve(itemsToRemove.Num());
 
@@ -101,10 +145,11 @@ TArray<ERemovalStatus> UInventory::RemoveGroupOfItems(const TArray<FName>& items
 
 ERemovalStatus UInventory::RemoveItem(const FName itemCode)
 {
-	if (InventoryEntries.Contains(itemCode))
+	FInventoryBatchScope batchScope(this);
+
+	if (const int32* quantity = InventoryEntries.Find(itemCode))
 	{
-		InventoryEntries.Remove(itemCode);
-		return ERemovalStatus::Success;
+		return RemoveEntry(itemCode, *quantity);
 	}
 	else
 	{
@@ -112,6 +157,205 @@ ERemovalStatus UInventory::RemoveItem(const FName itemCode)
 	}
 }
 
+ERemovalStatus UInventory::RemoveEntry(const FName itemCode, int32 previousQuantity)
+{
+	if (InventoryEntries.Remove(itemCode) == 0)
+	{
+		return ERemovalStatus::ItemNotInInventory;
+	}
+
+	InstanceData.Release(itemCode);
+	OnEntryChanged(itemCode, previousQuantity, 0);
+	return ERemovalStatus::Success;
+}
+
+void UInventory::OnEntryChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity)
+{
+	TagIndex.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	Snapshots.OnQuantityChanged(itemCode, newQuantity);
+	StateHash.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	Aggregates.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	Expiries.OnQuantityChanged(itemCode, newQuantity);
+	for (FInventorySortedView& view : SortedViews)
+	{
+		view.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	}
+
+	if (PendingChanges.Record(itemCode, oldQuantity, newQuantity))
+	{
+		OnChangesPending.Broadcast();
+	}
+}
+
+void UInventory::SetEntries(const TMap<FName, int32>& entries)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
+	if (&entries == &InventoryEntries)
+	{
+		return;
+	}
+
+	TArray<FName> removedItems;
+	for (const auto& pair : InventoryEntries)
+	{
+		if (!entries.Contains(pair.Key))
+		{
+			removedItems.Add(pair.Key);
+		}
+	}
+	RemoveGroupOfItems(removedItems);
+
+	for (const auto& pair : entries)
+	{
+		const int32 difference = pair.Value - GetQuantityFor(pair.Key);
+		if (difference != 0)
+		{
+			ModifyEntry(FInventoryEntry(pair.Key, difference));
+		}
+	}
+}
+
+const FInventoryStateHash& UInventory::GetStateHash() const
+{
+	return StateHash;
+}
+
+void UInventory::GetEntriesInBuckets(uint32 bucketMask, TArray<FInventoryEntry>& outEntries) const
+{
+	outEntries.Reset();
+	for (const auto& pair : InventoryEntries)
+	{
+		if (bucketMask & (1u << FInventoryStateHash::GetBucketFor(pair.Key)))
+		{
+			outEntries.Emplace(pair.Key, pair.Value);
+		}
+	}
+}
+
+void UInventory::ReplaceBuckets(uint32 bucketMask, const TArray<FInventoryEntry>& entries)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
+	TArray<FInventoryEntry> targetEntries;
+	TSet<FName> targetItems;
+	for (const FInventoryEntry& entry : entries)
+	{
+		if (bucketMask & (1u << FInventoryStateHash::GetBucketFor(entry.ItemCode)))
+		{
+			targetEntries.Add(entry);
+			targetItems.Add(entry.ItemCode);
+		}
+	}
+
+	TArray<FName> removedItems;
+	for (const auto& pair : InventoryEntries)
+	{
+		if ((bucketMask & (1u << FInventoryStateHash::GetBucketFor(pair.Key))) && !targetItems.Contains(pair.Key))
+		{
+			removedItems.Add(pair.Key);
+		}
+	}
+	RemoveGroupOfItems(removedItems);
+
+	SetQuantities(targetEntries);
+}
+
+void UInventory::SetQuantities(const TArray<FInventoryEntry>& entries)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryBatchScope batchScope(this);
+
+	for (const FInventoryEntry& entry : entries)
+	{
+		if (entry.Quantity <= 0)
+		{
+			RemoveItem(entry.ItemCode);
+			continue;
+		}
+
+		const int32 difference = entry.Quantity - GetQuantityFor(entry.ItemCode);
+		if (difference != 0)
+		{
+			ModifyEntry(FInventoryEntry(entry.ItemCode, difference));
+		}
+	}
+}
+
+FInventoryMemoryUsage UInventory::GetMemoryUsage() const
+{
+	FInventoryMemoryUsage usage;
+	usage.NumEntries = InventoryEntries.Num();
+
+	SIZE_T indexBytes = InstanceData.GetAllocatedSize() + TagIndex.GetAllocatedSize() + PendingChanges.GetAllocatedSize() + Snapshots.GetAllocatedSize() + SortedViews.GetAllocatedSize()
+		+ Expiries.GetAllocatedSize();
+	for (const FInventorySortedView& view : SortedViews)
+	{
+		indexBytes += view.GetAllocatedSize();
+	}
+	usage.AllocatedBytes = InventoryEntries.GetAllocatedSize() + indexBytes;
+	usage.UsedBytes = InventoryMemory::GetUsedSize(InventoryEntries) + indexBytes;
+	return usage;
+}
+
+void UInventory::Shrink()
+{
+	check(BatchDepth == 0);
+
+	InventoryEntries.Compact();
+	InventoryEntries.Shrink();
+	InstanceData.Shrink();
+	TagIndex.Shrink();
+	PendingChanges.Shrink();
+}
+
+void UInventory::CommitBatch()
+{
+	Snapshots.Publish();
+
+	if (FInventoryVerifier::ShouldSample())
+	{
+		FInventoryVerificationSample sample;
+		sample.Context = GetPathName();
+		sample.Entries.Reserve(InventoryEntries.Num());
+		for (const auto& pair : InventoryEntries)
+		{
+			sample.Entries.Emplace(pair.Key, pair.Value);
+		}
+		sample.Snapshot = Snapshots.GetLatest();
+		FInventoryVerifier::Get().Submit(MoveTemp(sample));
+	}
+}
+
+void UInventory::EnableSnapshots()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	Snapshots.EnableFrom([this](auto&& addEntry)
+	{
+		for (const auto& pair : InventoryEntries)
+		{
+			addEntry(pair.Key, pair.Value);
+		}
+	});
+}
+
+FInventorySnapshotPtr UInventory::GetSnapshot() const
+{
+	return Snapshots.GetLatest();
+}
+
+bool UInventory::HasPendingChanges() const
+{
+	return PendingChanges.HasChanges();
+}
+
+void UInventory::ConsumeChanges(FInventoryChangeSet& outChangeSet)
+{
+	PendingChanges.Consume(outChangeSet);
+}
+
 int32 UInventory::GetQuantityFor(const FName itemCode) const
 {
 	return InventoryEntries.FindRef(itemCode);  // TODO: Default value should be 0 - check!
@@ -142,3 +386,179 @@ FString UInventory::ToString() const
 	s.Append(TEXT("}\n"));
 	return s;
 }
+
+bool UInventory::SetInstanceField(const FName itemCode, EInstanceDataField field, int32 value)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (!Contains(itemCode))
+	{
+		return false;
+	}
+
+	InstanceData.SetField(itemCode, field, value);
+	return true;
+}
+
+int32 UInventory::GetInstanceField(const FName itemCode, EInstanceDataField field) const
+{
+	return InstanceData.GetField(itemCode, field);
+}
+
+const FInventoryInstanceData* UInventory::FindInstanceData(const FName itemCode) const
+{
+	return InstanceData.Find(itemCode);
+}
+
+FInventoryInstanceStore& UInventory::GetInstanceStore()
+{
+	return InstanceData;
+}
+
+int32 UInventory::CountItemsWithTag(const FName tag) const
+{
+	return TagIndex.CountItemsWithTag(tag);
+}
+
+int64 UInventory::GetQuantityForTag(const FName tag) const
+{
+	return TagIndex.GetQuantityForTag(tag);
+}
+
+const TSet<FName>* UInventory::GetItemsWithTag(const FName tag) const
+{
+	return TagIndex.GetItemsWithTag(tag);
+}
+
+void UInventory::RebuildTagIndex()
+{
+	TagIndex.Rebuild(InventoryEntries);
+	for (FInventorySortedView& view : SortedViews)
+	{
+		view.Rebuild(InventoryEntries);
+	}
+}
+
+void UInventory::EnableSortedView(EInventorySortOrder order)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (GetSortedView(order) == nullptr)
+	{
+		SortedViews.Emplace_GetRef(order).Rebuild(InventoryEntries);
+	}
+}
+
+void UInventory::DisableSortedView(EInventorySortOrder order)
+{
+	SortedViews.RemoveAll([order](const FInventorySortedView& view) { return view.GetOrder() == order; });
+}
+
+const FInventorySortedView* UInventory::GetSortedView(EInventorySortOrder order) const
+{
+	return SortedViews.FindByPredicate([order](const FInventorySortedView& view) { return view.GetOrder() == order; });
+}
+
+TArray<FInventoryEntry> UInventory::GetSortedPage(EInventorySortOrder order, int32 pageIndex, int32 pageSize) const
+{
+	TArray<FInventoryEntry> page;
+	if (const FInventorySortedView* view = GetSortedView(order))
+	{
+		view->GetPage(pageIndex, pageSize, page);
+	}
+	return page;
+}
+
+int32 UInventory::GetSortedRank(EInventorySortOrder order, const FName itemCode) const
+{
+	const FInventorySortedView* view = GetSortedView(order);
+	return view ? view->GetRank(itemCode) : INDEX_NONE;
+}
+
+void UInventory::PostDuplicate(bool bDuplicateForPIE)
+{
+	Super::PostDuplicate(bDuplicateForPIE);
+	RebuildTagIndex();  // Only the entry map is duplicated
+	StateHash.Rebuild(InventoryEntries);
+}
+
+bool UInventory::JoinAggregateView(const FName view)
+{
+	UInventoryAggregateSubsystem* aggregates = UInventoryAggregateSubsystem::Get(this);
+	return aggregates != nullptr && Aggregates.Join(aggregates->GetViews(), view, [this](auto&& addEntry)
+	{
+		for (const auto& pair : InventoryEntries)
+		{
+			addEntry(pair.Key, pair.Value);
+		}
+	});
+}
+
+bool UInventory::LeaveAggregateView(const FName view)
+{
+	return Aggregates.Leave(view, [this](auto&& removeEntry)
+	{
+		for (const auto& pair : InventoryEntries)
+		{
+			removeEntry(pair.Key, pair.Value);
+		}
+	});
+}
+
+void UInventory::LeaveAllAggregateViews()
+{
+	Aggregates.LeaveAll([this](auto&& removeEntry)
+	{
+		for (const auto& pair : InventoryEntries)
+		{
+			removeEntry(pair.Key, pair.Value);
+		}
+	});
+}
+
+bool UInventory::SetItemExpiry(const FName itemCode, float lifetimeSeconds)
+{
+	if (!Contains(itemCode))
+	{
+		return false;
+	}
+
+	return Expiries.Set(GetExpiryOwner(), itemCode, lifetimeSeconds);
+}
+
+bool UInventory::ClearItemExpiry(const FName itemCode)
+{
+	return Expiries.Clear(itemCode);
+}
+
+float UInventory::GetItemLifetimeRemaining(const FName itemCode) const
+{
+	return Expiries.GetLifetimeRemaining(itemCode);
+}
+
+void UInventory::ClearAllItemExpiries()
+{
+	Expiries.ClearAll();
+}
+
+void UInventory::GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const
+{
+	Expiries.GetExpiries(outExpiries);
+}
+
+void UInventory::RestoreItemExpiries(const TArray<FInventoryItemExpiry>& expiries)
+{
+	TArray<FInventoryItemExpiry> held = expiries.FilterByPredicate([this](const FInventoryItemExpiry& expiry) { return Contains(expiry.ItemCode); });
+	Expiries.Restore(GetExpiryOwner(), held);
+}
+
+UObject* UInventory::GetExpiryOwner()
+{
+	return GetOuter() && GetOuter()->GetClass()->ImplementsInterface(UInventoryInterface::StaticClass()) ? GetOuter() : this;
+}
+
+void UInventory::BeginDestroy()
+{
+	LeaveAllAggregateViews();
+	ClearAllItemExpiries();
+	InstanceData.Reset();  // Free every instance payload in one go
+	Super::BeginDestroy();
+}
@@ -6,9 +6,20 @@
 #include "UObject/NoExportTypes.h"
 #include "Enums.h"
 #include "Structs.h"
+#include "InventoryInstanceData.h"
+#include "InventoryTagIndex.h"
+#include "InventoryChanges.h"
+#include "InventorySnapshot.h"
+#include "InventoryStateHash.h"
+#include "InventoryMemory.h"
+#include "InventorySortedView.h"
+#include "InventoryAggregates.h"
+#include "InventoryExpirySubsystem.h"
 #include "Templates/Tuple.h"
 #include "Inventory.generated.h"
 
+DECLARE_MULTICAST_DELEGATE(FOnInventoryChangesPending);
+
 /**
  * 
  */
@@ -22,9 +33,39 @@ private:
 	UPROPERTY()
 		TMap<FName, int32> InventoryEntries;
 
+	FInventoryInstanceStore InstanceData;
+
+	FInventoryTagIndex TagIndex;
+
+	FInventoryChangeAccumulator PendingChanges;
+
+	FInventorySnapshotPublisher Snapshots;
+
+	FInventoryStateHash StateHash;
+
+	TArray<FInventorySortedView> SortedViews;
+
+	FInventoryAggregateMembership Aggregates;
+
+	FInventoryExpiryTracker Expiries;
+
+	friend class FInventoryBatchScope;
+
+	// Nesting depth of mutating calls; the outermost one commits the batch
+	int32 BatchDepth;
+
+	void CommitBatch();
+
+	ERemovalStatus RemoveEntry(const FName itemCode, int32 previousQuantity);
+
+	// What expired items are removed through: the outer component when it implements IInventoryInterface
+	UObject* GetExpiryOwner();
+
+	void OnEntryChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity);
+
 public:
-	UInventory() : InventoryEntries(TMap<FName, int32>()) {}
-	UInventory(const TMap<FName, int32>& entries) : InventoryEntries(entries) {}
+	UInventory() : InventoryEntries(TMap<FName, int32>()), BatchDepth(0) {}
+	UInventory(const TMap<FName, int32>& entries) : InventoryEntries(entries), BatchDepth(0) {}
 
 	//UFUNCTION(Category = "Networked Inventory")  // FIXME: Unrecognised type 'TTuple' - type must be a UCLASS, USTRUCT, or UENUM
 		TTuple<EChangeGroupStatus, TArray<EChangeStatus>> ModifyGroupOfEntries(const TArray<FInventoryEntry>& inventoryChanges);
@@ -58,4 +99,110 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
 		FString ToString() const;
+
+	UFUNCTION(Category = "Networked Inventory")
+		bool SetInstanceField(const FName itemCode, EInstanceDataField field, int32 value);
+
+	UFUNCTION(Category = "Networked Inventory")
+		int32 GetInstanceField(const FName itemCode, EInstanceDataField field) const;
+
+	const FInventoryInstanceData* FindInstanceData(const FName itemCode) const;
+
+	FInventoryInstanceStore& GetInstanceStore();
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 CountItemsWithTag(const FName tag) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int64 GetQuantityForTag(const FName tag) const;
+
+	const TSet<FName>* GetItemsWithTag(const FName tag) const;
+
+	// Only needed if item tags are registered after the inventory already holds items. Also rebuilds sorted views.
+	UFUNCTION(Category = "Networked Inventory")
+		void RebuildTagIndex();
+
+	// Keeps the entries sorted in this order from now on, so UI paging never re-sorts. Game thread only.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void EnableSortedView(EInventorySortOrder order);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void DisableSortedView(EInventorySortOrder order);
+
+	// Null unless the view is enabled
+	const FInventorySortedView* GetSortedView(EInventorySortOrder order) const;
+
+	// Empty unless the view is enabled
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		TArray<FInventoryEntry> GetSortedPage(EInventorySortOrder order, int32 pageIndex, int32 pageSize) const;
+
+	// INDEX_NONE unless the view is enabled and the item is held
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 GetSortedRank(EInventorySortOrder order, const FName itemCode) const;
+
+	// Counts this inventory towards a view registered with UInventoryAggregateSubsystem. False if the view is not
+	// registered or already joined.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		bool JoinAggregateView(const FName view);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		bool LeaveAggregateView(const FName view);
+
+	void LeaveAllAggregateViews();
+
+	// The stack is removed through the outer component when it implements IInventoryInterface, so the removal reaches
+	// its client. False if the item is not held.
+	UFUNCTION(Category = "Networked Inventory|Expiry")
+		bool SetItemExpiry(const FName itemCode, float lifetimeSeconds);
+
+	UFUNCTION(Category = "Networked Inventory|Expiry")
+		bool ClearItemExpiry(const FName itemCode);
+
+	// Negative if the item does not expire
+	UFUNCTION(Category = "Networked Inventory|Expiry")
+		float GetItemLifetimeRemaining(const FName itemCode) const;
+
+	void ClearAllItemExpiries();
+
+	void GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const;
+
+	// Expiries of items no longer held are skipped
+	void RestoreItemExpiries(const TArray<FInventoryItemExpiry>& expiries);
+
+	virtual void PostDuplicate(bool bDuplicateForPIE) override;
+
+	UFUNCTION(Category = "Networked Inventory")
+		void SetEntries(const TMap<FName, int32>& entries);
+
+	// Fired when the first change since the last ConsumeChanges() is recorded
+	FOnInventoryChangesPending OnChangesPending;
+
+	bool HasPendingChanges() const;
+
+	void ConsumeChanges(FInventoryChangeSet& outChangeSet);
+
+	// Starts publishing a read-only snapshot after every committed batch. Game thread only.
+	UFUNCTION(Category = "Networked Inventory")
+		void EnableSnapshots();
+
+	// Latest committed state, safe to read from any thread. Null until snapshots are enabled.
+	FInventorySnapshotPtr GetSnapshot() const;
+
+	const FInventoryStateHash& GetStateHash() const;
+
+	// Entries whose item falls in one of the buckets set in the mask (see FInventoryStateHash)
+	void GetEntriesInBuckets(uint32 bucketMask, TArray<FInventoryEntry>& outEntries) const;
+
+	// Sets absolute quantities for the listed items; zero removes
+	void SetQuantities(const TArray<FInventoryEntry>& entries);
+
+	// Makes the masked buckets hold exactly the given entries, leaving the others untouched
+	void ReplaceBuckets(uint32 bucketMask, const TArray<FInventoryEntry>& entries);
+
+	FInventoryMemoryUsage GetMemoryUsage() const;
+
+	// Compacts the containers, e.g. after a bulk removal. Not allowed inside a batch.
+	void Shrink();
+
+	virtual void BeginDestroy() override;
 };
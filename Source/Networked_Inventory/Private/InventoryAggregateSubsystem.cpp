@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryAggregateSubsystem.h"
+#include "Engine/World.h"
+#include "Containers/Ticker.h"
+
+UInventoryAggregateSubsystem* UInventoryAggregateSubsystem::Get(const UObject* worldContextObject)
+{
+	const UWorld* world = worldContextObject ? worldContextObject->GetWorld() : nullptr;
+	return world ? world->GetSubsystem<UInventoryAggregateSubsystem>() : nullptr;
+}
+
+void UInventoryAggregateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Views = MakeShared<FInventoryAggregateViews, ESPMode::ThreadSafe>();
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UInventoryAggregateSubsystem::Tick));
+}
+
+void UInventoryAggregateSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	Views.Reset();
+
+	Super::Deinitialize();
+}
+
+void UInventoryAggregateSubsystem::RegisterView(const FName view)
+{
+	Views->RegisterView(view);
+}
+
+int64 UInventoryAggregateSubsystem::GetItemTotal(const FName view, const FName itemCode) const
+{
+	return Views->GetTotal(Views->FindView(view), itemCode).Quantity;
+}
+
+int32 UInventoryAggregateSubsystem::GetHolderCount(const FName view, const FName itemCode) const
+{
+	return Views->GetTotal(Views->FindView(view), itemCode).Holders;
+}
+
+const TMap<FName, FInventoryAggregateTotal>* UInventoryAggregateSubsystem::GetTotals(const FName view) const
+{
+	return Views->GetTotals(Views->FindView(view));
+}
+
+const FInventoryAggregateViewsPtr& UInventoryAggregateSubsystem::GetViews() const
+{
+	return Views;
+}
+
+bool UInventoryAggregateSubsystem::Tick(float deltaTime)
+{
+	Views->Merge();
+	return true;
+}
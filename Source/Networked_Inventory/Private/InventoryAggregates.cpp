@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryAggregates.h"
+#include "InventoryMemory.h"
+#include "HAL/PlatformTLS.h"
+
+int32 FInventoryAggregateViews::RegisterView(const FName view)
+{
+	check(IsInGameThread());
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+
+	const int32 existing = ViewNames.Find(view);
+	if (existing != INDEX_NONE)
+	{
+		return existing;
+	}
+
+	Totals.AddDefaulted();
+	return ViewNames.Add(view);
+}
+
+int32 FInventoryAggregateViews::FindView(const FName view) const
+{
+	return ViewNames.Find(view);
+}
+
+void FInventoryAggregateViews::Record(int32 viewId, const FName itemCode, int64 quantityDelta, int32 holderDelta)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (IsInGameThread())
+	{
+		FInventoryAggregateTotal& delta = GameThreadDeltas.FindOrAdd(FViewItemKey(viewId, itemCode));
+		delta.Quantity += quantityDelta;
+		delta.Holders += holderDelta;
+		return;
+	}
+
+	const uint32 threadId = FPlatformTLS::GetCurrentThreadId();
+	FPartialSums* partials = nullptr;
+	{
+		FRWScopeLock readLock(WorkerPartialsLock, SLT_ReadOnly);
+		if (const TUniquePtr<FPartialSums>* found = WorkerPartials.Find(threadId))
+		{
+			partials = found->Get();
+		}
+	}
+
+	if (partials == nullptr)
+	{
+		FRWScopeLock writeLock(WorkerPartialsLock, SLT_Write);
+		TUniquePtr<FPartialSums>& slot = WorkerPartials.FindOrAdd(threadId);
+		if (!slot.IsValid())
+		{
+			slot = MakeUnique<FPartialSums>();
+		}
+		partials = slot.Get();
+	}
+
+	// Only contended while Merge() takes this thread's sums
+	FScopeLock lock(&partials->Lock);
+	FInventoryAggregateTotal& delta = partials->Deltas.FindOrAdd(FViewItemKey(viewId, itemCode));
+	delta.Quantity += quantityDelta;
+	delta.Holders += holderDelta;
+}
+
+void FInventoryAggregateViews::Merge()
+{
+	check(IsInGameThread());
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+
+	Apply(GameThreadDeltas);
+	GameThreadDeltas.Reset();
+
+	TMap<FViewItemKey, FInventoryAggregateTotal> deltas;
+	FRWScopeLock readLock(WorkerPartialsLock, SLT_ReadOnly);
+	for (auto& pair : WorkerPartials)
+	{
+		{
+			FScopeLock lock(&pair.Value->Lock);
+			if (pair.Value->Deltas.Num() == 0)
+			{
+				continue;
+			}
+			Swap(deltas, pair.Value->Deltas);
+		}
+		Apply(deltas);
+		deltas.Reset();
+	}
+}
+
+void FInventoryAggregateViews::Apply(const TMap<FViewItemKey, FInventoryAggregateTotal>& deltas)
+{
+	for (const auto& pair : deltas)
+	{
+		const int32 viewId = pair.Key.Get<0>();
+		if (!Totals.IsValidIndex(viewId) || (pair.Value.Quantity == 0 && pair.Value.Holders == 0))
+		{
+			continue;
+		}
+
+		const FName itemCode = pair.Key.Get<1>();
+		FInventoryAggregateTotal& total = Totals[viewId].FindOrAdd(itemCode);
+		total.Quantity += pair.Value.Quantity;
+		total.Holders += pair.Value.Holders;
+		if (total.Quantity == 0 && total.Holders == 0)
+		{
+			Totals[viewId].Remove(itemCode);
+		}
+	}
+}
+
+FInventoryAggregateTotal FInventoryAggregateViews::GetTotal(int32 viewId, const FName itemCode) const
+{
+	const FInventoryAggregateTotal* total = Totals.IsValidIndex(viewId) ? Totals[viewId].Find(itemCode) : nullptr;
+	return total ? *total : FInventoryAggregateTotal();
+}
+
+const TMap<FName, FInventoryAggregateTotal>* FInventoryAggregateViews::GetTotals(int32 viewId) const
+{
+	return Totals.IsValidIndex(viewId) ? &Totals[viewId] : nullptr;
+}
+
+SIZE_T FInventoryAggregateViews::GetAllocatedSize() const
+{
+	SIZE_T size = ViewNames.GetAllocatedSize() + Totals.GetAllocatedSize() + GameThreadDeltas.GetAllocatedSize();
+	for (const TMap<FName, FInventoryAggregateTotal>& totals : Totals)
+	{
+		size += totals.GetAllocatedSize();
+	}
+
+	FRWScopeLock readLock(WorkerPartialsLock, SLT_ReadOnly);
+	size += WorkerPartials.GetAllocatedSize();
+	for (const auto& pair : WorkerPartials)
+	{
+		FScopeLock lock(&pair.Value->Lock);
+		size += sizeof(FPartialSums) + pair.Value->Deltas.GetAllocatedSize();
+	}
+	return size;
+}
+
+void FInventoryAggregateMembership::OnQuantityChanged(const FName itemCode, int64 oldQuantity, int64 newQuantity)
+{
+	if (ViewIds.Num() == 0)
+	{
+		return;
+	}
+
+	oldQuantity = FMath::Max<int64>(oldQuantity, 0);
+	newQuantity = FMath::Max<int64>(newQuantity, 0);
+	const int32 holderDelta = (newQuantity > 0 ? 1 : 0) - (oldQuantity > 0 ? 1 : 0);
+	for (int32 viewId : ViewIds)
+	{
+		Views->Record(viewId, itemCode, newQuantity - oldQuantity, holderDelta);
+	}
+}
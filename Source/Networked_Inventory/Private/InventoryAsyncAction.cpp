@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryAsyncAction.h"
+#include "InventoryInterface.h"
+
+UInventoryModifyAsyncAction* UInventoryModifyAsyncAction::ModifyInventoryAsync(UObject* inventory, const TArray<FInventoryEntry>& inventoryChanges)
+{
+	UInventoryModifyAsyncAction* action = NewObject<UInventoryModifyAsyncAction>();
+	action->Inventory = inventory;
+	action->Changes = inventoryChanges;
+	if (inventory != nullptr)
+	{
+		action->RegisterWithGameInstance(inventory);
+	}
+	return action;
+}
+
+void UInventoryModifyAsyncAction::Activate()
+{
+	IInventoryInterface* inventory = Cast<IInventoryInterface>(Inventory);
+	if (inventory == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Modify Inventory Async needs an object implementing IInventoryInterface."));
+		FInventoryRequestResult result;
+		result.Outcome = EInventoryRequestOutcome::Rejected;
+		result.GroupStatus = EChangeGroupStatus::SomeChangesLost;
+		OnAnswered(result);
+		return;
+	}
+
+	TWeakObjectPtr<UInventoryModifyAsyncAction> weakThis = this;
+	inventory->ModifyInventoryAsync(Changes).Next([weakThis](const FInventoryRequestResult& result)
+	{
+		if (weakThis.IsValid())
+		{
+			weakThis->OnAnswered(result);
+		}
+	});
+}
+
+void UInventoryModifyAsyncAction::OnAnswered(const FInventoryRequestResult& result)
+{
+	if (result.Outcome == EInventoryRequestOutcome::Committed)
+	{
+		OnCommitted.Broadcast(result);
+	}
+	else
+	{
+		OnFailed.Broadcast(result);
+	}
+	SetReadyToDestroy();
+}
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryBandwidthSubsystem.h"
+#include "InventoryRateLimitSettings.h"
+#include "Engine/World.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformTime.h"
+#include "InventoryMemory.h"
+
+bool FInventorySendQueue::Enqueue(const UObject* sender, FName channel, EInventorySendPriority priority, double now, TFunction<int32()> send)
+{
+	for (FInventoryQueuedSend& queued : Sends)
+	{
+		if (queued.Sender.Get() == sender && queued.Channel == channel)
+		{
+			queued.Priority = FMath::Min(queued.Priority, priority);
+			return true;
+		}
+	}
+
+	FInventoryQueuedSend& queued = Sends.AddDefaulted_GetRef();
+	queued.Sender = sender;
+	queued.Channel = channel;
+	queued.Priority = priority;
+	queued.EnqueueTime = now;
+	queued.Send = MoveTemp(send);
+	return false;
+}
+
+bool FInventorySendQueue::Pop(FInventoryQueuedSend& outSend)
+{
+	if (Sends.Num() == 0)
+	{
+		return false;
+	}
+
+	// Sends are kept in arrival order, so the first of the most urgent is also the oldest
+	int32 next = 0;
+	for (int32 i = 1; i < Sends.Num(); i++)
+	{
+		if (Sends[i].Priority < Sends[next].Priority)
+		{
+			next = i;
+		}
+	}
+
+	outSend = MoveTemp(Sends[next]);
+	Sends.RemoveAt(next, 1, false);
+	return true;
+}
+
+int32 FInventorySendQueue::Num() const
+{
+	return Sends.Num();
+}
+
+UInventoryBandwidthSubsystem* UInventoryBandwidthSubsystem::Get(const UObject* worldContextObject)
+{
+	const UWorld* world = worldContextObject ? worldContextObject->GetWorld() : nullptr;
+	return world ? world->GetSubsystem<UInventoryBandwidthSubsystem>() : nullptr;
+}
+
+void UInventoryBandwidthSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TotalLatencySeconds = 0.0;
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UInventoryBandwidthSubsystem::Tick));
+}
+
+void UInventoryBandwidthSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	Connections.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UInventoryBandwidthSubsystem::Enqueue(const UObject* connection, const UObject* sender, FName channel, EInventorySendPriority priority, TFunction<int32()> send)
+{
+	if (!GetDefault<UInventoryRateLimitSettings>()->bScheduleOutgoingTraffic || connection == nullptr)
+	{
+		return false;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FConnectionQueue& queue = Connections.FindOrAdd(connection);
+	if (queue.Sends.Enqueue(sender, channel, priority, FPlatformTime::Seconds(), MoveTemp(send)))
+	{
+		Stats.MergedSends++;
+	}
+	Stats.MaxQueueDepth = FMath::Max(Stats.MaxQueueDepth, queue.Sends.Num());
+	return true;
+}
+
+bool UInventoryBandwidthSubsystem::Tick(float deltaTime)
+{
+	const UInventoryRateLimitSettings* settings = GetDefault<UInventoryRateLimitSettings>();
+	const double now = FPlatformTime::Seconds();
+
+	TArray<TWeakObjectPtr<const UObject>> connections;
+	Connections.GenerateKeyArray(connections);
+
+	for (const TWeakObjectPtr<const UObject>& connection : connections)
+	{
+		if (!connection.IsValid())
+		{
+			Connections.Remove(connection);
+			continue;
+		}
+
+		FConnectionQueue* queue = Connections.Find(connection);
+		queue->Bytes.Refill(settings->OutgoingBytesPerSecond, settings->OutgoingBurstBytes, now);
+
+		FInventoryQueuedSend send;
+		while (queue->Bytes.Tokens > 0.0 && queue->Sends.Pop(send))
+		{
+			const int32 numBytes = send.Sender.IsValid() ? send.Send() : 0;
+
+			// The send may have queued more traffic, moving the map's elements
+			queue = Connections.Find(connection);
+			queue->Bytes.Tokens -= numBytes;
+
+			const double latency = now - send.EnqueueTime;
+			TotalLatencySeconds += latency;
+			Stats.SentSends++;
+			Stats.SentBytes += numBytes;
+			Stats.MaxLatencyMs = FMath::Max(Stats.MaxLatencyMs, (float)(latency * 1000.0));
+		}
+	}
+
+	return true;
+}
+
+FInventoryBandwidthStats UInventoryBandwidthSubsystem::GetStats() const
+{
+	FInventoryBandwidthStats stats = Stats;
+	stats.QueuedSends = 0;
+	for (const auto& pair : Connections)
+	{
+		stats.QueuedSends += pair.Value.Sends.Num();
+	}
+	stats.AverageLatencyMs = Stats.SentSends > 0 ? (float)(TotalLatencySeconds * 1000.0 / Stats.SentSends) : 0.0f;
+	return stats;
+}
+
+void UInventoryBandwidthSubsystem::ResetStats()
+{
+	Stats = FInventoryBandwidthStats();
+	TotalLatencySeconds = 0.0;
+}
+
+int32 UInventoryBandwidthSubsystem::GetQueueDepth(const UObject* connection) const
+{
+	const FConnectionQueue* queue = Connections.Find(connection);
+	return queue ? queue->Sends.Num() : 0;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryChanges.h"
+
+bool FInventoryChangeAccumulator::Record(const FName itemCode, int32 oldQuantity, int32 newQuantity)
+{
+	const bool bFirstChange = PendingChanges.Num() == 0;
+
+	if (TPair<int32, int32>* pending = PendingChanges.Find(itemCode))
+	{
+		pending->Value = newQuantity;
+	}
+	else
+	{
+		PendingChanges.Add(itemCode, TPair<int32, int32>(oldQuantity, newQuantity));
+	}
+
+	return bFirstChange;
+}
+
+bool FInventoryChangeAccumulator::HasChanges() const
+{
+	return PendingChanges.Num() > 0;
+}
+
+void FInventoryChangeAccumulator::Consume(FInventoryChangeSet& outChangeSet)
+{
+	for (const auto& pair : PendingChanges)
+	{
+		const int32 oldQuantity = FMath::Max(pair.Value.Key, 0);
+		const int32 newQuantity = FMath::Max(pair.Value.Value, 0);
+
+		if (oldQuantity == newQuantity)
+		{
+			continue;  // Changed and changed back within the same frame
+		}
+		else if (oldQuantity == 0)
+		{
+			outChangeSet.Added.Emplace(pair.Key, 0, newQuantity);
+		}
+		else if (newQuantity == 0)
+		{
+			outChangeSet.Removed.Add(pair.Key);
+		}
+		else
+		{
+			outChangeSet.Changed.Emplace(pair.Key, oldQuantity, newQuantity);
+		}
+	}
+
+	PendingChanges.Reset();
+}
+
+SIZE_T FInventoryChangeAccumulator::GetAllocatedSize() const
+{
+	return PendingChanges.GetAllocatedSize();
+}
+
+void FInventoryChangeAccumulator::Shrink()
+{
+	PendingChanges.Compact();
+	PendingChanges.Shrink();
+}
@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryCounters.h"
+#include "InventoryItemRegistry.h"
+#include "InventoryMemory.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+void FInventoryCounterSet::Add(const FName itemCode, int64 delta)
+{
+	FCounter& counter = FindOrAddCounter(itemCode);
+
+	// Saturate rather than wrap
+	if (delta > 0)
+	{
+		counter.Value = counter.Value > MAX_int64 - delta ? MAX_int64 : counter.Value + delta;
+	}
+	else
+	{
+		counter.Value = FMath::Max<int64>(counter.Value + delta, 0);
+	}
+
+	MarkDirty(counter);
+}
+
+void FInventoryCounterSet::Set(const FName itemCode, int64 value)
+{
+	FCounter& counter = FindOrAddCounter(itemCode);
+	counter.Value = FMath::Max<int64>(value, 0);
+	MarkDirty(counter);
+}
+
+int64 FInventoryCounterSet::GetValue(const FName itemCode) const
+{
+	const FCounter* counter = Counters.Find(itemCode);
+	return counter ? counter->Value : 0;
+}
+
+double FInventoryCounterSet::GetDisplayValue(const FName itemCode, double now) const
+{
+	const FCounter* counter = Counters.Find(itemCode);
+	if (counter == nullptr)
+	{
+		return 0.0;
+	}
+
+	const double elapsed = now - counter->StartTime;
+	if (counter->InterpolationSeconds <= 0.0 || elapsed >= counter->InterpolationSeconds)
+	{
+		return (double)counter->Value;
+	}
+
+	return FMath::Lerp(counter->StartValue, (double)counter->Value, FMath::Max(elapsed, 0.0) / counter->InterpolationSeconds);
+}
+
+bool FInventoryCounterSet::HasDirty() const
+{
+	return NumDirty > 0;
+}
+
+bool FInventoryCounterSet::IsDirty(const FName itemCode) const
+{
+	const FCounter* counter = Counters.Find(itemCode);
+	return counter != nullptr && counter->bDirty;
+}
+
+double FInventoryCounterSet::GetSecondsUntilDue(double now) const
+{
+	if (NumDirty == 0)
+	{
+		return -1.0;
+	}
+
+	double secondsUntilDue = DBL_MAX;
+	for (const auto& pair : Counters)
+	{
+		if (pair.Value.bDirty)
+		{
+			secondsUntilDue = FMath::Min(secondsUntilDue, pair.Value.LastSentTime + pair.Value.MinSendInterval - now);
+		}
+	}
+	return FMath::Max(secondsUntilDue, 0.0);
+}
+
+bool FInventoryCounterSet::ConsumeDue(double now, TArray<FInventoryCounterValue>& outValues)
+{
+	const int32 numValues = outValues.Num();
+	for (auto& pair : Counters)
+	{
+		FCounter& counter = pair.Value;
+		if (counter.bDirty && now - counter.LastSentTime >= counter.MinSendInterval)
+		{
+			outValues.Emplace(pair.Key, counter.Value);
+			counter.LastSentTime = now;
+			counter.bDirty = false;
+			NumDirty--;
+		}
+	}
+	return outValues.Num() > numValues;
+}
+
+void FInventoryCounterSet::MarkAllDirty()
+{
+	for (auto& pair : Counters)
+	{
+		MarkDirty(pair.Value);
+	}
+}
+
+void FInventoryCounterSet::ApplyReplicated(const TArray<FInventoryCounterValue>& values, double now)
+{
+	for (const FInventoryCounterValue& value : values)
+	{
+		const FCounter* existing = Counters.Find(value.ItemCode);
+		if (existing && existing->Value == value.Value)
+		{
+			continue;
+		}
+
+		const double displayValue = GetDisplayValue(value.ItemCode, now);
+		FCounter& counter = FindOrAddCounter(value.ItemCode);
+		counter.StartValue = displayValue;
+		counter.StartTime = now;
+		counter.Value = value.Value;
+	}
+}
+
+void FInventoryCounterSet::GetValues(TArray<FInventoryCounterValue>& outValues) const
+{
+	outValues.Reset(Counters.Num());
+	for (const auto& pair : Counters)
+	{
+		outValues.Emplace(pair.Key, pair.Value.Value);
+	}
+}
+
+int32 FInventoryCounterSet::Num() const
+{
+	return Counters.Num();
+}
+
+SIZE_T FInventoryCounterSet::GetAllocatedSize() const
+{
+	return Counters.GetAllocatedSize();
+}
+
+FInventoryCounterSet::FCounter& FInventoryCounterSet::FindOrAddCounter(const FName itemCode)
+{
+	if (FCounter* counter = Counters.Find(itemCode))
+	{
+		return *counter;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	const FInventoryCounterPolicy* policy = FInventoryItemRegistry::Get().GetCounterPolicy(itemCode);
+	const FInventoryCounterPolicy effectivePolicy = policy ? *policy : FInventoryCounterPolicy();
+
+	FCounter& counter = Counters.Add(itemCode);
+	counter.MinSendInterval = effectivePolicy.MaxUpdatesPerSecond > 0.0f ? 1.0 / effectivePolicy.MaxUpdatesPerSecond : 0.0;
+	counter.InterpolationSeconds = effectivePolicy.InterpolationSeconds;
+	return counter;
+}
+
+void FInventoryCounterSet::MarkDirty(FCounter& counter)
+{
+	if (!counter.bDirty)
+	{
+		counter.bDirty = true;
+		NumDirty++;
+	}
+}
+
+void FInventoryCounterReplicator::Initialize(UActorComponent* owner, FSendFunction send, FChangedFunction onChanged)
+{
+	Owner = owner;
+	Send = MoveTemp(send);
+	OnChanged = MoveTemp(onChanged);
+}
+
+bool FInventoryCounterReplicator::Add(const FName itemCode, int64 delta)
+{
+	if (!CanChange(itemCode))
+	{
+		return false;
+	}
+
+	const int64 oldValue = Counters.GetValue(itemCode);
+	Counters.Add(itemCode, delta);
+	if (OnChanged)
+	{
+		OnChanged(itemCode, oldValue, Counters.GetValue(itemCode));
+	}
+	ScheduleFlush();
+	return true;
+}
+
+bool FInventoryCounterReplicator::Set(const FName itemCode, int64 value)
+{
+	if (!CanChange(itemCode))
+	{
+		return false;
+	}
+
+	const int64 oldValue = Counters.GetValue(itemCode);
+	Counters.Set(itemCode, value);
+	if (OnChanged)
+	{
+		OnChanged(itemCode, oldValue, Counters.GetValue(itemCode));
+	}
+	ScheduleFlush();
+	return true;
+}
+
+void FInventoryCounterReplicator::SetAll(const TArray<FInventoryCounterValue>& values)
+{
+	TArray<FInventoryCounterValue> current;
+	Counters.GetValues(current);
+	for (const FInventoryCounterValue& value : current)
+	{
+		if (!values.ContainsByPredicate([&value](const FInventoryCounterValue& other) { return other.ItemCode == value.ItemCode; }))
+		{
+			Set(value.ItemCode, 0);
+		}
+	}
+
+	for (const FInventoryCounterValue& value : values)
+	{
+		Set(value.ItemCode, value.Value);
+	}
+}
+
+int64 FInventoryCounterReplicator::GetValue(const FName itemCode) const
+{
+	return Counters.GetValue(itemCode);
+}
+
+double FInventoryCounterReplicator::GetDisplayValue(const FName itemCode) const
+{
+	return Counters.GetDisplayValue(itemCode, FPlatformTime::Seconds());
+}
+
+void FInventoryCounterReplicator::GetValues(TArray<FInventoryCounterValue>& outValues) const
+{
+	Counters.GetValues(outValues);
+}
+
+bool FInventoryCounterReplicator::IsDirty(const FName itemCode) const
+{
+	return Counters.IsDirty(itemCode);
+}
+
+void FInventoryCounterReplicator::MarkAllDirty()
+{
+	Counters.MarkAllDirty();
+	ScheduleFlush();
+}
+
+void FInventoryCounterReplicator::Flush()
+{
+	UWorld* world = Owner.IsValid() ? Owner->GetWorld() : nullptr;
+	if (world != nullptr && FlushHandle.IsValid())
+	{
+		world->GetTimerManager().ClearTimer(FlushHandle);
+	}
+	FlushHandle.Invalidate();
+
+	TArray<FInventoryCounterValue> values;
+	if (Counters.ConsumeDue(FPlatformTime::Seconds(), values) && Send)
+	{
+		Send(values);
+	}
+
+	// Counters held back by their rate go out as soon as they are allowed to
+	if (Counters.HasDirty() && world != nullptr)
+	{
+		ScheduleFlush();
+	}
+}
+
+void FInventoryCounterReplicator::ApplyReplicated(const TArray<FInventoryCounterValue>& values)
+{
+	Counters.ApplyReplicated(values, FPlatformTime::Seconds());
+}
+
+SIZE_T FInventoryCounterReplicator::GetAllocatedSize() const
+{
+	return Counters.GetAllocatedSize();
+}
+
+bool FInventoryCounterReplicator::CanChange(const FName itemCode) const
+{
+	const AActor* actor = Owner.IsValid() ? Owner->GetOwner() : nullptr;
+	if (actor && actor->GetLocalRole() != ROLE_Authority)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Counters can only be changed on the server. Ignoring change to item %s."), *itemCode.ToString());
+		return false;
+	}
+	return true;
+}
+
+void FInventoryCounterReplicator::ScheduleFlush()
+{
+	UActorComponent* owner = Owner.Get();
+	UWorld* world = owner ? owner->GetWorld() : nullptr;
+	if (world == nullptr)
+	{
+		Flush();
+	}
+	else if (!FlushHandle.IsValid())
+	{
+		// Bound weakly to the component that owns this, so a timer outliving it does nothing
+		const FTimerDelegate flush = FTimerDelegate::CreateWeakLambda(owner, [this]() { Flush(); });
+
+		// Even counters that are due wait for the next tick, so every change made this frame goes out together
+		const double secondsUntilDue = Counters.GetSecondsUntilDue(FPlatformTime::Seconds());
+		if (secondsUntilDue > 0.0)
+		{
+			world->GetTimerManager().SetTimer(FlushHandle, flush, (float)secondsUntilDue, false);
+		}
+		else
+		{
+			FlushHandle = world->GetTimerManager().SetTimerForNextTick(flush);
+		}
+	}
+}
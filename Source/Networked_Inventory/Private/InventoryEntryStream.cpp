@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryEntryStream.h"
+#include "InventoryItemRegistry.h"
+#include "InventoryNetSerialization.h"
+#include "InventoryMemory.h"
+
+namespace
+{
+	// Reads claiming more changes than this are rejected
+	constexpr uint32 MaxEntriesPerDelta = 1 << 20;
+
+	// What one connection has been sent. Immutable once handed to the replication system.
+	class FInventoryEntryStreamBaseState : public INetDeltaBaseState, public TSharedFromThis<FInventoryEntryStreamBaseState>
+	{
+	public:
+		TMap<FName, int32> SentQuantities;
+
+		// The stream's ChangeKey when everything had been sent, otherwise zero
+		uint32 ChangeKey = 0;
+
+		virtual bool IsStateEqual(INetDeltaBaseState* otherState) override
+		{
+			const FInventoryEntryStreamBaseState* other = static_cast<FInventoryEntryStreamBaseState*>(otherState);
+			return ChangeKey == other->ChangeKey && SentQuantities.OrderIndependentCompareEqual(other->SentQuantities);
+		}
+	};
+}
+
+void FInventoryEntryStream::MarkChanged()
+{
+	ChangeKey = ChangeKey == MAX_uint32 ? 1 : ChangeKey + 1;
+}
+
+bool FInventoryEntryStream::ConsumePendingEntries()
+{
+	const bool bPending = bHasPendingEntries;
+	bHasPendingEntries = false;
+	return bPending;
+}
+
+bool FInventoryEntryStream::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (DeltaParms.Writer != nullptr)
+	{
+		return WriteDelta(DeltaParms);
+	}
+
+	if (DeltaParms.Reader != nullptr)
+	{
+		return ReadDelta(DeltaParms);
+	}
+
+	// Item codes are names, there are no object references to track
+	return false;
+}
+
+bool FInventoryEntryStream::WriteDelta(FNetDeltaSerializeInfo& DeltaParms)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryEntryStreamBaseState* oldState = static_cast<FInventoryEntryStreamBaseState*>(DeltaParms.OldState);
+	if (oldState != nullptr && oldState->ChangeKey == ChangeKey)
+	{
+		*DeltaParms.NewState = oldState->AsShared();
+		return false;
+	}
+
+	TSharedRef<FInventoryEntryStreamBaseState> newState = MakeShared<FInventoryEntryStreamBaseState>();
+	*DeltaParms.NewState = newState;
+	if (oldState != nullptr)
+	{
+		newState->SentQuantities = oldState->SentQuantities;
+	}
+	TMap<FName, int32>& sent = newState->SentQuantities;
+
+	TArray<const FInventoryEntry*> changed;
+	TArray<const FInventoryEntry*> changedLater;
+	TSet<FName> held;
+	held.Reserve(Entries.Num());
+	for (const FInventoryEntry& entry : Entries)
+	{
+		held.Add(entry.ItemCode);
+
+		const int32* sentQuantity = sent.Find(entry.ItemCode);
+		if (sentQuantity != nullptr && *sentQuantity == entry.Quantity)
+		{
+			continue;
+		}
+
+		(IsPriority(entry.ItemCode) ? changed : changedLater).Add(&entry);
+	}
+	changed.Append(changedLater);
+
+	TArray<FName> removed;
+	for (const auto& pair : sent)
+	{
+		if (!held.Contains(pair.Key))
+		{
+			removed.Add(pair.Key);
+		}
+	}
+
+	if (changed.Num() == 0 && removed.Num() == 0)
+	{
+		newState->ChangeKey = ChangeKey;
+		return false;
+	}
+
+	// Replays record every update as received, so they take everything at once
+	const int32 numToSend = DeltaParms.bInternalAck ? changed.Num() : FMath::Min(changed.Num(), FMath::Max(MaxEntriesPerUpdate, 1));
+	const bool bComplete = numToSend == changed.Num();
+
+	FBitWriter& writer = *DeltaParms.Writer;
+	uint32 numRemoved = removed.Num();
+	writer.SerializeIntPacked(numRemoved);
+	for (FName& itemCode : removed)
+	{
+		InventoryNetSerialization::SerializeItemCode(writer, itemCode, DeltaParms.Map);
+		sent.Remove(itemCode);
+	}
+
+	uint32 numChanged = numToSend;
+	writer.SerializeIntPacked(numChanged);
+	for (int32 i = 0; i < numToSend; i++)
+	{
+		FName itemCode = changed[i]->ItemCode;
+		int32 quantity = changed[i]->Quantity;
+		InventoryNetSerialization::SerializeItemCode(writer, itemCode, DeltaParms.Map);
+		InventoryNetSerialization::SerializeSignedPacked(writer, quantity);
+		sent.Add(itemCode, quantity);
+	}
+
+	newState->ChangeKey = bComplete ? ChangeKey : 0;
+	bHasPendingEntries |= !bComplete;
+	return true;
+}
+
+bool FInventoryEntryStream::ReadDelta(FNetDeltaSerializeInfo& DeltaParms)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FBitReader& reader = *DeltaParms.Reader;
+
+	TMap<FName, int32> indices;
+	indices.Reserve(Entries.Num());
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		indices.Add(Entries[i].ItemCode, i);
+	}
+
+	uint32 numRemoved = 0;
+	reader.SerializeIntPacked(numRemoved);
+	if (numRemoved > MaxEntriesPerDelta)
+	{
+		reader.SetError();
+		return false;
+	}
+
+	for (uint32 i = 0; i < numRemoved && !reader.IsError(); i++)
+	{
+		FName itemCode;
+		InventoryNetSerialization::SerializeItemCode(reader, itemCode, DeltaParms.Map);
+
+		int32 index;
+		if (!reader.IsError() && indices.RemoveAndCopyValue(itemCode, index))
+		{
+			ReceivedPreviousQuantities.FindOrAdd(itemCode, Entries[index].Quantity);
+			Entries.RemoveAtSwap(index, 1, false);
+			if (Entries.IsValidIndex(index))
+			{
+				indices[Entries[index].ItemCode] = index;
+			}
+		}
+	}
+
+	uint32 numChanged = 0;
+	reader.SerializeIntPacked(numChanged);
+	if (numChanged > MaxEntriesPerDelta)
+	{
+		reader.SetError();
+		return false;
+	}
+
+	for (uint32 i = 0; i < numChanged && !reader.IsError(); i++)
+	{
+		FName itemCode;
+		int32 quantity = 0;
+		InventoryNetSerialization::SerializeItemCode(reader, itemCode, DeltaParms.Map);
+		InventoryNetSerialization::SerializeSignedPacked(reader, quantity);
+		if (reader.IsError())
+		{
+			break;
+		}
+
+		if (const int32* index = indices.Find(itemCode))
+		{
+			ReceivedPreviousQuantities.FindOrAdd(itemCode, Entries[*index].Quantity);
+			Entries[*index].Quantity = quantity;
+		}
+		else
+		{
+			ReceivedPreviousQuantities.FindOrAdd(itemCode, 0);
+			indices.Add(itemCode, Entries.Emplace(itemCode, quantity));
+		}
+	}
+
+	return !reader.IsError();
+}
+
+bool FInventoryEntryStream::IsPriority(const FName itemCode) const
+{
+	const FInventoryItemRegistry& registry = FInventoryItemRegistry::Get();
+	for (const FName tag : PriorityTags)
+	{
+		if (registry.HasTag(itemCode, tag))
+		{
+			return true;
+		}
+	}
+	return false;
+}
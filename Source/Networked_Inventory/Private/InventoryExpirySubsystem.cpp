@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryExpirySubsystem.h"
+#include "Inventory.h"
+#include "InventoryInterface.h"
+#include "Engine/World.h"
+#include "Containers/Ticker.h"
+
+UInventoryExpirySubsystem* UInventoryExpirySubsystem::Get(const UObject* worldContextObject)
+{
+	const UWorld* world = worldContextObject ? worldContextObject->GetWorld() : nullptr;
+	return world ? world->GetSubsystem<UInventoryExpirySubsystem>() : nullptr;
+}
+
+void UInventoryExpirySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UInventoryExpirySubsystem::Tick));
+}
+
+void UInventoryExpirySubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	Super::Deinitialize();
+}
+
+double UInventoryExpirySubsystem::GetTime() const
+{
+	const UWorld* world = GetWorld();
+	return world ? world->GetTimeSeconds() : 0.0;
+}
+
+uint64 UInventoryExpirySubsystem::Schedule(double expiryTime, const FInventoryExpiryTimer& timer)
+{
+	return Wheel.Schedule(expiryTime, timer);
+}
+
+void UInventoryExpirySubsystem::Cancel(uint64 timerId)
+{
+	Wheel.Cancel(timerId);
+}
+
+int32 UInventoryExpirySubsystem::NumPendingExpiries() const
+{
+	return Wheel.Num();
+}
+
+void UInventoryExpirySubsystem::ExpireItems()
+{
+	ExpiredScratch.Reset();
+	Wheel.Advance(GetTime(), ExpiredScratch);
+	if (ExpiredScratch.Num() == 0)
+	{
+		return;
+	}
+
+	TMap<UObject*, TArray<FName>> expiredByInventory;
+	for (const FInventoryExpiryTimer& timer : ExpiredScratch)
+	{
+		if (UObject* inventory = timer.Inventory.Get())
+		{
+			expiredByInventory.FindOrAdd(inventory).Add(timer.ItemCode);
+		}
+	}
+
+	// Whole stacks go, through each inventory's normal group change so they replicate together
+	for (const auto& pair : expiredByInventory)
+	{
+		if (IInventoryInterface* inventory = Cast<IInventoryInterface>(pair.Key))
+		{
+			TArray<FInventoryEntry> removals;
+			for (const FName itemCode : pair.Value)
+			{
+				const int32 quantity = inventory->GetQuantityFor(itemCode);
+				if (quantity > 0)
+				{
+					removals.Emplace(itemCode, quantity);
+				}
+			}
+
+			// Everything that expired may already have been used up
+			if (removals.Num() > 0)
+			{
+				inventory->RemoveItemsFromInventory(removals);
+			}
+		}
+		else if (UInventory* inventoryObject = Cast<UInventory>(pair.Key))
+		{
+			TArray<FInventoryEntry> changes;
+			for (const FName itemCode : pair.Value)
+			{
+				const int32 quantity = inventoryObject->GetQuantityFor(itemCode);
+				if (quantity > 0)
+				{
+					changes.Emplace(itemCode, -quantity);
+				}
+			}
+
+			if (changes.Num() > 0)
+			{
+				inventoryObject->ModifyGroupOfEntries(changes);
+			}
+		}
+	}
+}
+
+bool UInventoryExpirySubsystem::Tick(float deltaTime)
+{
+	ExpireItems();
+	return true;
+}
+
+bool FInventoryExpiryTracker::Set(UObject* owner, const FName itemCode, float lifetimeSeconds)
+{
+	UInventoryExpirySubsystem* subsystem = UInventoryExpirySubsystem::Get(owner);
+	if (subsystem == nullptr)
+	{
+		return false;
+	}
+
+	Clear(itemCode);
+	Subsystem = subsystem;
+
+	FPendingExpiry& expiry = Expiries.Add(itemCode);
+	expiry.ExpiryTime = subsystem->GetTime() + FMath::Max(lifetimeSeconds, 0.0f);
+	expiry.ExpiryUtc = FDateTime::UtcNow() + FTimespan::FromSeconds(FMath::Max(lifetimeSeconds, 0.0f));
+	expiry.TimerId = subsystem->Schedule(expiry.ExpiryTime, FInventoryExpiryTimer(owner, itemCode));
+	return true;
+}
+
+bool FInventoryExpiryTracker::Clear(const FName itemCode)
+{
+	FPendingExpiry expiry;
+	if (!Expiries.RemoveAndCopyValue(itemCode, expiry))
+	{
+		return false;
+	}
+
+	if (UInventoryExpirySubsystem* subsystem = Subsystem.Get())
+	{
+		subsystem->Cancel(expiry.TimerId);
+	}
+	return true;
+}
+
+void FInventoryExpiryTracker::ClearAll()
+{
+	if (UInventoryExpirySubsystem* subsystem = Subsystem.Get())
+	{
+		for (const auto& pair : Expiries)
+		{
+			subsystem->Cancel(pair.Value.TimerId);
+		}
+	}
+	Expiries.Empty();
+}
+
+float FInventoryExpiryTracker::GetLifetimeRemaining(const FName itemCode) const
+{
+	const FPendingExpiry* expiry = Expiries.Find(itemCode);
+	const UInventoryExpirySubsystem* subsystem = Subsystem.Get();
+	if (expiry == nullptr || subsystem == nullptr)
+	{
+		return -1.0f;
+	}
+	return FMath::Max((float)(expiry->ExpiryTime - subsystem->GetTime()), 0.0f);
+}
+
+void FInventoryExpiryTracker::GetExpiries(TArray<FInventoryItemExpiry>& outExpiries) const
+{
+	outExpiries.Reset(Expiries.Num());
+	for (const auto& pair : Expiries)
+	{
+		outExpiries.Emplace(pair.Key, pair.Value.ExpiryUtc);
+	}
+}
+
+void FInventoryExpiryTracker::Restore(UObject* owner, const TArray<FInventoryItemExpiry>& expiries)
+{
+	const FDateTime now = FDateTime::UtcNow();
+	for (const FInventoryItemExpiry& expiry : expiries)
+	{
+		const double secondsLeft = (expiry.ExpiresUtc - now).GetTotalSeconds();
+		if (Set(owner, expiry.ItemCode, (float)FMath::Max(secondsLeft, 0.0)))
+		{
+			Expiries[expiry.ItemCode].ExpiryUtc = expiry.ExpiresUtc;
+		}
+	}
+}
+
+void FInventoryExpiryTracker::OnQuantityChanged(const FName itemCode, int32 newQuantity)
+{
+	if (newQuantity <= 0 && Expiries.Num() > 0)
+	{
+		Clear(itemCode);
+	}
+}
+
+SIZE_T FInventoryExpiryTracker::GetAllocatedSize() const
+{
+	return Expiries.GetAllocatedSize();
+}
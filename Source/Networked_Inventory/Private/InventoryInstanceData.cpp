@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryInstanceData.h"
+#include "InventoryNetSerialization.h"
+
+int32 FInventoryInstanceData::GetField(EInstanceDataField field) const
+{
+	switch (field)
+	{
+	case EInstanceDataField::Durability:
+		return Durability;
+	case EInstanceDataField::Charges:
+		return Charges;
+	case EInstanceDataField::Roll:
+		return Roll;
+	case EInstanceDataField::Enchantment:
+		return Enchantment;
+	default:
+		checkNoEntry();
+		return 0;
+	}
+}
+
+void FInventoryInstanceData::SetField(EInstanceDataField field, int32 value)
+{
+	switch (field)
+	{
+	case EInstanceDataField::Durability:
+		Durability = value;
+		break;
+	case EInstanceDataField::Charges:
+		Charges = value;
+		break;
+	case EInstanceDataField::Roll:
+		Roll = value;
+		break;
+	case EInstanceDataField::Enchantment:
+		Enchantment = value;
+		break;
+	default:
+		checkNoEntry();
+	}
+}
+
+bool FInventoryInstanceDataDelta::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	InventoryNetSerialization::SerializeItemCode(Ar, ItemCode, Map);
+	Ar.SerializeBits(&ChangedFields, FInventoryInstanceData::NumFields);
+
+	for (int32 i = 0; i < FInventoryInstanceData::NumFields; i++)
+	{
+		if ((ChangedFields & (1 << i)) == 0)
+		{
+			continue;
+		}
+
+		const EInstanceDataField field = static_cast<EInstanceDataField>(i);
+		int32 value = Values.GetField(field);
+		InventoryNetSerialization::SerializeSignedPacked(Ar, value);
+		Values.SetField(field, value);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+int32 FInventoryInstanceArena::Allocate()
+{
+	int32 handle;
+	if (FreeHandles.Num() > 0)
+	{
+		handle = FreeHandles.Pop(false);
+	}
+	else
+	{
+		if (HighWaterMark == Blocks.Num() * SlotsPerBlock)
+		{
+			Blocks.Add(MakeUnique<FInventoryInstanceData[]>(SlotsPerBlock));
+		}
+		handle = HighWaterMark++;
+	}
+
+	Get(handle) = FInventoryInstanceData();
+	return handle;
+}
+
+void FInventoryInstanceArena::Free(int32 handle)
+{
+	check(handle >= 0 && handle < HighWaterMark);
+	FreeHandles.Add(handle);
+}
+
+void FInventoryInstanceArena::Reset()
+{
+	Blocks.Empty();
+	FreeHandles.Empty();
+	HighWaterMark = 0;
+}
+
+FInventoryInstanceData& FInventoryInstanceArena::Get(int32 handle)
+{
+	check(handle >= 0 && handle < HighWaterMark);
+	return Blocks[handle / SlotsPerBlock][handle % SlotsPerBlock];
+}
+
+const FInventoryInstanceData& FInventoryInstanceArena::Get(int32 handle) const
+{
+	check(handle >= 0 && handle < HighWaterMark);
+	return Blocks[handle / SlotsPerBlock][handle % SlotsPerBlock];
+}
+
+int32 FInventoryInstanceArena::Num() const
+{
+	return HighWaterMark - FreeHandles.Num();
+}
+
+SIZE_T FInventoryInstanceArena::GetAllocatedSize() const
+{
+	return Blocks.GetAllocatedSize() + FreeHandles.GetAllocatedSize() + Blocks.Num() * SlotsPerBlock * sizeof(FInventoryInstanceData);
+}
+
+void FInventoryInstanceArena::Shrink()
+{
+	TBitArray<> freeSlots(false, HighWaterMark);
+	for (int32 handle : FreeHandles)
+	{
+		freeSlots[handle] = true;
+	}
+
+	while (HighWaterMark > 0 && freeSlots[HighWaterMark - 1])
+	{
+		HighWaterMark--;
+	}
+
+	FreeHandles.RemoveAll([this](int32 handle) { return handle >= HighWaterMark; });
+	Blocks.SetNum(FMath::DivideAndRoundUp(HighWaterMark, SlotsPerBlock));
+
+	FreeHandles.Shrink();
+	Blocks.Shrink();
+}
+
+bool FInventoryInstanceStore::Contains(const FName itemCode) const
+{
+	return Handles.Contains(itemCode);
+}
+
+const FInventoryInstanceData* FInventoryInstanceStore::Find(const FName itemCode) const
+{
+	const int32* handle = Handles.Find(itemCode);
+	return handle ? &Arena.Get(*handle) : nullptr;
+}
+
+int32 FInventoryInstanceStore::GetField(const FName itemCode, EInstanceDataField field) const
+{
+	const FInventoryInstanceData* data = Find(itemCode);
+	return data ? data->GetField(field) : 0;
+}
+
+void FInventoryInstanceStore::SetField(const FName itemCode, EInstanceDataField field, int32 value)
+{
+	int32* handle = Handles.Find(itemCode);
+	if (!handle)
+	{
+		handle = &Handles.Add(itemCode, Arena.Allocate());
+	}
+
+	FInventoryInstanceData& data = Arena.Get(*handle);
+	if (data.GetField(field) == value)
+	{
+		return;
+	}
+
+	data.SetField(field, value);
+	DirtyFields.FindOrAdd(itemCode, 0) |= 1 << static_cast<uint8>(field);
+}
+
+void FInventoryInstanceStore::Release(const FName itemCode)
+{
+	int32 handle;
+	if (Handles.RemoveAndCopyValue(itemCode, handle))
+	{
+		Arena.Free(handle);
+		DirtyFields.Remove(itemCode);
+	}
+}
+
+void FInventoryInstanceStore::Reset()
+{
+	Arena.Reset();
+	Handles.Empty();
+	DirtyFields.Empty();
+}
+
+bool FInventoryInstanceStore::HasPendingDeltas() const
+{
+	return DirtyFields.Num() > 0;
+}
+
+void FInventoryInstanceStore::ConsumeDeltas(TArray<FInventoryInstanceDataDelta>& outDeltas)
+{
+	outDeltas.Reserve(outDeltas.Num() + DirtyFields.Num());
+	for (const auto& pair : DirtyFields)
+	{
+		FInventoryInstanceDataDelta& delta = outDeltas.AddDefaulted_GetRef();
+		delta.ItemCode = pair.Key;
+		delta.ChangedFields = pair.Value;
+		delta.Values = Arena.Get(Handles[pair.Key]);
+	}
+	DirtyFields.Reset();
+}
+
+void FInventoryInstanceStore::ApplyDelta(const FInventoryInstanceDataDelta& delta)
+{
+	int32* handle = Handles.Find(delta.ItemCode);
+	if (!handle)
+	{
+		handle = &Handles.Add(delta.ItemCode, Arena.Allocate());
+	}
+
+	FInventoryInstanceData& data = Arena.Get(*handle);
+	for (int32 i = 0; i < FInventoryInstanceData::NumFields; i++)
+	{
+		if (delta.ChangedFields & (1 << i))
+		{
+			const EInstanceDataField field = static_cast<EInstanceDataField>(i);
+			data.SetField(field, delta.Values.GetField(field));
+		}
+	}
+}
+
+int32 FInventoryInstanceStore::Num() const
+{
+	return Handles.Num();
+}
+
+SIZE_T FInventoryInstanceStore::GetAllocatedSize() const
+{
+	return Arena.GetAllocatedSize() + Handles.GetAllocatedSize() + DirtyFields.GetAllocatedSize();
+}
+
+void FInventoryInstanceStore::Shrink()
+{
+	Arena.Shrink();
+	Handles.Compact();
+	Handles.Shrink();
+	DirtyFields.Compact();
+	DirtyFields.Shrink();
+}
@@ -2,6 +2,7 @@
 
 
 #include "InventoryInterface.h"
+#include "InventoryItemRegistry.h"
 
 // Add default functionality here for any IInventoryInterface functions that are not pure virtual.
 
@@ -14,3 +15,57 @@ void IInventoryInterface::AddItemToInventory(const FName itemCode, int32 quantit
 	arr.Init(entry, 1);
 	AddItemsToInventory(arr);
 }
+
+TFuture<FInventoryRequestResult> IInventoryInterface::ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	// Nothing here can tell whether the change was committed, so the request is refused rather than guessed at
+	UE_LOG(LogTemp, Warning, TEXT("This inventory does not support asynchronous requests. Rejecting request of %i entries; use ModifyInventory instead."), inventoryChanges.Num());
+	return MakeCompletedRequest(EInventoryRequestOutcome::Rejected, MakeTuple(EChangeGroupStatus::SomeChangesLost, TArray<EChangeStatus>()));
+}
+
+void IInventoryInterface::GetEntries(TArray<FInventoryEntry>& outEntries) const
+{
+	TArray<FName> itemCodes;
+	FInventoryItemRegistry::Get().GetRegisteredItems(itemCodes);
+
+	outEntries.Reset();
+	for (const FName itemCode : itemCodes)
+	{
+		const int32 quantity = GetQuantityFor(itemCode);
+		if (quantity != 0)
+		{
+			outEntries.Emplace(itemCode, quantity);
+		}
+	}
+}
+
+int32 IInventoryInterface::GetQuantityFor(const FName itemCode) const
+{
+	TArray<FInventoryEntry> entries;
+	GetEntries(entries);
+
+	const FInventoryEntry* entry = entries.FindByPredicate([itemCode](const FInventoryEntry& candidate) { return candidate.ItemCode == itemCode; });
+	return entry ? entry->Quantity : 0;
+}
+
+void IInventoryInterface::GetCounterValues(TArray<FInventoryCounterValue>& outValues) const
+{
+	outValues.Reset();
+}
+
+void IInventoryInterface::GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const
+{
+	outExpiries.Reset();
+}
+
+TFuture<FInventoryRequestResult> IInventoryInterface::MakeCompletedRequest(EInventoryRequestOutcome outcome, const TTuple<EChangeGroupStatus, TArray<EChangeStatus>>& statuses)
+{
+	FInventoryRequestResult result;
+	result.Outcome = outcome;
+	result.GroupStatus = statuses.Key;
+	result.EntryStatuses = statuses.Value;
+
+	TPromise<FInventoryRequestResult> promise;
+	promise.SetValue(MoveTemp(result));
+	return promise.GetFuture();
+}
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryItemRegistry.h"
+#include "InventoryMemory.h"
+
+FInventoryItemRegistry& FInventoryItemRegistry::Get()
+{
+	static FInventoryItemRegistry Registry;
+	return Registry;
+}
+
+void FInventoryItemRegistry::RegisterItem(const FName itemCode, const TArray<FName>& tags)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	ItemTags.Add(itemCode, tags);
+	RebuildNetIndexTable();
+}
+
+void FInventoryItemRegistry::UnregisterItem(const FName itemCode)
+{
+	ItemTags.Remove(itemCode);
+	CounterPolicies.Remove(itemCode);
+	RebuildNetIndexTable();
+}
+
+void FInventoryItemRegistry::RegisterItems(const TMap<FName, TArray<FName>>& itemTags)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	ItemTags.Append(itemTags);
+	RebuildNetIndexTable();
+}
+
+void FInventoryItemRegistry::RegisterCounter(const FName itemCode, const FInventoryCounterPolicy& policy)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	CounterPolicies.Add(itemCode, policy);
+}
+
+const FInventoryCounterPolicy* FInventoryItemRegistry::GetCounterPolicy(const FName itemCode) const
+{
+	return CounterPolicies.Num() > 0 ? CounterPolicies.Find(itemCode) : nullptr;
+}
+
+void FInventoryItemRegistry::GetRegisteredItems(TArray<FName>& outItemCodes) const
+{
+	ItemTags.GenerateKeyArray(outItemCodes);
+	for (const auto& pair : CounterPolicies)
+	{
+		if (!ItemTags.Contains(pair.Key))
+		{
+			outItemCodes.Add(pair.Key);
+		}
+	}
+}
+
+const TArray<FName>& FInventoryItemRegistry::GetTagsFor(const FName itemCode) const
+{
+	static const TArray<FName> NoTags;
+	const TArray<FName>* tags = ItemTags.Find(itemCode);
+	return tags ? *tags : NoTags;
+}
+
+bool FInventoryItemRegistry::HasTag(const FName itemCode, const FName tag) const
+{
+	return GetTagsFor(itemCode).Contains(tag);
+}
+
+int32 FInventoryItemRegistry::GetNetIndex(const FName itemCode, const UObject* connection) const
+{
+	const FInventoryNetIndexTable* table = GetTableFor(connection, true);
+	const int32* index = table ? table->Indices.Find(itemCode) : nullptr;
+	return index ? *index : INDEX_NONE;
+}
+
+FName FInventoryItemRegistry::GetItemForNetIndex(int32 netIndex, const UObject* connection) const
+{
+	const FInventoryNetIndexTable* table = GetTableFor(connection, false);
+	return table && table->Items.IsValidIndex(netIndex) ? table->Items[netIndex] : NAME_None;
+}
+
+uint32 FInventoryItemRegistry::GetNetIndexChecksum() const
+{
+	return NetIndexTable->Checksum;
+}
+
+uint32 FInventoryItemRegistry::BeginNetIndexAgreement(const UObject* connection)
+{
+	check(IsInGameThread());
+	RemoveClosedConnections();
+
+	FNetIndexAgreement& agreement = Agreements.FindOrAdd(connection);
+	if (!agreement.Table.IsValid())
+	{
+		agreement.Table = NetIndexTable;
+	}
+	return agreement.Table->Checksum;
+}
+
+bool FInventoryItemRegistry::AcceptNetIndexAgreement(const UObject* connection, uint32 checksum)
+{
+	check(IsInGameThread());
+	RemoveClosedConnections();
+
+	// Further inventories of an agreed connection report the table it already uses
+	const FNetIndexAgreement* existing = Agreements.Find(connection);
+	if (existing && existing->Table->Checksum == checksum)
+	{
+		return true;
+	}
+
+	if (checksum != NetIndexTable->Checksum)
+	{
+		Agreements.Remove(connection);
+		return false;
+	}
+
+	FNetIndexAgreement& agreement = Agreements.FindOrAdd(connection);
+	agreement.Table = NetIndexTable;
+	agreement.bCanSendIndices = true;
+	return true;
+}
+
+void FInventoryItemRegistry::ConfirmNetIndexAgreement(const UObject* connection, uint32 checksum)
+{
+	check(IsInGameThread());
+
+	FNetIndexAgreement* agreement = Agreements.Find(connection);
+	if (agreement && agreement->Table->Checksum == checksum)
+	{
+		agreement->bCanSendIndices = true;
+	}
+}
+
+void FInventoryItemRegistry::RemoveClosedConnections()
+{
+	for (auto it = Agreements.CreateIterator(); it; ++it)
+	{
+		if (!it->Key.IsValid())
+		{
+			it.RemoveCurrent();
+		}
+	}
+}
+
+const FInventoryNetIndexTable* FInventoryItemRegistry::GetTableFor(const UObject* connection, bool bSending) const
+{
+	if (connection == nullptr)
+	{
+		return NetIndexTable.Get();
+	}
+
+	const FNetIndexAgreement* agreement = Agreements.Find(connection);
+	if (agreement == nullptr || (bSending && !agreement->bCanSendIndices))
+	{
+		return nullptr;
+	}
+	return agreement->Table.Get();
+}
+
+void FInventoryItemRegistry::RebuildNetIndexTable()
+{
+	check(IsInGameThread());
+
+	TSharedRef<FInventoryNetIndexTable, ESPMode::ThreadSafe> table = MakeShared<FInventoryNetIndexTable, ESPMode::ThreadSafe>();
+	ItemTags.GenerateKeyArray(table->Items);
+	table->Items.Sort(FNameLexicalLess());
+
+	table->Indices.Reserve(table->Items.Num());
+	for (int32 i = 0; i < table->Items.Num(); i++)
+	{
+		table->Indices.Add(table->Items[i], i);
+		table->Checksum = FCrc::StrCrc32(*table->Items[i].ToString().ToLower(), table->Checksum);
+	}
+
+	// Agreed connections keep the table they agreed on; codes registered from here on go out as names
+	NetIndexTable = table;
+}
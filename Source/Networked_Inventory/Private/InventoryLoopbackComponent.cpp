@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryLoopbackComponent.h"
+
+void UInventoryLoopbackComponent::SendRequest(int32 requestId, const FInventoryEntryBatch& inventoryBatch)
+{
+	if (Peer != nullptr)
+	{
+		Peer->Server_ModifyInventoryRequest_Implementation(requestId, inventoryBatch);
+	}
+}
+
+void UInventoryLoopbackComponent::SendAnswers(const TArray<FInventoryRequestResult>& results)
+{
+	Super::SendAnswers(results);
+	if (Peer != nullptr)
+	{
+		Peer->Client_CompleteRequests_Implementation(results);
+	}
+}
+
+void UInventoryLoopbackComponent::SendCounterValues(const TArray<FInventoryCounterValue>& counterValues)
+{
+	NumCounterUpdatesSent++;
+	Super::SendCounterValues(counterValues);
+	if (Peer != nullptr)
+	{
+		Peer->Client_UpdateCounters_Implementation(counterValues);
+	}
+}
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RPCBasedInventoryComponent.h"
+#include "InventoryLoopbackComponent.generated.h"
+
+/**
+ * RPC inventory for the automation tests that hands its requests, answers and counter updates straight to Peer, so a
+ * client inventory and its server inventory can talk inside one test world. Answers and counter updates still go out
+ * through the RPCs as well. Without a peer, requests are lost as if the connection had gone.
+ */
+UCLASS(NotBlueprintable)
+class UInventoryLoopbackComponent : public URPCBasedInventoryComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+		UInventoryLoopbackComponent* Peer = nullptr;
+
+	// Server: counter updates sent to the client so far
+	int32 NumCounterUpdatesSent = 0;
+
+protected:
+	virtual void SendRequest(int32 requestId, const FInventoryEntryBatch& inventoryBatch) override;
+	virtual void SendAnswers(const TArray<FInventoryRequestResult>& results) override;
+	virtual void SendCounterValues(const TArray<FInventoryCounterValue>& counterValues) override;
+};
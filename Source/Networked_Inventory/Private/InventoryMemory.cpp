@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryMemory.h"
+#include "Inventory.h"
+#include "ReplicationInventoryComponent.h"
+#include "RPCBasedInventoryComponent.h"
+#include "ContainerInventoryComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+LLM_DEFINE_TAG(NetworkedInventory);
+
+namespace
+{
+	struct FInventoryMemoryRow
+	{
+		const UObject* Object;
+		FInventoryMemoryUsage Usage;
+	};
+
+	bool ShouldReport(const UObject* object)
+	{
+		return !object->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject) && !object->IsPendingKill();
+	}
+
+	// Calls func with every live inventory; an inventory wrapped by a component is reached through the component
+	template<typename FuncType>
+	void ForEachInventory(FuncType func)
+	{
+		for (TObjectIterator<UReplicationInventoryComponent> it; it; ++it)
+		{
+			if (ShouldReport(*it))
+			{
+				func(**it);
+			}
+		}
+
+		for (TObjectIterator<URPCBasedInventoryComponent> it; it; ++it)
+		{
+			if (ShouldReport(*it))
+			{
+				func(**it);
+			}
+		}
+
+		for (TObjectIterator<UContainerInventoryComponent> it; it; ++it)
+		{
+			if (ShouldReport(*it))
+			{
+				func(**it);
+			}
+		}
+
+		for (TObjectIterator<UInventory> it; it; ++it)
+		{
+			if (ShouldReport(*it) && !it->GetOuter()->IsA<URPCBasedInventoryComponent>())
+			{
+				func(**it);
+			}
+		}
+	}
+
+	FString FormatBytes(SIZE_T bytes)
+	{
+		return FString::Printf(TEXT("%.1f KB"), bytes / 1024.0);
+	}
+}
+
+void InventoryMemory::LogReport(int32 numLargest)
+{
+	TMap<const UClass*, FInventoryMemoryUsage> usageByType;
+	TMap<const UClass*, int32> countByType;
+	TArray<FInventoryMemoryRow> rows;
+
+	ForEachInventory([&](const auto& inventory)
+	{
+		const FInventoryMemoryUsage usage = inventory.GetMemoryUsage();
+		usageByType.FindOrAdd(inventory.GetClass()) += usage;
+		countByType.FindOrAdd(inventory.GetClass())++;
+		rows.Add({ &inventory, usage });
+	});
+
+	UE_LOG(LogTemp, Display, TEXT("Inventory memory by type:"));
+	FInventoryMemoryUsage total;
+	for (const auto& pair : usageByType)
+	{
+		const FInventoryMemoryUsage& usage = pair.Value;
+		UE_LOG(LogTemp, Display, TEXT("  %s: %i inventories, %i entries, %s allocated, %s used, %s slack"),
+			*pair.Key->GetName(), countByType[pair.Key], usage.NumEntries,
+			*FormatBytes(usage.AllocatedBytes), *FormatBytes(usage.UsedBytes), *FormatBytes(usage.GetSlackBytes()));
+		total += usage;
+	}
+	UE_LOG(LogTemp, Display, TEXT("  Total: %i inventories, %i entries, %s allocated, %s used, %s slack"),
+		rows.Num(), total.NumEntries, *FormatBytes(total.AllocatedBytes), *FormatBytes(total.UsedBytes), *FormatBytes(total.GetSlackBytes()));
+
+	rows.Sort([](const FInventoryMemoryRow& a, const FInventoryMemoryRow& b)
+	{
+		return a.Usage.AllocatedBytes > b.Usage.AllocatedBytes;
+	});
+
+	const int32 numShown = FMath::Min(numLargest, rows.Num());
+	UE_LOG(LogTemp, Display, TEXT("Largest %i inventories:"), numShown);
+	for (int32 i = 0; i < numShown; i++)
+	{
+		const FInventoryMemoryUsage& usage = rows[i].Usage;
+		UE_LOG(LogTemp, Display, TEXT("  %s: %i entries, %s allocated, %s slack"),
+			*rows[i].Object->GetPathName(), usage.NumEntries, *FormatBytes(usage.AllocatedBytes), *FormatBytes(usage.GetSlackBytes()));
+	}
+}
+
+SIZE_T InventoryMemory::ShrinkAll()
+{
+	SIZE_T before = 0;
+	SIZE_T after = 0;
+
+	ForEachInventory([&](auto& inventory)
+	{
+		before += inventory.GetMemoryUsage().AllocatedBytes;
+		inventory.Shrink();
+		after += inventory.GetMemoryUsage().AllocatedBytes;
+	});
+
+	return before > after ? before - after : 0;
+}
+
+static FAutoConsoleCommand InventoryMemoryReportCommand(
+	TEXT("Inventory.Memory.Report"),
+	TEXT("Logs entry counts and allocated, used and slack bytes per inventory type. Optional argument: number of largest inventories to list (default 10)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		InventoryMemory::LogReport(args.Num() > 0 ? FCString::Atoi(*args[0]) : 10);
+	}));
+
+static FAutoConsoleCommand InventoryShrinkAllCommand(
+	TEXT("Inventory.Memory.ShrinkAll"),
+	TEXT("Compacts the containers of every inventory, releasing slack left by bulk removals."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const SIZE_T releasedBytes = InventoryMemory::ShrinkAll();
+		UE_LOG(LogTemp, Display, TEXT("Released %s of inventory memory."), *FormatBytes(releasedBytes));
+	}));
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryNetSerialization.h"
+#include "InventoryItemRegistry.h"
+#include "UObject/CoreNet.h"
+#include "Engine/PackageMapClient.h"
+
+void InventoryNetSerialization::SerializeSignedPacked(FArchive& Ar, int32& value)
+{
+	uint32 packed = Ar.IsSaving() ? ZigZagEncode(value) : 0;
+	Ar.SerializeIntPacked(packed);
+
+	if (Ar.IsLoading())
+	{
+		value = ZigZagDecode(packed);
+	}
+}
+
+void InventoryNetSerialization::SerializeItemCode(FArchive& Ar, FName& itemCode, UPackageMap* Map)
+{
+	const FInventoryItemRegistry& registry = FInventoryItemRegistry::Get();
+
+	// Indices are only meaningful against the table agreed with this connection
+	const UPackageMapClient* packageMap = Cast<UPackageMapClient>(Map);
+	const UObject* connection = packageMap ? packageMap->GetConnection() : nullptr;
+
+	uint32 netIndex = 0;
+	uint8 bIndexed = 0;
+	if (Ar.IsSaving())
+	{
+		const int32 index = registry.GetNetIndex(itemCode, connection);
+		bIndexed = index != INDEX_NONE ? 1 : 0;
+		netIndex = bIndexed ? static_cast<uint32>(index) : 0;
+	}
+
+	Ar.SerializeBits(&bIndexed, 1);
+
+	if (bIndexed)
+	{
+		Ar.SerializeIntPacked(netIndex);
+		if (Ar.IsLoading())
+		{
+			itemCode = registry.GetItemForNetIndex(static_cast<int32>(netIndex), connection);
+			if (itemCode.IsNone())
+			{
+				UE_LOG(LogTemp, Error, TEXT("Received unknown item net index %u. No item registry was agreed with this connection."), netIndex);
+				Ar.SetError();
+			}
+		}
+	}
+	else
+	{
+		UPackageMap::StaticSerializeName(Ar, itemCode);
+	}
+}
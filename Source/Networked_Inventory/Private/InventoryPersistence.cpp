@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryPersistence.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Event.h"
+#include "InventoryMemory.h"
+
+FWriteBehindInventoryWriter::FWriteBehindInventoryWriter(TSharedRef<IInventoryPersistenceBackend, ESPMode::ThreadSafe> backend, const FWriteBehindSettings& settings)
+	: Backend(backend)
+	, Settings(settings)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, bStopping(false)
+	, Thread(nullptr)
+{
+	Thread = FRunnableThread::Create(this, TEXT("InventoryWriteBehind"), 0, TPri_BelowNormal);
+}
+
+FWriteBehindInventoryWriter::~FWriteBehindInventoryWriter()
+{
+	Shutdown();
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+void FWriteBehindInventoryWriter::Enqueue(TArray<FInventoryPersistenceRecord>&& batch)
+{
+	if (batch.Num() == 0)
+	{
+		return;
+	}
+
+	QueuedBatches.Increment();
+	Batches.Enqueue(MoveTemp(batch));
+	WorkEvent->Trigger();
+}
+
+int32 FWriteBehindInventoryWriter::NumQueuedBatches() const
+{
+	return QueuedBatches.GetValue();
+}
+
+int32 FWriteBehindInventoryWriter::NumUnsavedInventories() const
+{
+	return NumUnsaved.GetValue();
+}
+
+void FWriteBehindInventoryWriter::Shutdown()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+}
+
+uint32 FWriteBehindInventoryWriter::Run()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	while (true)
+	{
+		TArray<FInventoryPersistenceRecord> batch;
+		while (Batches.Dequeue(batch))
+		{
+			SaveWithRetries(batch);
+			QueuedBatches.Decrement();
+		}
+
+		// Only leave once everything queued before Stop() has been written
+		if (bStopping)
+		{
+			if (UnsavedRecords.Num() > 0)
+			{
+				TArray<FInventoryPersistenceRecord> leftovers;
+				SaveWithRetries(leftovers);
+			}
+			if (UnsavedRecords.Num() > 0)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Shutting down with %i inventories that could not be saved."), UnsavedRecords.Num());
+			}
+			break;
+		}
+
+		if (UnsavedRecords.Num() == 0)
+		{
+			WorkEvent->Wait();
+		}
+		else if (!WorkEvent->Wait(FTimespan::FromSeconds(Settings.RetryIntervalSeconds)))
+		{
+			TArray<FInventoryPersistenceRecord> leftovers;
+			SaveWithRetries(leftovers);
+		}
+	}
+
+	return 0;
+}
+
+void FWriteBehindInventoryWriter::Stop()
+{
+	bStopping = true;
+	WorkEvent->Trigger();
+}
+
+void FWriteBehindInventoryWriter::SaveWithRetries(TArray<FInventoryPersistenceRecord>& batch)
+{
+	// Records left over from a failed batch go out again, unless this batch has newer contents for them
+	if (UnsavedRecords.Num() > 0)
+	{
+		for (const FInventoryPersistenceRecord& record : batch)
+		{
+			UnsavedRecords.Remove(record.InventoryId);
+		}
+		for (auto& pair : UnsavedRecords)
+		{
+			batch.Add(MoveTemp(pair.Value));
+		}
+		UnsavedRecords.Reset();
+		NumUnsaved.Set(0);
+	}
+
+	if (batch.Num() == 0)
+	{
+		return;
+	}
+
+	for (int32 attempt = 1; attempt <= Settings.MaxSaveAttempts; attempt++)
+	{
+		if (Backend->SaveBatch(batch))
+		{
+			return;
+		}
+
+		UE_LOG(LogTemp, Warning, TEXT("Saving batch of %i inventories failed (attempt %i of %i)."), batch.Num(), attempt, Settings.MaxSaveAttempts);
+		FPlatformProcess::Sleep(0.1f * attempt);
+	}
+
+	UE_LOG(LogTemp, Error, TEXT("Saving batch of %i inventories failed %i times. Keeping it to try again."), batch.Num(), Settings.MaxSaveAttempts);
+	for (FInventoryPersistenceRecord& record : batch)
+	{
+		UnsavedRecords.Add(record.InventoryId, MoveTemp(record));
+	}
+	NumUnsaved.Set(UnsavedRecords.Num());
+}
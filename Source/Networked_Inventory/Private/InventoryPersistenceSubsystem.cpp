@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryPersistenceSubsystem.h"
+#include "InventoryInterface.h"
+#include "Components/ActorComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "InventoryMemory.h"
+
+namespace
+{
+	void AddRecord(TArray<FInventoryPersistenceRecord>& batch, const IInventoryInterface& inventory, const FString& inventoryId)
+	{
+		FInventoryPersistenceRecord& record = batch.AddDefaulted_GetRef();
+		record.InventoryId = inventoryId;
+		inventory.GetEntries(record.Entries);
+		inventory.GetCounterValues(record.Counters);
+		inventory.GetItemExpiries(record.Expiries);
+	}
+}
+
+UInventoryPersistenceSubsystem* UInventoryPersistenceSubsystem::Get(const UObject* worldContextObject)
+{
+	const UWorld* world = worldContextObject ? worldContextObject->GetWorld() : nullptr;
+	const UGameInstance* gameInstance = world ? world->GetGameInstance() : nullptr;
+	return gameInstance ? gameInstance->GetSubsystem<UInventoryPersistenceSubsystem>() : nullptr;
+}
+
+void UInventoryPersistenceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TimeSinceCollect = 0.0f;
+	bLoggedBackpressure = false;
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UInventoryPersistenceSubsystem::Tick));
+}
+
+void UInventoryPersistenceSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	// Clean shutdown: everything dirty goes out, and the writer drains its queue before the thread exits
+	FlushAll();
+	Writer.Reset();
+	Backend.Reset();
+
+	Super::Deinitialize();
+}
+
+void UInventoryPersistenceSubsystem::SetBackend(TSharedPtr<IInventoryPersistenceBackend, ESPMode::ThreadSafe> backend, const FWriteBehindSettings& settings)
+{
+	FlushAll();
+	Writer.Reset();
+
+	Backend = backend;
+	Settings = settings;
+	if (Backend.IsValid())
+	{
+		Writer = MakeUnique<FWriteBehindInventoryWriter>(Backend.ToSharedRef(), Settings);
+	}
+}
+
+bool UInventoryPersistenceSubsystem::HasBackend() const
+{
+	return Writer.IsValid();
+}
+
+void UInventoryPersistenceSubsystem::MarkDirty(UActorComponent* inventoryComponent, const FString& inventoryId)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (!Writer.IsValid() || inventoryComponent == nullptr)
+	{
+		return;
+	}
+
+	checkSlow(Cast<IInventoryInterface>(inventoryComponent) != nullptr);
+	if (FailedLoads.Num() > 0 && FailedLoads.Contains(inventoryId))
+	{
+		return;
+	}
+	DirtyInventories.Add(inventoryComponent, inventoryId);
+}
+
+void UInventoryPersistenceSubsystem::FlushInventory(UActorComponent* inventoryComponent)
+{
+	FString inventoryId;
+	if (!Writer.IsValid() || !DirtyInventories.RemoveAndCopyValue(inventoryComponent, inventoryId))
+	{
+		return;
+	}
+
+	const IInventoryInterface* inventory = Cast<IInventoryInterface>(inventoryComponent);
+	if (inventory == nullptr)
+	{
+		return;
+	}
+
+	TArray<FInventoryPersistenceRecord> batch;
+	AddRecord(batch, *inventory, inventoryId);
+	Writer->Enqueue(MoveTemp(batch));
+}
+
+void UInventoryPersistenceSubsystem::LoadAsync(UActorComponent* inventoryComponent, const FString& inventoryId, TFunction<void(const FInventoryPersistenceRecord&)> onLoaded)
+{
+	if (!Backend.IsValid())
+	{
+		return;
+	}
+
+	TSharedPtr<IInventoryPersistenceBackend, ESPMode::ThreadSafe> backend = Backend;
+	TWeakObjectPtr<UInventoryPersistenceSubsystem> weakThis = this;
+	TWeakObjectPtr<UActorComponent> weakComponent = inventoryComponent;
+	Async(EAsyncExecution::ThreadPool, [backend, inventoryId, weakThis, weakComponent, onLoaded]()
+	{
+		FInventoryPersistenceRecord record;
+		const EInventoryLoadResult result = backend->Load(inventoryId, record);
+		if (result == EInventoryLoadResult::NotFound)
+		{
+			return;
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [weakThis, weakComponent, onLoaded, inventoryId, result, record = MoveTemp(record)]()
+		{
+			if (result == EInventoryLoadResult::Failed)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not load inventory %s. It will not be saved this session."), *inventoryId);
+				if (weakThis.IsValid())
+				{
+					weakThis->FailedLoads.Add(inventoryId);
+					weakThis->DirtyInventories.Remove(weakComponent);
+				}
+				return;
+			}
+
+			if (weakComponent.IsValid())
+			{
+				onLoaded(record);
+			}
+		});
+	});
+}
+
+void UInventoryPersistenceSubsystem::FlushAll()
+{
+	if (Writer.IsValid())
+	{
+		CollectDirty();
+	}
+}
+
+int32 UInventoryPersistenceSubsystem::NumDirtyInventories() const
+{
+	return DirtyInventories.Num();
+}
+
+bool UInventoryPersistenceSubsystem::Tick(float deltaTime)
+{
+	if (!Writer.IsValid() || DirtyInventories.Num() == 0)
+	{
+		TimeSinceCollect = 0.0f;
+		return true;
+	}
+
+	TimeSinceCollect += deltaTime;
+	if (TimeSinceCollect < Settings.FlushIntervalSeconds && DirtyInventories.Num() < Settings.DirtyCountThreshold)
+	{
+		return true;
+	}
+
+	// Backpressure: while storage is behind, keep inventories dirty so later changes coalesce into one write
+	if (Writer->NumQueuedBatches() >= Settings.MaxQueuedBatches)
+	{
+		if (!bLoggedBackpressure)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Inventory persistence is falling behind (%i batches queued). Holding back %i dirty inventories."), Writer->NumQueuedBatches(), DirtyInventories.Num());
+			bLoggedBackpressure = true;
+		}
+		return true;
+	}
+
+	bLoggedBackpressure = false;
+	CollectDirty();
+	return true;
+}
+
+void UInventoryPersistenceSubsystem::CollectDirty()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	TimeSinceCollect = 0.0f;
+
+	TArray<FInventoryPersistenceRecord> batch;
+	batch.Reserve(DirtyInventories.Num());
+	for (const auto& pair : DirtyInventories)
+	{
+		const IInventoryInterface* inventory = Cast<IInventoryInterface>(pair.Key.Get());
+		if (inventory == nullptr)
+		{
+			continue;
+		}
+
+		AddRecord(batch, *inventory, pair.Value);
+	}
+
+	DirtyInventories.Reset();
+	Writer->Enqueue(MoveTemp(batch));
+}
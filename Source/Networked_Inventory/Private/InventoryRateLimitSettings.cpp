@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryRateLimitSettings.h"
+
+UInventoryRateLimitSettings::UInventoryRateLimitSettings()
+{
+	bEnableRateLimiting = true;
+	RequestsPerSecond = 10.0f;
+	RequestBurst = 20;
+	EntriesPerSecond = 500.0f;
+	EntryBurst = 1000;
+	ThrottlePolicy = EInventoryThrottlePolicy::Defer;
+	MaxDeferredRequestsPerConnection = 32;
+	FrameEntryBudget = 4000;
+	bScheduleOutgoingTraffic = false;
+	OutgoingBytesPerSecond = 65536.0f;
+	OutgoingBurstBytes = 16384;
+}
+
+FName UInventoryRateLimitSettings::GetCategoryName() const
+{
+	return TEXT("Plugins");
+}
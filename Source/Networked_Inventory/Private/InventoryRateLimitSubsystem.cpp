@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryRateLimitSubsystem.h"
+#include "InventoryRateLimitSettings.h"
+#include "Engine/World.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformTime.h"
+#include "InventoryMemory.h"
+
+void FInventoryTokenBucket::Refill(double ratePerSecond, double capacity, double now)
+{
+	if (LastRefillTime < 0.0)
+	{
+		Tokens = capacity;
+	}
+	else
+	{
+		Tokens = FMath::Min(capacity, Tokens + (now - LastRefillTime) * ratePerSecond);
+	}
+	LastRefillTime = now;
+}
+
+UInventoryRateLimitSubsystem* UInventoryRateLimitSubsystem::Get(const UObject* worldContextObject)
+{
+	const UWorld* world = worldContextObject ? worldContextObject->GetWorld() : nullptr;
+	return world ? world->GetSubsystem<UInventoryRateLimitSubsystem>() : nullptr;
+}
+
+void UInventoryRateLimitSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FrameEntriesUsed = 0;
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UInventoryRateLimitSubsystem::Tick));
+}
+
+void UInventoryRateLimitSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	Connections.Empty();
+
+	Super::Deinitialize();
+}
+
+EInventoryRequestAdmission UInventoryRateLimitSubsystem::Submit(const UObject* connection, int32 numEntries, TFunction<void()> request)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	const UInventoryRateLimitSettings* settings = GetDefault<UInventoryRateLimitSettings>();
+	if (!settings->bEnableRateLimiting || connection == nullptr)
+	{
+		Stats.ExecutedRequests++;
+		request();
+		return EInventoryRequestAdmission::Executed;
+	}
+
+	FConnectionBudget& budget = Connections.FindOrAdd(connection);
+
+	// Could never collect enough tokens
+	if (numEntries > settings->EntryBurst)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Dropping inventory request of %i entries; the limit is %i."), numEntries, settings->EntryBurst);
+		budget.NumThrottled++;
+		Stats.DroppedRequests++;
+		return EInventoryRequestAdmission::Dropped;
+	}
+
+	// Anything already waiting goes first, so this request cannot overtake it
+	const ELimit limit = budget.Deferred.Num() > 0 ? ELimit::Frame : TryAdmit(budget, numEntries, FPlatformTime::Seconds());
+	if (limit == ELimit::None)
+	{
+		Stats.ExecutedRequests++;
+		request();
+		return EInventoryRequestAdmission::Executed;
+	}
+
+	budget.NumThrottled++;
+
+	if ((limit == ELimit::Connection && settings->ThrottlePolicy == EInventoryThrottlePolicy::Drop) || budget.Deferred.Num() >= settings->MaxDeferredRequestsPerConnection)
+	{
+		Stats.DroppedRequests++;
+		return EInventoryRequestAdmission::Dropped;
+	}
+
+	FDeferredRequest& deferred = budget.Deferred.AddDefaulted_GetRef();
+	deferred.NumEntries = numEntries;
+	deferred.Request = MoveTemp(request);
+	Stats.DeferredRequests++;
+	return EInventoryRequestAdmission::Deferred;
+}
+
+UInventoryRateLimitSubsystem::ELimit UInventoryRateLimitSubsystem::TryAdmit(FConnectionBudget& budget, int32 numEntries, double now)
+{
+	const UInventoryRateLimitSettings* settings = GetDefault<UInventoryRateLimitSettings>();
+
+	budget.RequestTokens.Refill(settings->RequestsPerSecond, settings->RequestBurst, now);
+	budget.EntryTokens.Refill(settings->EntriesPerSecond, settings->EntryBurst, now);
+
+	if (budget.RequestTokens.Tokens < 1.0 || budget.EntryTokens.Tokens < numEntries)
+	{
+		return ELimit::Connection;
+	}
+
+	// An empty request costs nothing here, but one over-budget request still runs on an otherwise idle frame
+	if (FrameEntriesUsed > 0 && FrameEntriesUsed + numEntries > settings->FrameEntryBudget)
+	{
+		return ELimit::Frame;
+	}
+
+	budget.RequestTokens.Tokens -= 1.0;
+	budget.EntryTokens.Tokens -= numEntries;
+	FrameEntriesUsed += numEntries;
+	return ELimit::None;
+}
+
+bool UInventoryRateLimitSubsystem::Tick(float deltaTime)
+{
+	FrameEntriesUsed = 0;
+
+	const double now = FPlatformTime::Seconds();
+	TArray<TFunction<void()>> readyRequests;
+
+	// Round robin, one request per connection per pass, so one busy connection cannot starve the rest
+	bool bMadeProgress = true;
+	while (bMadeProgress)
+	{
+		bMadeProgress = false;
+		for (auto it = Connections.CreateIterator(); it; ++it)
+		{
+			FConnectionBudget& budget = it.Value();
+			if (!it.Key().IsValid())
+			{
+				Stats.DroppedRequests += budget.Deferred.Num();
+				it.RemoveCurrent();
+				continue;
+			}
+
+			if (budget.Deferred.Num() == 0 || TryAdmit(budget, budget.Deferred[0].NumEntries, now) != ELimit::None)
+			{
+				continue;
+			}
+
+			readyRequests.Add(MoveTemp(budget.Deferred[0].Request));
+			budget.Deferred.RemoveAt(0, 1, false);
+			bMadeProgress = true;
+		}
+	}
+
+	// Run outside the loop so a request cannot change the connection map while it is being iterated
+	for (TFunction<void()>& request : readyRequests)
+	{
+		Stats.ExecutedRequests++;
+		request();
+	}
+
+	return true;
+}
+
+FInventoryRateLimitStats UInventoryRateLimitSubsystem::GetStats() const
+{
+	FInventoryRateLimitStats stats = Stats;
+	stats.QueuedRequests = 0;
+	for (const auto& pair : Connections)
+	{
+		stats.QueuedRequests += pair.Value.Deferred.Num();
+	}
+	return stats;
+}
+
+void UInventoryRateLimitSubsystem::ResetStats()
+{
+	Stats = FInventoryRateLimitStats();
+	for (auto& pair : Connections)
+	{
+		pair.Value.NumThrottled = 0;
+	}
+}
+
+int32 UInventoryRateLimitSubsystem::GetThrottledCount(const UObject* connection) const
+{
+	const FConnectionBudget* budget = Connections.Find(connection);
+	return budget ? budget->NumThrottled : 0;
+}
@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryRecipeEvaluator.h"
+#include "InventoryInterface.h"
+#include "Math/VectorRegister.h"
+#include "InventoryMemory.h"
+
+FInventoryRecipeEvaluator::FInventoryRecipeEvaluator() : NumColumns(0)
+{
+}
+
+void FInventoryRecipeEvaluator::Compile(const TArray<FInventoryRecipe>& recipes)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	ItemColumns.Reset();
+	for (const FInventoryRecipe& recipe : recipes)
+	{
+		for (const FInventoryEntry& ingredient : recipe.Ingredients)
+		{
+			if (ingredient.Quantity > 0 && !ItemColumns.Contains(ingredient.ItemCode))
+			{
+				ItemColumns.Add(ingredient.ItemCode, ItemColumns.Num());
+			}
+		}
+	}
+
+	NumColumns = Align(ItemColumns.Num(), 4);
+	const int32 numRecipes = recipes.Num();
+
+	Requirements.Reset();
+	Requirements.SetNumZeroed(numRecipes * NumColumns);
+	Quantities.Reset();
+	Quantities.SetNumZeroed(NumColumns);
+
+	RecipeIds.Reset(numRecipes);
+	RecipeIngredients.Reset();
+	RecipeIngredients.SetNum(numRecipes);
+	ColumnRecipes.Reset();
+	ColumnRecipes.SetNum(NumColumns);
+
+	for (int32 recipeIndex = 0; recipeIndex < numRecipes; recipeIndex++)
+	{
+		const FInventoryRecipe& recipe = recipes[recipeIndex];
+		RecipeIds.Add(recipe.RecipeId);
+
+		int32* row = Requirements.GetData() + recipeIndex * NumColumns;
+		for (const FInventoryEntry& ingredient : recipe.Ingredients)
+		{
+			if (ingredient.Quantity <= 0)
+			{
+				continue;
+			}
+
+			const int32 column = ItemColumns[ingredient.ItemCode];
+			if (row[column] == 0)
+			{
+				ColumnRecipes[column].Add(recipeIndex);
+			}
+
+			// The same item listed twice needs both amounts
+			row[column] = (int32)FMath::Min<int64>((int64)row[column] + ingredient.Quantity, MAX_int32);
+		}
+
+		for (int32 column = 0; column < NumColumns; column++)
+		{
+			if (row[column] > 0)
+			{
+				RecipeIngredients[recipeIndex].Emplace(column, row[column]);
+			}
+		}
+	}
+
+	Craftable.Init(false, numRecipes);
+	MaxCraftable.Reset();
+	MaxCraftable.SetNumZeroed(numRecipes);
+
+	// Everything is dirty until the first evaluation
+	DirtyRecipes.Init(true, numRecipes);
+	DirtyRecipeList.Reset(numRecipes);
+	for (int32 recipeIndex = 0; recipeIndex < numRecipes; recipeIndex++)
+	{
+		DirtyRecipeList.Add(recipeIndex);
+	}
+}
+
+void FInventoryRecipeEvaluator::Refresh(const IInventoryInterface& inventory)
+{
+	// One lookup per distinct item instead of one per ingredient per recipe
+	for (const auto& pair : ItemColumns)
+	{
+		Quantities[pair.Value] = FMath::Max(inventory.GetQuantityFor(pair.Key), 0);
+	}
+
+	DirtyRecipes.Init(false, RecipeIds.Num());
+	DirtyRecipeList.Reset();
+	for (int32 recipeIndex = 0; recipeIndex < RecipeIds.Num(); recipeIndex++)
+	{
+		Craftable[recipeIndex] = EvaluateRecipe(recipeIndex);
+		MaxCraftable[recipeIndex] = Craftable[recipeIndex] ? ComputeMaxCraftable(recipeIndex) : 0;
+	}
+}
+
+void FInventoryRecipeEvaluator::OnQuantityChanged(const FName itemCode, int32 newQuantity)
+{
+	const int32* column = ItemColumns.Find(itemCode);
+	if (column == nullptr)
+	{
+		return;
+	}
+
+	newQuantity = FMath::Max(newQuantity, 0);
+	if (Quantities[*column] == newQuantity)
+	{
+		return;
+	}
+
+	Quantities[*column] = newQuantity;
+	for (int32 recipeIndex : ColumnRecipes[*column])
+	{
+		if (!DirtyRecipes[recipeIndex])
+		{
+			DirtyRecipes[recipeIndex] = true;
+			DirtyRecipeList.Add(recipeIndex);
+		}
+	}
+}
+
+void FInventoryRecipeEvaluator::ApplyChanges(const FInventoryChangeSet& changeSet)
+{
+	for (const FInventoryQuantityChange& change : changeSet.Added)
+	{
+		OnQuantityChanged(change.ItemCode, change.NewQuantity);
+	}
+	for (const FInventoryQuantityChange& change : changeSet.Changed)
+	{
+		OnQuantityChanged(change.ItemCode, change.NewQuantity);
+	}
+	for (const FName& itemCode : changeSet.Removed)
+	{
+		OnQuantityChanged(itemCode, 0);
+	}
+}
+
+int32 FInventoryRecipeEvaluator::Evaluate()
+{
+	const int32 numEvaluated = DirtyRecipeList.Num();
+	for (int32 recipeIndex : DirtyRecipeList)
+	{
+		DirtyRecipes[recipeIndex] = false;
+		Craftable[recipeIndex] = EvaluateRecipe(recipeIndex);
+		MaxCraftable[recipeIndex] = Craftable[recipeIndex] ? ComputeMaxCraftable(recipeIndex) : 0;
+	}
+
+	DirtyRecipeList.Reset();
+	return numEvaluated;
+}
+
+bool FInventoryRecipeEvaluator::EvaluateRecipe(int32 recipeIndex) const
+{
+	const int32* needed = Requirements.GetData() + recipeIndex * NumColumns;
+	const int32* held = Quantities.GetData();
+
+	// Unused columns need zero, which every (non-negative) quantity satisfies
+	for (int32 column = 0; column < NumColumns; column += 4)
+	{
+		const VectorRegisterInt enough = VectorIntCompareGE(VectorIntLoadAligned(held + column), VectorIntLoadAligned(needed + column));
+		if (VectorMaskBits(VectorCastIntToFloat(enough)) != 0xF)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 FInventoryRecipeEvaluator::ComputeMaxCraftable(int32 recipeIndex) const
+{
+	int32 maxCount = MAX_int32;
+	for (const TPair<int32, int32>& ingredient : RecipeIngredients[recipeIndex])
+	{
+		maxCount = FMath::Min(maxCount, Quantities[ingredient.Key] / ingredient.Value);
+	}
+	return maxCount;
+}
+
+int32 FInventoryRecipeEvaluator::NumRecipes() const
+{
+	return RecipeIds.Num();
+}
+
+int32 FInventoryRecipeEvaluator::FindRecipe(const FName recipeId) const
+{
+	return RecipeIds.Find(recipeId);
+}
+
+const TBitArray<>& FInventoryRecipeEvaluator::GetCraftableMask() const
+{
+	return Craftable;
+}
+
+bool FInventoryRecipeEvaluator::CanCraft(int32 recipeIndex) const
+{
+	return Craftable.IsValidIndex(recipeIndex) && Craftable[recipeIndex];
+}
+
+int32 FInventoryRecipeEvaluator::GetMaxCraftable(int32 recipeIndex) const
+{
+	return MaxCraftable.IsValidIndex(recipeIndex) ? MaxCraftable[recipeIndex] : 0;
+}
+
+SIZE_T FInventoryRecipeEvaluator::GetAllocatedSize() const
+{
+	SIZE_T size = ItemColumns.GetAllocatedSize() + Requirements.GetAllocatedSize() + Quantities.GetAllocatedSize()
+		+ RecipeIngredients.GetAllocatedSize() + ColumnRecipes.GetAllocatedSize() + RecipeIds.GetAllocatedSize()
+		+ DirtyRecipes.GetAllocatedSize() + DirtyRecipeList.GetAllocatedSize() + Craftable.GetAllocatedSize() + MaxCraftable.GetAllocatedSize();
+
+	for (const TArray<TPair<int32, int32>>& ingredients : RecipeIngredients)
+	{
+		size += ingredients.GetAllocatedSize();
+	}
+	for (const TArray<int32>& recipes : ColumnRecipes)
+	{
+		size += recipes.GetAllocatedSize();
+	}
+	return size;
+}
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryReplayCommandlet.h"
+#include "Inventory.h"
+#include "ReplicationInventoryComponent.h"
+#include "InventoryTrace.h"
+#include "InventoryStateHash.h"
+#include "InventoryPersistence.h"
+#include "FileInventoryPersistenceBackend.h"
+#include "SQLiteInventoryPersistenceBackend.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "Misc/Crc.h"
+
+namespace
+{
+	// One replayed inventory; exactly one of the two is set, depending on -Storage
+	struct FReplayInventory
+	{
+		UReplicationInventoryComponent* Component = nullptr;
+		UInventory* Inventory = nullptr;
+
+		void Apply(const TArray<FInventoryEntry>& changes)
+		{
+			if (Component)
+			{
+				Component->ModifyGroupOfEntries(changes);
+			}
+			else
+			{
+				Inventory->ModifyGroupOfEntries(changes);
+			}
+		}
+
+		void GetEntries(TArray<FInventoryEntry>& outEntries) const
+		{
+			if (Component)
+			{
+				Component->GetEntries(outEntries);
+				return;
+			}
+
+			outEntries.Reset(Inventory->Num());
+			for (const auto& pair : Inventory->GetEntryMap())
+			{
+				outEntries.Emplace(pair.Key, pair.Value);
+			}
+		}
+
+		UObject* GetObject() const
+		{
+			return Component ? (UObject*)Component : (UObject*)Inventory;
+		}
+	};
+
+	double GetPercentile(const TArray<double>& sortedValues, double percentile)
+	{
+		if (sortedValues.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 index = FMath::Clamp(FMath::CeilToInt(percentile / 100.0 * sortedValues.Num()) - 1, 0, sortedValues.Num() - 1);
+		return sortedValues[index];
+	}
+}
+
+UInventoryReplayCommandlet::UInventoryReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UInventoryReplayCommandlet::Main(const FString& Params)
+{
+	FString tracePath;
+	if (!FParse::Value(*Params, TEXT("Trace="), tracePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=InventoryReplay -Trace=<file> [-Storage=Replication|Inventory] [-Backend=None|File|SQLite] [-BackendPath=<path>] [-RealTime] [-IncludeClientOps]"));
+		return 1;
+	}
+
+	FString storage = TEXT("Replication");
+	FString backendName = TEXT("None");
+	FString backendPath;
+	FParse::Value(*Params, TEXT("Storage="), storage);
+	FParse::Value(*Params, TEXT("Backend="), backendName);
+	FParse::Value(*Params, TEXT("BackendPath="), backendPath);
+	const bool bRealTime = FParse::Param(*Params, TEXT("RealTime"));
+	const bool bIncludeClientOps = FParse::Param(*Params, TEXT("IncludeClientOps"));
+	const bool bUseComponents = storage != TEXT("Inventory");
+
+	FInventoryTraceReader reader;
+	if (!reader.Open(tracePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open inventory trace %s."), *tracePath);
+		return 1;
+	}
+
+	TSharedPtr<IInventoryPersistenceBackend, ESPMode::ThreadSafe> backend;
+	if (backendName == TEXT("File"))
+	{
+		backend = MakeShared<FFileInventoryPersistenceBackend, ESPMode::ThreadSafe>(backendPath.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("InventoryReplay") : backendPath);
+	}
+	else if (backendName == TEXT("SQLite"))
+	{
+		TSharedPtr<FSQLiteInventoryPersistenceBackend, ESPMode::ThreadSafe> database = MakeShared<FSQLiteInventoryPersistenceBackend, ESPMode::ThreadSafe>(backendPath.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("InventoryReplay.db") : backendPath);
+		if (!database->IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not open SQLite database for replay."));
+			return 1;
+		}
+		backend = database;
+	}
+
+	const FWriteBehindSettings writeBehindSettings;
+	TUniquePtr<FWriteBehindInventoryWriter> writer;
+	if (backend.IsValid())
+	{
+		writer = MakeUnique<FWriteBehindInventoryWriter>(backend.ToSharedRef(), writeBehindSettings);
+	}
+
+	TMap<FString, FReplayInventory> inventories;
+	TSet<FString> dirtyInventories;
+	TArray<double> latencies;
+	int64 numEntries = 0;
+	int32 numSkipped = 0;
+	double lastCollectTime = 0.0;
+
+	// Collected on trace time, like the persistence subsystem would on game time
+	auto collectDirty = [&]()
+	{
+		TArray<FInventoryPersistenceRecord> batch;
+		for (const FString& inventoryId : dirtyInventories)
+		{
+			FInventoryPersistenceRecord& record = batch.AddDefaulted_GetRef();
+			record.InventoryId = inventoryId;
+			inventories[inventoryId].GetEntries(record.Entries);
+		}
+		dirtyInventories.Reset();
+		writer->Enqueue(MoveTemp(batch));
+	};
+
+	const double startTime = FPlatformTime::Seconds();
+	FInventoryTraceEvent event;
+	TArray<FInventoryEntry> changes;
+
+	while (reader.Next(event))
+	{
+		if (event.Op == EInventoryTraceOp::ClientModify && !bIncludeClientOps)
+		{
+			numSkipped++;
+			continue;
+		}
+
+		if (bRealTime)
+		{
+			const double waitSeconds = startTime + event.Time - FPlatformTime::Seconds();
+			if (waitSeconds > 0.0)
+			{
+				FPlatformProcess::Sleep(waitSeconds);
+			}
+		}
+
+		FReplayInventory* inventory = inventories.Find(event.InventoryId);
+		if (inventory == nullptr)
+		{
+			inventory = &inventories.Add(event.InventoryId);
+			if (bUseComponents)
+			{
+				inventory->Component = NewObject<UReplicationInventoryComponent>();
+			}
+			else
+			{
+				inventory->Inventory = NewObject<UInventory>();
+			}
+			inventory->GetObject()->AddToRoot();
+		}
+
+		changes = event.Entries;
+		if (event.Op == EInventoryTraceOp::Remove)
+		{
+			for (FInventoryEntry& entry : changes)
+			{
+				entry.Quantity = -entry.Quantity;
+			}
+		}
+
+		const uint64 applyStart = FPlatformTime::Cycles64();
+		inventory->Apply(changes);
+		latencies.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - applyStart) * 1000.0);
+		numEntries += changes.Num();
+
+		if (writer.IsValid())
+		{
+			dirtyInventories.Add(event.InventoryId);
+			if (event.Time - lastCollectTime >= writeBehindSettings.FlushIntervalSeconds || dirtyInventories.Num() >= writeBehindSettings.DirtyCountThreshold)
+			{
+				collectDirty();
+				lastCollectTime = event.Time;
+			}
+		}
+	}
+
+	const double applySeconds = FPlatformTime::Seconds() - startTime;
+
+	// Writes still count towards the run: the trace is not done until storage has caught up
+	if (writer.IsValid())
+	{
+		collectDirty();
+		writer->Shutdown();
+	}
+	const double totalSeconds = FPlatformTime::Seconds() - startTime;
+
+	if (reader.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Inventory trace %s is corrupt; results cover the events before the error."), *tracePath);
+	}
+
+	// Order-independent per inventory, combined in id order so the result does not depend on map layout
+	TArray<FString> inventoryIds;
+	inventories.GenerateKeyArray(inventoryIds);
+	inventoryIds.Sort();
+
+	uint64 checksum = 0;
+	TArray<FInventoryEntry> entries;
+	for (const FString& inventoryId : inventoryIds)
+	{
+		FReplayInventory& inventory = inventories[inventoryId];
+		inventory.GetEntries(entries);
+
+		FInventoryStateHash stateHash;
+		for (const FInventoryEntry& entry : entries)
+		{
+			stateHash.OnQuantityChanged(entry.ItemCode, 0, entry.Quantity);
+		}
+
+		checksum = (checksum * 1099511628211ull) ^ (stateHash.GetHash() + FCrc::StrCrc32(*inventoryId));
+		inventory.GetObject()->RemoveFromRoot();
+	}
+
+	latencies.Sort();
+	const int32 numEvents = latencies.Num();
+
+	UE_LOG(LogTemp, Display, TEXT("Replayed %s: %i events (%lld entries, %i client events skipped) on %i inventories, storage %s, backend %s%s."),
+		*tracePath, numEvents, numEntries, numSkipped, inventories.Num(), *storage, *backendName, bRealTime ? TEXT(", real time") : TEXT(""));
+	UE_LOG(LogTemp, Display, TEXT("Apply time %.3f s, total with persistence %.3f s. Throughput %.0f events/s, %.0f entries/s."),
+		applySeconds, totalSeconds, numEvents / FMath::Max(totalSeconds, 1e-9), numEntries / FMath::Max(totalSeconds, 1e-9));
+	UE_LOG(LogTemp, Display, TEXT("Apply latency (us): p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f, max %.2f."),
+		GetPercentile(latencies, 50.0), GetPercentile(latencies, 90.0), GetPercentile(latencies, 99.0), GetPercentile(latencies, 99.9), numEvents > 0 ? latencies.Last() : 0.0);
+	UE_LOG(LogTemp, Display, TEXT("Final state checksum: %016llx"), checksum);
+
+	return reader.IsError() ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryScaleCommandlet.h"
+#include "ReplicationInventoryComponent.h"
+#include "RPCBasedInventoryComponent.h"
+#include "InventorySimulatedServer.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	constexpr float ScaleFrameSeconds = 1.0f / 30.0f;
+
+	struct FScaleResult
+	{
+		int32 NumActors = 0;
+		int32 NumClients = 0;
+		double SpawnSeconds = 0.0;
+		double AverageFrameMs = 0.0;
+		double P99FrameMs = 0.0;
+		double MaxFrameMs = 0.0;
+		double AverageMutateMs = 0.0;
+		double AverageReplicationMs = 0.0;
+		double AverageBytesSent = 0.0;
+		double AverageBytesPerClient = 0.0;
+		uint64 InventoryBytes = 0;
+		uint64 ProcessBytes = 0;
+	};
+
+	double GetPercentile(const TArray<double>& sortedValues, double percentile)
+	{
+		if (sortedValues.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 index = FMath::Clamp(FMath::CeilToInt(percentile / 100.0 * sortedValues.Num()) - 1, 0, sortedValues.Num() - 1);
+		return sortedValues[index];
+	}
+
+	// Restores the category's verbosity when the run ends, so the rest of the process logs as configured
+	struct FScopedLogVerbosity
+	{
+		FScopedLogVerbosity(FLogCategoryBase& category, ELogVerbosity::Type verbosity) : Category(category), Previous(category.GetVerbosity())
+		{
+			Category.SetVerbosity(verbosity);
+		}
+
+		~FScopedLogVerbosity()
+		{
+			Category.SetVerbosity(Previous);
+		}
+
+		FLogCategoryBase& Category;
+		ELogVerbosity::Type Previous;
+	};
+
+	// Each inventory belongs to one client, the way a player's inventory replicates to that player
+	UActorComponent* SpawnInventoryActor(FInventorySimulatedServer& server, int32 clientIndex, bool bUseRPC)
+	{
+		AActor* actor = server.SpawnActor(clientIndex);
+
+		UActorComponent* component = bUseRPC
+			? (UActorComponent*)NewObject<URPCBasedInventoryComponent>(actor)
+			: (UActorComponent*)NewObject<UReplicationInventoryComponent>(actor);
+		component->SetIsReplicated(true);
+		component->RegisterComponent();
+		return component;
+	}
+
+	FInventoryMemoryUsage GetMemoryUsage(const UActorComponent* component)
+	{
+		if (const URPCBasedInventoryComponent* rpcComponent = Cast<URPCBasedInventoryComponent>(component))
+		{
+			return rpcComponent->GetMemoryUsage();
+		}
+		return CastChecked<UReplicationInventoryComponent>(component)->GetMemoryUsage();
+	}
+
+	FScaleResult RunScale(FInventorySimulatedServer& server, int32 numActors, bool bUseRPC, int32 numFrames, float mutationRate, int32 itemsPerInventory, const TArray<FName>& itemPool, FRandomStream& random)
+	{
+		FScaleResult result;
+		result.NumActors = numActors;
+		result.NumClients = server.NumClients();
+
+		const double spawnStart = FPlatformTime::Seconds();
+		TArray<UActorComponent*> components;
+		components.Reserve(numActors);
+		TArray<FInventoryEntry> changes;
+		for (int32 i = 0; i < numActors; i++)
+		{
+			UActorComponent* component = SpawnInventoryActor(server, result.NumClients > 0 ? i % result.NumClients : INDEX_NONE, bUseRPC);
+			components.Add(component);
+
+			changes.Reset(itemsPerInventory);
+			for (int32 j = 0; j < itemsPerInventory; j++)
+			{
+				changes.Emplace(itemPool[random.RandHelper(itemPool.Num())], random.RandRange(1, 100));
+			}
+			CastChecked<IInventoryInterface>(component)->ModifyInventory(changes);
+		}
+		result.SpawnSeconds = FPlatformTime::Seconds() - spawnStart;
+
+		// The first frames send every inventory in full, which is part of the cost being measured
+		UWorld* world = server.GetWorld();
+		UInventorySimulatedNetDriver* netDriver = server.GetNetDriver();
+		const double replicationStart = netDriver ? netDriver->ReplicationSeconds : 0.0;
+		const int64 bytesStart = server.GetBytesSent();
+
+		const int32 mutationsPerFrame = FMath::Max(1, FMath::RoundToInt(numActors * mutationRate));
+		TArray<double> frameTimes;
+		frameTimes.Reserve(numFrames);
+		double totalMutateSeconds = 0.0;
+
+		for (int32 frame = 0; frame < numFrames; frame++)
+		{
+			const double frameStart = FPlatformTime::Seconds();
+
+			for (int32 i = 0; i < mutationsPerFrame; i++)
+			{
+				changes.Reset(2);
+				changes.Emplace(itemPool[random.RandHelper(itemPool.Num())], random.RandRange(-20, 20));
+				changes.Emplace(itemPool[random.RandHelper(itemPool.Num())], random.RandRange(1, 5));
+
+				const double mutateStart = FPlatformTime::Seconds();
+				CastChecked<IInventoryInterface>(components[random.RandHelper(components.Num())])->ModifyInventory(changes);
+				totalMutateSeconds += FPlatformTime::Seconds() - mutateStart;
+			}
+
+			// Timers only run once per engine frame, and nothing else advances the frame counter here
+			GFrameCounter++;
+
+			// Timers (change broadcasts, counter and instance data flushes), the plugin's subsystems, and replication
+			// to the clients in the net driver's TickFlush
+			world->Tick(LEVELTICK_All, ScaleFrameSeconds);
+			FTicker::GetCoreTicker().Tick(ScaleFrameSeconds);
+
+			frameTimes.Add((FPlatformTime::Seconds() - frameStart) * 1000.0);
+		}
+
+		for (const UActorComponent* component : components)
+		{
+			result.InventoryBytes += GetMemoryUsage(component).AllocatedBytes;
+		}
+		result.ProcessBytes = FPlatformMemory::GetStats().UsedPhysical;
+
+		double totalFrameMs = 0.0;
+		for (double frameTime : frameTimes)
+		{
+			totalFrameMs += frameTime;
+		}
+		frameTimes.Sort();
+		const int32 frames = FMath::Max(numFrames, 1);
+		result.AverageFrameMs = totalFrameMs / frames;
+		result.P99FrameMs = GetPercentile(frameTimes, 99.0);
+		result.MaxFrameMs = frameTimes.Num() > 0 ? frameTimes.Last() : 0.0;
+		result.AverageMutateMs = totalMutateSeconds * 1000.0 / frames;
+		result.AverageReplicationMs = netDriver ? (netDriver->ReplicationSeconds - replicationStart) * 1000.0 / frames : 0.0;
+		result.AverageBytesSent = (double)(server.GetBytesSent() - bytesStart) / frames;
+		result.AverageBytesPerClient = result.NumClients > 0 ? result.AverageBytesSent / result.NumClients : 0.0;
+		return result;
+	}
+}
+
+UInventoryScaleCommandlet::UInventoryScaleCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UInventoryScaleCommandlet::Main(const FString& Params)
+{
+	FString countsParam = TEXT("1000,5000,10000,25000,50000");
+	FString componentName = TEXT("Replication");
+	FString label = TEXT("default");
+	FString csvPath = FPaths::ProjectSavedDir() / TEXT("InventoryScale.csv");
+	int32 numFrames = 300;
+	int32 numClients = 64;
+	float mutationRate = 0.05f;
+	int32 itemsPerInventory = 32;
+	int32 seed = 1;
+	FParse::Value(*Params, TEXT("Counts="), countsParam);
+	FParse::Value(*Params, TEXT("Component="), componentName);
+	FParse::Value(*Params, TEXT("Label="), label);
+	FParse::Value(*Params, TEXT("Csv="), csvPath);
+	FParse::Value(*Params, TEXT("Frames="), numFrames);
+	FParse::Value(*Params, TEXT("Clients="), numClients);
+	FParse::Value(*Params, TEXT("MutationRate="), mutationRate);
+	FParse::Value(*Params, TEXT("ItemsPerInventory="), itemsPerInventory);
+	FParse::Value(*Params, TEXT("Seed="), seed);
+
+	const bool bUseRPC = componentName == TEXT("RPC");
+	if (!bUseRPC && componentName != TEXT("Replication"))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=InventoryScale [-Counts=1000,5000,...] [-Component=Replication|RPC] [-Clients=64] [-Frames=300] [-MutationRate=0.05] [-ItemsPerInventory=32] [-Seed=1] [-Label=<name>] [-Csv=<file>]"));
+		return 1;
+	}
+
+	// Removals are logged at Log verbosity, once per change
+	FScopedLogVerbosity logVerbosity(LogTemp, ELogVerbosity::Display);
+
+	TArray<FString> countStrings;
+	countsParam.ParseIntoArray(countStrings, TEXT(","));
+
+	TArray<FName> itemPool;
+	for (int32 i = 0; i < 256; i++)
+	{
+		itemPool.Add(FName(*FString::Printf(TEXT("ScaleItem%i"), i)));
+	}
+
+	// Appended, so runs of different versions and configurations end up in one table
+	if (!IFileManager::Get().FileExists(*csvPath))
+	{
+		FFileHelper::SaveStringToFile(TEXT("Label,Component,Actors,Clients,Frames,MutationRate,ItemsPerInventory,SpawnSeconds,AvgFrameMs,P99FrameMs,MaxFrameMs,AvgMutateMs,AvgReplicationMs,AvgBytesSentPerFrame,AvgBytesPerClientPerFrame,InventoryMB,ProcessMB\n"), *csvPath);
+	}
+
+	FRandomStream random(seed);
+	for (const FString& countString : countStrings)
+	{
+		const int32 numActors = FCString::Atoi(*countString);
+		if (numActors <= 0)
+		{
+			continue;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Running %i frames with %i %s inventories and %i clients..."), numFrames, numActors, *componentName, numClients);
+		FScaleResult result;
+		{
+			FInventorySimulatedServer server(numClients);
+			result = RunScale(server, numActors, bUseRPC, numFrames, mutationRate, itemsPerInventory, itemPool, random);
+		}
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		UE_LOG(LogTemp, Display, TEXT("%i actors, %i clients: frame %.2f ms (p99 %.2f, max %.2f), mutate %.2f ms, replication %.2f ms, %.0f bytes sent per frame (%.0f per client), inventories %.1f MB."),
+			result.NumActors, result.NumClients, result.AverageFrameMs, result.P99FrameMs, result.MaxFrameMs, result.AverageMutateMs, result.AverageReplicationMs, result.AverageBytesSent, result.AverageBytesPerClient, result.InventoryBytes / (1024.0 * 1024.0));
+
+		const FString row = FString::Printf(TEXT("%s,%s,%i,%i,%i,%.4f,%i,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.0f,%.0f,%.2f,%.2f\n"),
+			*label, *componentName, result.NumActors, result.NumClients, numFrames, mutationRate, itemsPerInventory, result.SpawnSeconds,
+			result.AverageFrameMs, result.P99FrameMs, result.MaxFrameMs, result.AverageMutateMs, result.AverageReplicationMs, result.AverageBytesSent, result.AverageBytesPerClient,
+			result.InventoryBytes / (1024.0 * 1024.0), result.ProcessBytes / (1024.0 * 1024.0));
+		FFileHelper::SaveStringToFile(row, *csvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Results appended to %s."), *csvPath);
+	return 0;
+}
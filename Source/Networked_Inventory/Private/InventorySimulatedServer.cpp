@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventorySimulatedServer.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+	// Fast enough that the server's own limits, not the link, decide what is sent
+	constexpr int32 SimulatedConnectionSpeed = 100 * 1024 * 1024;
+}
+
+void UInventorySimulatedConnection::InitConnection(UNetDriver* InDriver, EConnectionState InState, const FURL& InURL, int32 InConnectionSpeed, int32 InMaxPacket)
+{
+	InternalAck = true;
+
+	Super::InitConnection(InDriver, InState, InURL, InConnectionSpeed, InMaxPacket);
+	InitSendBuffer();
+}
+
+void UInventorySimulatedConnection::LowLevelSend(void* Data, int32 CountBits, FOutPacketTraits& Traits)
+{
+	BytesSent += FMath::DivideAndRoundUp(CountBits, 8);
+}
+
+FString UInventorySimulatedConnection::LowLevelGetRemoteAddress(bool bAppendPort)
+{
+	return GetName();
+}
+
+FString UInventorySimulatedConnection::LowLevelDescribe()
+{
+	return FString::Printf(TEXT("Simulated client %s"), *GetName());
+}
+
+UInventorySimulatedNetDriver::UInventorySimulatedNetDriver()
+{
+	NetConnectionClass = UInventorySimulatedConnection::StaticClass();
+}
+
+bool UInventorySimulatedNetDriver::IsAvailable() const
+{
+	return true;
+}
+
+bool UInventorySimulatedNetDriver::InitConnect(FNetworkNotify* InNotify, const FURL& ConnectURL, FString& Error)
+{
+	Error = TEXT("Simulated net drivers can only listen.");
+	return false;
+}
+
+bool UInventorySimulatedNetDriver::InitListen(FNetworkNotify* InNotify, FURL& ListenURL, bool bReuseAddressAndPort, FString& Error)
+{
+	return InitBase(false, InNotify, ListenURL, bReuseAddressAndPort, Error);
+}
+
+FString UInventorySimulatedNetDriver::LowLevelGetNetworkNumber()
+{
+	return TEXT("Simulated");
+}
+
+bool UInventorySimulatedNetDriver::IsNetResourceValid()
+{
+	return true;
+}
+
+void UInventorySimulatedNetDriver::TickFlush(float DeltaSeconds)
+{
+	// The clients never send anything, and replication skips connections that have gone quiet
+	for (UNetConnection* connection : ClientConnections)
+	{
+		connection->LastReceiveTime = GetElapsedTime();
+		connection->LastReceiveRealtime = FPlatformTime::Seconds();
+	}
+
+	const double start = FPlatformTime::Seconds();
+	Super::TickFlush(DeltaSeconds);
+	ReplicationSeconds += FPlatformTime::Seconds() - start;
+}
+
+UInventorySimulatedConnection* UInventorySimulatedNetDriver::AddSimulatedClient()
+{
+	UInventorySimulatedConnection* connection = NewObject<UInventorySimulatedConnection>(this);
+	connection->InitConnection(this, USOCK_Open, FURL(), SimulatedConnectionSpeed);
+	connection->SetClientLoginState(EClientLoginState::Welcomed);
+	connection->SetClientWorldPackageName(World->GetOutermost()->GetFName());
+	AddClientConnection(connection);
+
+	APlayerController* controller = World->SpawnActor<APlayerController>();
+	controller->Player = connection;
+	controller->NetConnection = connection;
+	connection->PlayerController = controller;
+	connection->OwningActor = controller;
+	return connection;
+}
+
+FInventorySimulatedServer::FInventorySimulatedServer(int32 numClients)
+	: World(nullptr), NetDriver(nullptr)
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("InventorySimulatedServer"));
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(World);
+
+	if (numClients > 0)
+	{
+		NetDriver = NewObject<UInventorySimulatedNetDriver>(GetTransientPackage());
+		NetDriver->NetDriverName = NAME_GameNetDriver;
+
+		FURL listenUrl;
+		FString error;
+		if (!NetDriver->InitListen(World, listenUrl, false, error))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not start the simulated net driver: %s"), *error);
+			NetDriver = nullptr;
+		}
+		else
+		{
+			// Registered with the world context as well, which is how newly spawned actors reach the driver
+			NetDriver->SetWorld(World);
+			World->SetNetDriver(NetDriver);
+			worldContext.ActiveNetDrivers.Add(FNamedNetDriver(NetDriver, nullptr));
+		}
+	}
+
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	for (int32 i = 0; NetDriver != nullptr && i < numClients; i++)
+	{
+		Connections.Add(NetDriver->AddSimulatedClient());
+	}
+}
+
+FInventorySimulatedServer::~FInventorySimulatedServer()
+{
+	if (NetDriver != nullptr)
+	{
+		World->SetNetDriver(nullptr);
+		GEngine->DestroyNamedNetDriver(World, NetDriver->NetDriverName);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+UWorld* FInventorySimulatedServer::GetWorld() const
+{
+	return World;
+}
+
+UInventorySimulatedNetDriver* FInventorySimulatedServer::GetNetDriver() const
+{
+	return NetDriver;
+}
+
+int32 FInventorySimulatedServer::NumClients() const
+{
+	return Connections.Num();
+}
+
+AActor* FInventorySimulatedServer::SpawnActor(int32 clientIndex)
+{
+	FActorSpawnParameters spawnParameters;
+	if (Connections.IsValidIndex(clientIndex))
+	{
+		spawnParameters.Owner = Connections[clientIndex]->PlayerController;
+	}
+
+	AActor* actor = World->SpawnActor<AActor>(spawnParameters);
+	actor->SetReplicates(true);
+	return actor;
+}
+
+int64 FInventorySimulatedServer::GetBytesSent() const
+{
+	int64 bytesSent = 0;
+	for (const UInventorySimulatedConnection* connection : Connections)
+	{
+		bytesSent += connection->BytesSent;
+	}
+	return bytesSent;
+}
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "InventorySimulatedServer.generated.h"
+
+class APlayerController;
+
+/**
+ * Client connection with no client behind it. Everything sent is counted and discarded, and acknowledged as soon as
+ * it is sent (like a replay connection), so reliable traffic never backs up waiting for acks.
+ */
+UCLASS(Transient, NotBlueprintable)
+class UInventorySimulatedConnection : public UNetConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitConnection(UNetDriver* InDriver, EConnectionState InState, const FURL& InURL, int32 InConnectionSpeed = 0, int32 InMaxPacket = 0) override;
+
+	virtual void LowLevelSend(void* Data, int32 CountBits, FOutPacketTraits& Traits) override;
+
+	virtual FString LowLevelGetRemoteAddress(bool bAppendPort = false) override;
+
+	virtual FString LowLevelDescribe() override;
+
+	// Bytes of every packet sent so far
+	int64 BytesSent = 0;
+};
+
+/**
+ * Server net driver whose clients are UInventorySimulatedConnections. Actors replicate to them through TickFlush as on
+ * a dedicated server; nothing is ever received.
+ */
+UCLASS(Transient, NotBlueprintable)
+class UInventorySimulatedNetDriver : public UNetDriver
+{
+	GENERATED_BODY()
+
+public:
+	UInventorySimulatedNetDriver();
+
+	virtual bool IsAvailable() const override;
+
+	virtual bool InitConnect(FNetworkNotify* InNotify, const FURL& ConnectURL, FString& Error) override;
+
+	virtual bool InitListen(FNetworkNotify* InNotify, FURL& ListenURL, bool bReuseAddressAndPort, FString& Error) override;
+
+	virtual FString LowLevelGetNetworkNumber() override;
+
+	virtual bool IsNetResourceValid() override;
+
+	virtual void TickFlush(float DeltaSeconds) override;
+
+	// Opens a connection for a new client, with a player controller to own its actors
+	UInventorySimulatedConnection* AddSimulatedClient();
+
+	// Time spent in TickFlush, which replicates actors and sends everything queued for the clients
+	double ReplicationSeconds = 0.0;
+};
+
+/**
+ * Server world for the scale commandlet and the automation tests, with a number of simulated clients. Destroyed with
+ * this object.
+ */
+class FInventorySimulatedServer
+{
+public:
+	explicit FInventorySimulatedServer(int32 numClients);
+	~FInventorySimulatedServer();
+
+	UE_NONCOPYABLE(FInventorySimulatedServer);
+
+	UWorld* GetWorld() const;
+
+	// Null without clients
+	UInventorySimulatedNetDriver* GetNetDriver() const;
+
+	int32 NumClients() const;
+
+	// A replicated actor owned by the client's player controller, or by no one for INDEX_NONE
+	AActor* SpawnActor(int32 clientIndex = INDEX_NONE);
+
+	// Sent to every client so far
+	int64 GetBytesSent() const;
+
+private:
+	UWorld* World;
+	UInventorySimulatedNetDriver* NetDriver;
+
+	// Kept alive by the net driver and the world
+	TArray<UInventorySimulatedConnection*> Connections;
+};
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventorySnapshot.h"
+
+int32 FInventorySnapshot::ChunkFor(const FName itemCode)
+{
+	return GetTypeHash(itemCode) % NumChunks;
+}
+
+int32 FInventorySnapshot::GetQuantityFor(const FName itemCode) const
+{
+	return Chunks[ChunkFor(itemCode)]->FindRef(itemCode);
+}
+
+bool FInventorySnapshot::Contains(const FName itemCode) const
+{
+	return Chunks[ChunkFor(itemCode)]->Contains(itemCode);
+}
+
+int32 FInventorySnapshot::Num() const
+{
+	return NumEntries;
+}
+
+uint64 FInventorySnapshot::GetVersion() const
+{
+	return Version;
+}
+
+FInventorySnapshotPublisher::FInventorySnapshotPublisher() : bEnabled(false)
+{
+}
+
+bool FInventorySnapshotPublisher::IsEnabled() const
+{
+	return bEnabled;
+}
+
+void FInventorySnapshotPublisher::Enable()
+{
+	if (bEnabled)
+	{
+		return;
+	}
+
+	bEnabled = true;
+
+	FInventorySnapshot* empty = new FInventorySnapshot();
+	const FInventorySnapshot::FChunkPtr emptyChunk = MakeShared<const FInventorySnapshot::FChunk, ESPMode::ThreadSafe>();
+	empty->Chunks.Init(emptyChunk, FInventorySnapshot::NumChunks);
+	empty->NumEntries = 0;
+	empty->Version = 0;
+	Current = MakeShareable(empty);
+}
+
+void FInventorySnapshotPublisher::OnQuantityChanged(const FName itemCode, int32 newQuantity)
+{
+	if (bEnabled)
+	{
+		PendingChanges.Add(itemCode, newQuantity);
+	}
+}
+
+void FInventorySnapshotPublisher::Publish()
+{
+	if (!bEnabled || (PendingChanges.Num() == 0 && Published.IsValid()))
+	{
+		return;
+	}
+
+	FInventorySnapshot* snapshot = new FInventorySnapshot();
+	snapshot->Chunks = Current->Chunks;
+	snapshot->NumEntries = Current->NumEntries;
+	snapshot->Version = Current->Version + 1;
+
+	// Copy-on-write: each touched chunk is copied once, everything else is shared with the previous snapshot
+	TArray<TSharedPtr<FInventorySnapshot::FChunk, ESPMode::ThreadSafe>, TFixedAllocator<FInventorySnapshot::NumChunks>> copiedChunks;
+	copiedChunks.SetNum(FInventorySnapshot::NumChunks);
+
+	for (const auto& pair : PendingChanges)
+	{
+		const int32 chunkIndex = FInventorySnapshot::ChunkFor(pair.Key);
+		if (!copiedChunks[chunkIndex].IsValid())
+		{
+			copiedChunks[chunkIndex] = MakeShared<FInventorySnapshot::FChunk, ESPMode::ThreadSafe>(*snapshot->Chunks[chunkIndex]);
+			snapshot->Chunks[chunkIndex] = copiedChunks[chunkIndex];
+		}
+
+		FInventorySnapshot::FChunk& chunk = *copiedChunks[chunkIndex];
+		if (pair.Value > 0)
+		{
+			const int32 previousNum = chunk.Num();
+			chunk.Add(pair.Key, pair.Value);
+			snapshot->NumEntries += chunk.Num() - previousNum;
+		}
+		else
+		{
+			snapshot->NumEntries -= chunk.Remove(pair.Key);
+		}
+	}
+
+	PendingChanges.Reset();
+	Current = MakeShareable(snapshot);
+
+	FRWScopeLock lock(PublishedLock, SLT_Write);
+	Published = Current;
+}
+
+FInventorySnapshotPtr FInventorySnapshotPublisher::GetLatest() const
+{
+	FRWScopeLock lock(PublishedLock, SLT_ReadOnly);
+	return Published;
+}
+
+SIZE_T FInventorySnapshotPublisher::GetAllocatedSize() const
+{
+	SIZE_T size = PendingChanges.GetAllocatedSize();
+	if (Current.IsValid())
+	{
+		for (const FInventorySnapshot::FChunkPtr& chunk : Current->Chunks)
+		{
+			size += chunk->GetAllocatedSize();
+		}
+	}
+	return size;
+}
@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventorySortedView.h"
+#include "InventoryItemRegistry.h"
+
+namespace
+{
+	FName GetCategoryFor(const FName itemCode)
+	{
+		const TArray<FName>& tags = FInventoryItemRegistry::Get().GetTagsFor(itemCode);
+		return tags.Num() > 0 ? tags[0] : NAME_None;
+	}
+}
+
+FInventorySortedView::FInventorySortedView(EInventorySortOrder order) : Order(order), Level(1), Random(0x51ED)
+{
+	Reset();
+}
+
+EInventorySortOrder FInventorySortedView::GetOrder() const
+{
+	return Order;
+}
+
+void FInventorySortedView::OnQuantityChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity)
+{
+	oldQuantity = FMath::Max(oldQuantity, 0);
+	newQuantity = FMath::Max(newQuantity, 0);
+	if (oldQuantity == newQuantity)
+	{
+		return;
+	}
+
+	if (oldQuantity == 0)
+	{
+		Insert(itemCode, newQuantity);
+	}
+	else if (newQuantity == 0)
+	{
+		Remove(itemCode);
+	}
+	else if (Order == EInventorySortOrder::Quantity)
+	{
+		Remove(itemCode);
+		Insert(itemCode, newQuantity);
+	}
+	else
+	{
+		Nodes[NodeLookup.FindChecked(itemCode)].Quantity = newQuantity;  // Position does not depend on it
+	}
+}
+
+void FInventorySortedView::Reset()
+{
+	Nodes.SetNum(1);
+	Nodes[0].Links.Init({ INDEX_NONE, 0 }, MaxLevel);
+	FreeNodes.Reset();
+	NodeLookup.Reset();
+	Level = 1;
+}
+
+int32 FInventorySortedView::Num() const
+{
+	return NodeLookup.Num();
+}
+
+int32 FInventorySortedView::GetRank(const FName itemCode) const
+{
+	const int32* node = NodeLookup.Find(itemCode);
+	if (node == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 predecessors[MaxLevel];
+	int32 ranks[MaxLevel];
+	const FNode& target = Nodes[*node];
+	FindPredecessors(target.ItemCode, target.Category, target.Quantity, predecessors, ranks);
+	return ranks[0];
+}
+
+void FInventorySortedView::GetRange(int32 first, int32 count, TArray<FInventoryEntry>& outEntries) const
+{
+	outEntries.Reset();
+	if (first < 0 || count <= 0 || first >= Num())
+	{
+		return;
+	}
+
+	// Positions are one-based along the links, with the head at zero
+	const int32 target = first + 1;
+	int32 node = 0;
+	int32 position = 0;
+	for (int32 i = Level - 1; i >= 0 && position < target; i--)
+	{
+		while (Nodes[node].Links[i].Next != INDEX_NONE && position + Nodes[node].Links[i].Span <= target)
+		{
+			position += Nodes[node].Links[i].Span;
+			node = Nodes[node].Links[i].Next;
+		}
+	}
+
+	outEntries.Reserve(FMath::Min(count, Num() - first));
+	for (; node != INDEX_NONE && outEntries.Num() < count; node = Nodes[node].Links[0].Next)
+	{
+		outEntries.Emplace(Nodes[node].ItemCode, Nodes[node].Quantity);
+	}
+}
+
+void FInventorySortedView::GetPage(int32 pageIndex, int32 pageSize, TArray<FInventoryEntry>& outEntries) const
+{
+	GetRange(pageIndex * pageSize, pageSize, outEntries);
+}
+
+SIZE_T FInventorySortedView::GetAllocatedSize() const
+{
+	SIZE_T size = Nodes.GetAllocatedSize() + FreeNodes.GetAllocatedSize() + NodeLookup.GetAllocatedSize();
+	for (const FNode& node : Nodes)
+	{
+		size += node.Links.GetAllocatedSize();  // Only counts links that spilled out of the inline storage
+	}
+	return size;
+}
+
+bool FInventorySortedView::IsBefore(const FNode& node, const FName itemCode, const FName category, int32 quantity) const
+{
+	if (Order == EInventorySortOrder::Quantity && node.Quantity != quantity)
+	{
+		return node.Quantity > quantity;
+	}
+
+	if (Order == EInventorySortOrder::Category && node.Category != category)
+	{
+		if (node.Category.IsNone() || category.IsNone())
+		{
+			return category.IsNone();
+		}
+		return node.Category.Compare(category) < 0;
+	}
+
+	return node.ItemCode.Compare(itemCode) < 0;
+}
+
+void FInventorySortedView::FindPredecessors(const FName itemCode, const FName category, int32 quantity, int32* outNodes, int32* outRanks) const
+{
+	int32 node = 0;
+	int32 rank = 0;
+	for (int32 i = Level - 1; i >= 0; i--)
+	{
+		for (int32 next = Nodes[node].Links[i].Next; next != INDEX_NONE && IsBefore(Nodes[next], itemCode, category, quantity); next = Nodes[node].Links[i].Next)
+		{
+			rank += Nodes[node].Links[i].Span;
+			node = next;
+		}
+		outNodes[i] = node;
+		outRanks[i] = rank;
+	}
+}
+
+void FInventorySortedView::Insert(const FName itemCode, int32 quantity)
+{
+	const FName category = Order == EInventorySortOrder::Category ? GetCategoryFor(itemCode) : NAME_None;
+
+	int32 predecessors[MaxLevel];
+	int32 ranks[MaxLevel];
+	FindPredecessors(itemCode, category, quantity, predecessors, ranks);
+
+	const int32 level = RandomLevel();
+	for (int32 i = Level; i < level; i++)
+	{
+		predecessors[i] = 0;
+		ranks[i] = 0;
+	}
+	Level = FMath::Max(Level, level);
+
+	const int32 newNode = AllocateNode();
+	FNode& node = Nodes[newNode];
+	node.ItemCode = itemCode;
+	node.Category = category;
+	node.Quantity = quantity;
+	node.Links.SetNum(level);
+
+	for (int32 i = 0; i < Level; i++)
+	{
+		FLink& previous = Nodes[predecessors[i]].Links[i];
+		if (i < level)
+		{
+			// ranks[0] - ranks[i] entries lie between the predecessor on this level and the new node
+			node.Links[i].Next = previous.Next;
+			node.Links[i].Span = previous.Span - (ranks[0] - ranks[i]);
+			previous.Next = newNode;
+			previous.Span = ranks[0] - ranks[i] + 1;
+		}
+		else
+		{
+			previous.Span++;
+		}
+	}
+
+	NodeLookup.Add(itemCode, newNode);
+}
+
+void FInventorySortedView::Remove(const FName itemCode)
+{
+	int32 oldNode;
+	if (!NodeLookup.RemoveAndCopyValue(itemCode, oldNode))
+	{
+		return;
+	}
+
+	int32 predecessors[MaxLevel];
+	int32 ranks[MaxLevel];
+	const FNode& node = Nodes[oldNode];
+	FindPredecessors(node.ItemCode, node.Category, node.Quantity, predecessors, ranks);
+
+	for (int32 i = 0; i < Level; i++)
+	{
+		FLink& previous = Nodes[predecessors[i]].Links[i];
+		if (previous.Next == oldNode)
+		{
+			previous.Next = node.Links[i].Next;
+			previous.Span += node.Links[i].Span - 1;
+		}
+		else
+		{
+			previous.Span--;
+		}
+	}
+
+	while (Level > 1 && Nodes[0].Links[Level - 1].Next == INDEX_NONE)
+	{
+		Level--;
+	}
+
+	FreeNodes.Add(oldNode);
+}
+
+int32 FInventorySortedView::AllocateNode()
+{
+	if (FreeNodes.Num() > 0)
+	{
+		return FreeNodes.Pop(false);
+	}
+	return Nodes.AddDefaulted();
+}
+
+int32 FInventorySortedView::RandomLevel()
+{
+	int32 level = 1;
+	while (level < MaxLevel && (Random.GetUnsignedInt() & 3) == 0)
+	{
+		level++;
+	}
+	return level;
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryStateHash.h"
+#include "Misc/Crc.h"
+
+static_assert(FInventoryStateHash::NumBuckets <= 32, "Differing buckets are reported as a 32-bit mask");
+static_assert((FInventoryStateHash::NumBuckets & (FInventoryStateHash::NumBuckets - 1)) == 0, "Bucket count must be a power of two");
+
+FInventoryStateHash::FInventoryStateHash()
+{
+	Reset();
+}
+
+void FInventoryStateHash::OnQuantityChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity)
+{
+	const uint32 itemHash = HashItemCode(itemCode);
+	const uint64 delta = HashEntry(itemHash, newQuantity) - HashEntry(itemHash, oldQuantity);
+
+	// Wrapping arithmetic keeps the sum independent of the order changes arrive in
+	Hash += delta;
+	BucketHashes[itemHash % NumBuckets] += delta;
+}
+
+void FInventoryStateHash::Reset()
+{
+	Hash = 0;
+	FMemory::Memzero(BucketHashes);
+}
+
+uint64 FInventoryStateHash::GetHash() const
+{
+	return Hash;
+}
+
+uint64 FInventoryStateHash::GetBucketHash(int32 bucket) const
+{
+	check(bucket >= 0 && bucket < NumBuckets);
+	return BucketHashes[bucket];
+}
+
+void FInventoryStateHash::GetBucketHashes(TArray<uint64>& outBucketHashes) const
+{
+	outBucketHashes.Reset(NumBuckets);
+	outBucketHashes.Append(BucketHashes, NumBuckets);
+}
+
+uint32 FInventoryStateHash::GetDifferingBuckets(const TArray<uint64>& otherBucketHashes) const
+{
+	uint32 mask = 0;
+	for (int32 bucket = 0; bucket < NumBuckets; bucket++)
+	{
+		// A malformed array is treated as every missing bucket differing
+		if (!otherBucketHashes.IsValidIndex(bucket) || otherBucketHashes[bucket] != BucketHashes[bucket])
+		{
+			mask |= 1u << bucket;
+		}
+	}
+	return mask;
+}
+
+int32 FInventoryStateHash::GetBucketFor(const FName itemCode)
+{
+	return HashItemCode(itemCode) % NumBuckets;
+}
+
+uint32 FInventoryStateHash::HashItemCode(const FName itemCode)
+{
+	// FName comparison ignores case, so the hash has to as well. Lowercased on the stack, since this runs on every change.
+	TCHAR name[NAME_SIZE];
+	const uint32 length = itemCode.ToString(name, NAME_SIZE);
+	for (uint32 i = 0; i < length; i++)
+	{
+		name[i] = FChar::ToLower(name[i]);
+	}
+
+	return FCrc::StrCrc32(name);
+}
+
+uint64 FInventoryStateHash::HashEntry(uint32 itemHash, int32 quantity)
+{
+	if (quantity <= 0)
+	{
+		return 0;  // Absent entries contribute nothing
+	}
+
+	// SplitMix64 finaliser over (item, quantity)
+	uint64 x = ((uint64)itemHash << 32) | (uint32)quantity;
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
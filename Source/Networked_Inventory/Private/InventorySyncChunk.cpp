@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventorySyncChunk.h"
+#include "InventoryNetSerialization.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+bool InventorySyncChunk::Encode(const TArray<FInventoryEntry>& entries, const TArray<FInventoryInstanceRecord>& instances, TArray<uint8>& outCompressed, int32& outUncompressedSize)
+{
+	TArray<uint8> uncompressed;
+	FMemoryWriter writer(uncompressed);
+
+	int32 numEntries = entries.Num();
+	writer << numEntries;
+	for (const FInventoryEntry& entry : entries)
+	{
+		FName itemCode = entry.ItemCode;
+		uint32 quantity = (uint32)FMath::Max(entry.Quantity, 0);
+		writer << itemCode;
+		writer.SerializeIntPacked(quantity);
+	}
+
+	int32 numInstances = instances.Num();
+	writer << numInstances;
+	for (const FInventoryInstanceRecord& instance : instances)
+	{
+		FName itemCode = instance.ItemCode;
+		writer << itemCode;
+		for (int32 i = 0; i < FInventoryInstanceData::NumFields; i++)
+		{
+			int32 value = instance.Data.GetField(static_cast<EInstanceDataField>(i));
+			InventoryNetSerialization::SerializeSignedPacked(writer, value);
+		}
+	}
+
+	outUncompressedSize = uncompressed.Num();
+	if (outUncompressedSize > MaxUncompressedSize)
+	{
+		return false;
+	}
+
+	int32 compressedSize = FCompression::CompressMemoryBound(NAME_Zlib, outUncompressedSize);
+	outCompressed.SetNumUninitialized(compressedSize);
+	if (!FCompression::CompressMemory(NAME_Zlib, outCompressed.GetData(), compressedSize, uncompressed.GetData(), outUncompressedSize))
+	{
+		return false;
+	}
+
+	outCompressed.SetNum(compressedSize, false);
+	return true;
+}
+
+bool InventorySyncChunk::Decode(const TArray<uint8>& compressed, int32 uncompressedSize, TArray<FInventoryEntry>& outEntries, TArray<FInventoryInstanceRecord>& outInstances)
+{
+	if (uncompressedSize <= 0 || uncompressedSize > MaxUncompressedSize)
+	{
+		return false;
+	}
+
+	TArray<uint8> uncompressed;
+	uncompressed.SetNumUninitialized(uncompressedSize);
+	if (!FCompression::UncompressMemory(NAME_Zlib, uncompressed.GetData(), uncompressedSize, compressed.GetData(), compressed.Num()))
+	{
+		return false;
+	}
+
+	FMemoryReader reader(uncompressed);
+
+	int32 numEntries = 0;
+	reader << numEntries;
+
+	// Every entry takes at least two bytes
+	if (numEntries < 0 || numEntries > uncompressedSize / 2)
+	{
+		return false;
+	}
+
+	outEntries.Reset(numEntries);
+	for (int32 i = 0; i < numEntries && !reader.IsError(); i++)
+	{
+		FName itemCode;
+		uint32 quantity = 0;
+		reader << itemCode;
+		reader.SerializeIntPacked(quantity);
+		outEntries.Emplace(itemCode, (int32)FMath::Min<uint32>(quantity, MAX_int32));
+	}
+
+	int32 numInstances = 0;
+	reader << numInstances;
+	if (reader.IsError() || numInstances < 0 || numInstances > numEntries)
+	{
+		return false;
+	}
+
+	outInstances.Reset(numInstances);
+	for (int32 i = 0; i < numInstances && !reader.IsError(); i++)
+	{
+		FInventoryInstanceRecord& instance = outInstances.AddDefaulted_GetRef();
+		reader << instance.ItemCode;
+		for (int32 field = 0; field < FInventoryInstanceData::NumFields; field++)
+		{
+			int32 value = 0;
+			InventoryNetSerialization::SerializeSignedPacked(reader, value);
+			instance.Data.SetField(static_cast<EInstanceDataField>(field), value);
+		}
+	}
+
+	return !reader.IsError();
+}
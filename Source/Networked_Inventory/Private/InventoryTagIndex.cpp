@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryTagIndex.h"
+#include "InventoryItemRegistry.h"
+
+void FInventoryTagIndex::OnQuantityChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity)
+{
+	oldQuantity = FMath::Max(oldQuantity, 0);
+	newQuantity = FMath::Max(newQuantity, 0);
+	if (oldQuantity == newQuantity)
+	{
+		return;
+	}
+
+	for (const FName& tag : FInventoryItemRegistry::Get().GetTagsFor(itemCode))
+	{
+		FTagBucket& bucket = Buckets.FindOrAdd(tag);
+		bucket.TotalQuantity += newQuantity - oldQuantity;
+
+		if (oldQuantity == 0)
+		{
+			bucket.Members.Add(itemCode);
+		}
+		else if (newQuantity == 0)
+		{
+			bucket.Members.Remove(itemCode);
+		}
+	}
+}
+
+void FInventoryTagIndex::Reset()
+{
+	Buckets.Reset();
+}
+
+int32 FInventoryTagIndex::CountItemsWithTag(const FName tag) const
+{
+	const FTagBucket* bucket = Buckets.Find(tag);
+	return bucket ? bucket->Members.Num() : 0;
+}
+
+int64 FInventoryTagIndex::GetQuantityForTag(const FName tag) const
+{
+	const FTagBucket* bucket = Buckets.Find(tag);
+	return bucket ? bucket->TotalQuantity : 0;
+}
+
+const TSet<FName>* FInventoryTagIndex::GetItemsWithTag(const FName tag) const
+{
+	const FTagBucket* bucket = Buckets.Find(tag);
+	return bucket ? &bucket->Members : nullptr;
+}
+
+SIZE_T FInventoryTagIndex::GetAllocatedSize() const
+{
+	SIZE_T size = Buckets.GetAllocatedSize();
+	for (const auto& pair : Buckets)
+	{
+		size += pair.Value.Members.GetAllocatedSize();
+	}
+	return size;
+}
+
+void FInventoryTagIndex::Shrink()
+{
+	for (auto it = Buckets.CreateIterator(); it; ++it)
+	{
+		TSet<FName>& members = it.Value().Members;
+		if (members.Num() == 0)
+		{
+			it.RemoveCurrent();
+			continue;
+		}
+
+		members.Compact();
+		members.Shrink();
+	}
+
+	Buckets.Compact();
+	Buckets.Shrink();
+}
@@ -1,7 +1,33 @@
 #include "CoreMinimal.h"
 #include "Misc/AutomationTest.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/BitReader.h"
 
 #include "Inventory.h"
+#include "InventoryItemRegistry.h"
+#include "InventoryTransaction.h"
+#include "InventoryRecipeEvaluator.h"
+#include "InventoryRateLimitSettings.h"
+#include "InventoryRateLimitSubsystem.h"
+#include "InventoryBandwidthSubsystem.h"
+#include "InventorySyncChunk.h"
+#include "InventoryTrace.h"
+#include "InventoryCounters.h"
+#include "InventoryVerifier.h"
+#include "InventoryAggregates.h"
+#include "InventoryTimingWheel.h"
+#include "InventoryPersistence.h"
+#include "FileInventoryPersistenceBackend.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "ReplicationInventoryComponent.h"
+#include "ContainerInventoryComponent.h"
+#include "InventorySimulatedServer.h"
+#include "InventoryLoopbackComponent.h"
+#include "GameFramework/Actor.h"
+#include "HAL/PlatformProcess.h"
 
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryContainsAddedItems, "Inventory.Contains Added Items", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
 
@@ -306,4 +332,1451 @@ bool FInventoryCanModifyEntriesInGroups::RunTest(const FString& Parameters)
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryInstanceDataFollowsEntries, "Inventory.Instance Data Follows Entries", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryInstanceDataFollowsEntries::RunTest(const FString& Parameters)
+{
+	UInventory* inventory;
+	inventory = NewObject<UInventory>();
+
+	FName itemCode = FName(TEXT("Sword"));
+
+	if (inventory->SetInstanceField(itemCode, EInstanceDataField::Durability, 50))
+	{
+		AddError(TEXT("Instance data was set for an item that is not in the inventory."));
+	}
+
+	inventory->ModifyEntry(FInventoryEntry(itemCode, 1));
+	inventory->SetInstanceField(itemCode, EInstanceDataField::Durability, 50);
+	inventory->SetInstanceField(itemCode, EInstanceDataField::Roll, -7);
+
+	if (inventory->GetInstanceField(itemCode, EInstanceDataField::Durability) != 50 || inventory->GetInstanceField(itemCode, EInstanceDataField::Roll) != -7)
+	{
+		AddError(FString::Printf(TEXT("Instance data mismatch for item %s."), *itemCode.ToString()));
+	}
+
+	TArray<FInventoryInstanceDataDelta> deltas;
+	inventory->GetInstanceStore().ConsumeDeltas(deltas);
+
+	if (deltas.Num() != 1 || deltas[0].ChangedFields != ((1 << static_cast<uint8>(EInstanceDataField::Durability)) | (1 << static_cast<uint8>(EInstanceDataField::Roll))))
+	{
+		AddError(TEXT("Instance data delta does not contain exactly the changed fields."));
+	}
+
+	inventory->RemoveItem(itemCode);
+
+	if (inventory->FindInstanceData(itemCode) != nullptr)
+	{
+		AddError(FString::Printf(TEXT("Instance data for item %s survived removal of the entry."), *itemCode.ToString()));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryTagIndexTracksEntries, "Inventory.Tag Index Tracks Entries", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryTagIndexTracksEntries::RunTest(const FString& Parameters)
+{
+	const FName ammoTag = FName(TEXT("Test.Ammo"));
+	TArray<FName> ammoCodes;
+	for (int i = 0; i < 10; i++)
+	{
+		ammoCodes.Add(FName(*FString::Printf(TEXT("TestAmmo%i"), i)));
+		FInventoryItemRegistry::Get().RegisterItem(ammoCodes.Last(), { ammoTag });
+	}
+
+	UInventory* inventory;
+	inventory = NewObject<UInventory>();
+
+	int64 expectedTotal = 0;
+	for (const FName& itemCode : ammoCodes)
+	{
+		int32 num = FMath::RandRange(1, 1000);
+		inventory->ModifyEntry(FInventoryEntry(itemCode, num));
+		inventory->ModifyEntry(FInventoryEntry(FName(*FString::FromInt(num)), num));
+		expectedTotal += num;
+	}
+
+	if (inventory->CountItemsWithTag(ammoTag) != ammoCodes.Num() || inventory->GetQuantityForTag(ammoTag) != expectedTotal)
+	{
+		AddError(FString::Printf(TEXT("Tag index out of date. Items: %i (expected %i), Quantity: %lld (expected %lld)"), inventory->CountItemsWithTag(ammoTag), ammoCodes.Num(), inventory->GetQuantityForTag(ammoTag), expectedTotal));
+	}
+
+	inventory->ModifyEntry(FInventoryEntry(ammoCodes[0], -100000));
+	inventory->RemoveItem(ammoCodes[1]);
+
+	const TSet<FName>* members = inventory->GetItemsWithTag(ammoTag);
+	if (members == nullptr || members->Contains(ammoCodes[0]) || members->Contains(ammoCodes[1]) || members->Num() != ammoCodes.Num() - 2)
+	{
+		AddError(TEXT("Removed items are still indexed under their tag."));
+	}
+
+	for (const FName& itemCode : ammoCodes)
+	{
+		FInventoryItemRegistry::Get().UnregisterItem(itemCode);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryChangeSetsAreBatched, "Inventory.Change Sets Are Batched", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryChangeSetsAreBatched::RunTest(const FString& Parameters)
+{
+	UInventory* inventory;
+	inventory = NewObject<UInventory>();
+
+	const FName kept = FName(TEXT("Kept"));
+	const FName removed = FName(TEXT("Removed"));
+	const FName transient = FName(TEXT("Transient"));
+
+	inventory->ModifyEntry(FInventoryEntry(kept, 5));
+	inventory->ModifyEntry(FInventoryEntry(removed, 5));
+
+	FInventoryChangeSet changeSet;
+	inventory->ConsumeChanges(changeSet);
+
+	if (changeSet.Added.Num() != 2 || changeSet.Changed.Num() != 0 || changeSet.Removed.Num() != 0)
+	{
+		AddError(FString::Printf(TEXT("Expected 2 additions, got %i added, %i changed, %i removed."), changeSet.Added.Num(), changeSet.Changed.Num(), changeSet.Removed.Num()));
+	}
+
+	inventory->ModifyEntry(FInventoryEntry(kept, 3));
+	inventory->ModifyEntry(FInventoryEntry(kept, 2));
+	inventory->RemoveItem(removed);
+	inventory->ModifyEntry(FInventoryEntry(transient, 4));
+	inventory->ModifyEntry(FInventoryEntry(transient, -4));
+
+	changeSet = FInventoryChangeSet();
+	inventory->ConsumeChanges(changeSet);
+
+	if (changeSet.Changed.Num() != 1 || changeSet.Changed[0].OldQuantity != 5 || changeSet.Changed[0].NewQuantity != 10)
+	{
+		AddError(TEXT("Repeated changes to one item were not merged into a single old/new pair."));
+	}
+
+	if (changeSet.Removed.Num() != 1 || changeSet.Removed[0] != removed)
+	{
+		AddError(TEXT("Removed item missing from change set."));
+	}
+
+	if (changeSet.Added.Num() != 0)
+	{
+		AddError(TEXT("Item added and removed within one batch was reported as added."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryEntryBatchRoundTrips, "Inventory.Entry Batch Net Serialization Round Trips", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryEntryBatchRoundTrips::RunTest(const FString& Parameters)
+{
+	FInventoryItemRegistry::Get().RegisterItem(FName(TEXT("TestPotion")), {});
+
+	FInventoryEntryBatch batch;
+	batch.Entries.Emplace(FName(TEXT("TestPotion")), 3);
+	batch.Entries.Emplace(FName(TEXT("TestPotion")), -3);
+	batch.Entries.Emplace(FName(TEXT("Unregistered")), MAX_int32);
+	batch.Entries.Emplace(FName(TEXT("Unregistered")), MIN_int32);
+	for (int i = 0; i < 100; i++)
+	{
+		batch.Entries.Emplace(FName(*FString::FromInt(i)), FMath::RandRange(-1000, 1000));
+	}
+
+	FBitWriter writer(0, true);
+	bool bSuccess = false;
+	batch.NetSerialize(writer, nullptr, bSuccess);
+
+	FBitReader reader(writer.GetData(), writer.GetNumBits());
+	FInventoryEntryBatch received;
+	received.NetSerialize(reader, nullptr, bSuccess);
+
+	if (!bSuccess || received.Entries != batch.Entries)
+	{
+		AddError(TEXT("Entry batch did not survive a net serialization round trip."));
+	}
+
+	FBitWriter smallWriter(0, true);
+	FInventoryEntry entry(FName(TEXT("TestPotion")), 42);
+	entry.NetSerialize(smallWriter, nullptr, bSuccess);
+
+	if (smallWriter.GetNumBytes() > 3)
+	{
+		AddError(FString::Printf(TEXT("Registered entry with a small quantity took %lld bytes."), smallWriter.GetNumBytes()));
+	}
+
+	FInventoryItemRegistry::Get().UnregisterItem(FName(TEXT("TestPotion")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryNetIndicesNeedAgreement, "Inventory.Net Indices Need Registry Agreement", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryNetIndicesNeedAgreement::RunTest(const FString& Parameters)
+{
+	FInventoryItemRegistry& registry = FInventoryItemRegistry::Get();
+	const FName potion(TEXT("AgreementPotion"));
+	const FName sword(TEXT("AgreementSword"));
+	const FName lateItem(TEXT("AgreementLateItem"));
+	registry.RegisterItems({ { potion, {} }, { sword, {} } });
+
+	// Stand-ins for the two ends of one connection, and a client with a different registry
+	UObject* clientConnection = NewObject<UInventory>();
+	UObject* serverConnection = NewObject<UInventory>();
+	UObject* otherConnection = NewObject<UInventory>();
+
+	const uint32 checksum = registry.BeginNetIndexAgreement(clientConnection);
+	if (!registry.AcceptNetIndexAgreement(serverConnection, checksum))
+	{
+		AddError(TEXT("Server rejected a client with the same item registry."));
+	}
+
+	const int32 potionIndex = registry.GetNetIndex(potion, serverConnection);
+	if (potionIndex == INDEX_NONE || registry.GetItemForNetIndex(potionIndex, clientConnection) != potion)
+	{
+		AddError(TEXT("Agreed connection did not round trip a registered item through its index."));
+	}
+
+	if (registry.GetNetIndex(potion, clientConnection) != INDEX_NONE)
+	{
+		AddError(TEXT("Client sent indices before the server confirmed the agreement."));
+	}
+
+	registry.ConfirmNetIndexAgreement(clientConnection, checksum);
+	if (registry.GetNetIndex(sword, clientConnection) == INDEX_NONE)
+	{
+		AddError(TEXT("Client did not send indices after the server confirmed the agreement."));
+	}
+
+	// Registering at runtime must not shift the indices an open connection agreed on
+	registry.RegisterItem(lateItem, {});
+	if (registry.GetNetIndex(potion, serverConnection) != potionIndex || registry.GetNetIndex(lateItem, serverConnection) != INDEX_NONE)
+	{
+		AddError(TEXT("Runtime registration changed the agreed net indices."));
+	}
+
+	if (registry.AcceptNetIndexAgreement(otherConnection, checksum ^ 1) || registry.GetNetIndex(potion, otherConnection) != INDEX_NONE)
+	{
+		AddError(TEXT("Connection with a different item registry was sent indices."));
+	}
+
+	registry.UnregisterItem(potion);
+	registry.UnregisterItem(sword);
+	registry.UnregisterItem(lateItem);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventorySnapshotsShareUntouchedChunks, "Inventory.Snapshots Share Untouched Chunks", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventorySnapshotsShareUntouchedChunks::RunTest(const FString& Parameters)
+{
+	UInventory* inventory;
+	inventory = NewObject<UInventory>();
+
+	for (int i = 0; i < 100; i++)
+	{
+		inventory->ModifyEntry(FInventoryEntry(FName(*FString::FromInt(i)), i + 1));
+	}
+
+	inventory->EnableSnapshots();
+	FInventorySnapshotPtr before = inventory->GetSnapshot();
+
+	inventory->ModifyEntry(FInventoryEntry(FName(TEXT("0")), 10));
+	inventory->RemoveItem(FName(TEXT("1")));
+	FInventorySnapshotPtr after = inventory->GetSnapshot();
+
+	if (!before.IsValid() || !after.IsValid())
+	{
+		AddError(TEXT("No snapshot was published."));
+		return false;
+	}
+
+	if (before->GetQuantityFor(FName(TEXT("0"))) != 1 || !before->Contains(FName(TEXT("1"))) || before->Num() != 100)
+	{
+		AddError(TEXT("An older snapshot changed after later modifications."));
+	}
+
+	if (after->GetQuantityFor(FName(TEXT("0"))) != 11 || after->Contains(FName(TEXT("1"))) || after->Num() != 99)
+	{
+		AddError(TEXT("The latest snapshot does not reflect the committed changes."));
+	}
+
+	if (after->GetVersion() != before->GetVersion() + 2)
+	{
+		AddError(FString::Printf(TEXT("Expected one snapshot per committed change. Versions: %llu -> %llu"), before->GetVersion(), after->GetVersion()));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryTransfersAreAllOrNothing, "Inventory.Transfers Are All Or Nothing", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryTransfersAreAllOrNothing::RunTest(const FString& Parameters)
+{
+	UReplicationInventoryComponent* backpack = NewObject<UReplicationInventoryComponent>();
+	UReplicationInventoryComponent* stash = NewObject<UReplicationInventoryComponent>();
+	UReplicationInventoryComponent* vendor = NewObject<UReplicationInventoryComponent>();
+
+	backpack->ModifyEntry(FInventoryEntry(FName(TEXT("Sword")), 1));
+	backpack->ModifyEntry(FInventoryEntry(FName(TEXT("Gold")), 100));
+	stash->ModifyEntry(FInventoryEntry(FName(TEXT("Gold")), 5));
+
+	// The second move needs more gold than the backpack has left after the first, so nothing may change
+	FInventoryTransaction overdrawn;
+	overdrawn.Transfer(backpack, stash, { FInventoryEntry(FName(TEXT("Gold")), 60) });
+	overdrawn.Transfer(backpack, vendor, { FInventoryEntry(FName(TEXT("Gold")), 60), FInventoryEntry(FName(TEXT("Sword")), 1) });
+
+	if (overdrawn.Commit() != ETransferStatus::InsufficientQuantity)
+	{
+		AddError(TEXT("Overdrawn transaction was not rejected."));
+	}
+
+	if (backpack->GetQuantityFor(FName(TEXT("Gold"))) != 100 || stash->GetQuantityFor(FName(TEXT("Gold"))) != 5 || vendor->Num() != 0)
+	{
+		AddError(TEXT("A rejected transaction changed an inventory."));
+	}
+
+	FInventoryTransaction trade;
+	trade.Transfer(backpack, vendor, { FInventoryEntry(FName(TEXT("Sword")), 1) });
+	trade.Transfer(vendor, backpack, { FInventoryEntry(FName(TEXT("Sword")), 1) });
+	trade.Transfer(backpack, stash, { FInventoryEntry(FName(TEXT("Gold")), 100) });
+
+	if (trade.Commit() != ETransferStatus::Success)
+	{
+		AddError(TEXT("Valid transaction was rejected."));
+	}
+
+	if (backpack->GetQuantityFor(FName(TEXT("Sword"))) != 1 || backpack->Contains(FName(TEXT("Gold"))) || stash->GetQuantityFor(FName(TEXT("Gold"))) != 105)
+	{
+		AddError(FString::Printf(TEXT("Unexpected result after transaction. Backpack: %s Stash: %s"), *backpack->ToString(), *stash->ToString()));
+	}
+
+	const TMap<FName, int64>* vendorChanges = trade.FindChanges(vendor);
+	if (vendorChanges == nullptr || vendorChanges->FindRef(FName(TEXT("Sword"))) != 0)
+	{
+		AddError(TEXT("Moves through an inventory should net out to no change."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryRecipesEvaluateIncrementally, "Inventory.Recipes Evaluate Incrementally", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryRecipesEvaluateIncrementally::RunTest(const FString& Parameters)
+{
+	UReplicationInventoryComponent* inventory = NewObject<UReplicationInventoryComponent>();
+	inventory->ModifyEntry(FInventoryEntry(FName(TEXT("Wood")), 10));
+	inventory->ModifyEntry(FInventoryEntry(FName(TEXT("Iron")), 3));
+
+	TArray<FInventoryRecipe> recipes;
+	recipes.Add({ FName(TEXT("Plank")), { FInventoryEntry(FName(TEXT("Wood")), 2) } });
+	recipes.Add({ FName(TEXT("Axe")), { FInventoryEntry(FName(TEXT("Wood")), 3), FInventoryEntry(FName(TEXT("Iron")), 2) } });
+	recipes.Add({ FName(TEXT("Sword")), { FInventoryEntry(FName(TEXT("Iron")), 5) } });
+	recipes.Add({ FName(TEXT("Potion")), { FInventoryEntry(FName(TEXT("Herb")), 1), FInventoryEntry(FName(TEXT("Water")), 1) } });
+
+	FInventoryRecipeEvaluator evaluator;
+	evaluator.Compile(recipes);
+	evaluator.Refresh(*inventory);
+
+	if (!evaluator.CanCraft(0) || evaluator.GetMaxCraftable(0) != 5 || !evaluator.CanCraft(1) || evaluator.GetMaxCraftable(1) != 1
+		|| evaluator.CanCraft(2) || evaluator.CanCraft(3))
+	{
+		AddError(TEXT("Initial recipe evaluation is wrong."));
+	}
+
+	evaluator.OnQuantityChanged(FName(TEXT("Iron")), 6);
+	evaluator.OnQuantityChanged(FName(TEXT("Stone")), 50);
+	const int32 numEvaluated = evaluator.Evaluate();
+
+	if (numEvaluated != 2)
+	{
+		AddError(FString::Printf(TEXT("Expected only the two iron recipes to be re-evaluated, got %i."), numEvaluated));
+	}
+
+	if (evaluator.GetMaxCraftable(1) != 3 || !evaluator.CanCraft(2) || evaluator.GetMaxCraftable(2) != 1)
+	{
+		AddError(TEXT("Incremental recipe evaluation is wrong."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryBucketRepairFixesDivergence, "Inventory.Bucket Repair Fixes Divergence", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryBucketRepairFixesDivergence::RunTest(const FString& Parameters)
+{
+	UInventory* server = NewObject<UInventory>();
+	UInventory* client = NewObject<UInventory>();
+
+	for (int i = 0; i < 200; i++)
+	{
+		server->ModifyEntry(FInventoryEntry(FName(*FString::Printf(TEXT("Item%i"), i)), i + 1));
+	}
+
+	// Same contents reached in a different order must hash the same
+	for (int i = 199; i >= 0; i--)
+	{
+		client->ModifyEntry(FInventoryEntry(FName(*FString::Printf(TEXT("Item%i"), i)), i));
+		client->ModifyEntry(FInventoryEntry(FName(*FString::Printf(TEXT("Item%i"), i)), 1));
+	}
+
+	if (client->GetStateHash().GetHash() != server->GetStateHash().GetHash())
+	{
+		AddError(TEXT("Hash depends on the order changes were applied in."));
+	}
+
+	client->ModifyEntry(FInventoryEntry(FName(TEXT("Item7")), 5));
+	client->RemoveItem(FName(TEXT("Item8")));
+	client->ModifyEntry(FInventoryEntry(FName(TEXT("Phantom")), 1));
+
+	TArray<uint64> serverBuckets;
+	server->GetStateHash().GetBucketHashes(serverBuckets);
+	const uint32 bucketMask = client->GetStateHash().GetDifferingBuckets(serverBuckets);
+
+	if (bucketMask == 0 || FMath::CountBits(bucketMask) > 3)
+	{
+		AddError(FString::Printf(TEXT("Expected between one and three diverged buckets, got mask %x."), bucketMask));
+	}
+
+	TArray<FInventoryEntry> bucketEntries;
+	server->GetEntriesInBuckets(bucketMask, bucketEntries);
+	client->ReplaceBuckets(bucketMask, bucketEntries);
+
+	if (client->GetStateHash().GetHash() != server->GetStateHash().GetHash() || client->Num() != server->Num() || client->GetQuantityFor(FName(TEXT("Item7"))) != 8)
+	{
+		AddError(TEXT("Client still differs from server after replacing diverged buckets."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryRateLimitDefersFloods, "Inventory.Rate Limit Defers Floods", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryRateLimitDefersFloods::RunTest(const FString& Parameters)
+{
+	const UInventoryRateLimitSettings* settings = GetDefault<UInventoryRateLimitSettings>();
+	if (!settings->bEnableRateLimiting || settings->ThrottlePolicy != EInventoryThrottlePolicy::Defer)
+	{
+		AddInfo(TEXT("Rate limiting is configured off or to drop; skipping."));
+		return true;
+	}
+
+	UInventoryRateLimitSubsystem* rateLimiter = NewObject<UInventoryRateLimitSubsystem>();
+	UObject* connection = NewObject<UInventory>();  // Any object stands in for a net connection
+
+	const int32 numRequests = settings->RequestBurst + 5;
+	int32 numExecuted = 0;
+	for (int32 i = 0; i < numRequests; i++)
+	{
+		rateLimiter->Submit(connection, 1, [&numExecuted]() { numExecuted++; });
+	}
+
+	// Trusted requests are never held back
+	rateLimiter->Submit(nullptr, settings->EntryBurst + 1, [&numExecuted]() { numExecuted++; });
+
+	const FInventoryRateLimitStats stats = rateLimiter->GetStats();
+	if (numExecuted != settings->RequestBurst + 1 || stats.DeferredRequests != 5 || stats.QueuedRequests != 5 || rateLimiter->GetThrottledCount(connection) != 5)
+	{
+		AddError(FString::Printf(TEXT("Unexpected admission. Executed %i, deferred %i, queued %i."), numExecuted, stats.DeferredRequests, stats.QueuedRequests));
+	}
+
+	if (rateLimiter->Submit(connection, settings->EntryBurst + 1, []() {}) != EInventoryRequestAdmission::Dropped)
+	{
+		AddError(TEXT("A request larger than the entry burst was not dropped."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventorySyncChunksRoundTrip, "Inventory.Sync Chunks Round Trip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventorySyncChunksRoundTrip::RunTest(const FString& Parameters)
+{
+	TArray<FInventoryEntry> entries;
+	for (int i = 0; i < 64; i++)
+	{
+		entries.Emplace(FName(*FString::Printf(TEXT("Item%i"), i)), i * 100);
+	}
+
+	FInventoryInstanceData sword;
+	sword.Durability = 80;
+	sword.Enchantment = -3;
+	TArray<FInventoryInstanceRecord> instances;
+	instances.Emplace(FName(TEXT("Item5")), sword);
+
+	TArray<uint8> compressed;
+	int32 uncompressedSize = 0;
+	if (!InventorySyncChunk::Encode(entries, instances, compressed, uncompressedSize) || compressed.Num() >= uncompressedSize)
+	{
+		AddError(FString::Printf(TEXT("Chunk did not compress: %i -> %i bytes."), uncompressedSize, compressed.Num()));
+	}
+
+	TArray<FInventoryEntry> decoded;
+	TArray<FInventoryInstanceRecord> decodedInstances;
+	if (!InventorySyncChunk::Decode(compressed, uncompressedSize, decoded, decodedInstances) || decoded != entries)
+	{
+		AddError(TEXT("Chunk did not survive an encode/decode round trip."));
+	}
+
+	if (decodedInstances.Num() != 1 || decodedInstances[0].ItemCode != FName(TEXT("Item5")) || !(decodedInstances[0].Data == sword))
+	{
+		AddError(TEXT("Instance data did not survive a chunk round trip."));
+	}
+
+	if (InventorySyncChunk::Decode(compressed, InventorySyncChunk::MaxUncompressedSize + 1, decoded, decodedInstances))
+	{
+		AddError(TEXT("Oversized chunk was accepted."));
+	}
+
+	// Absolute quantities: zero removes, anything else overwrites
+	UInventory* inventory = NewObject<UInventory>();
+	inventory->ModifyEntry(FInventoryEntry(FName(TEXT("Item0")), 7));
+	inventory->ModifyEntry(FInventoryEntry(FName(TEXT("Item1")), 7));
+	inventory->SetQuantities(decoded);
+
+	if (inventory->Contains(FName(TEXT("Item0"))) || inventory->GetQuantityFor(FName(TEXT("Item1"))) != 100 || inventory->Num() != 63)
+	{
+		AddError(TEXT("Applying a chunk did not set absolute quantities."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryTraceRoundTrips, "Inventory.Trace Round Trips", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryTraceRoundTrips::RunTest(const FString& Parameters)
+{
+	const FString path = FPaths::ProjectIntermediateDir() / TEXT("InventoryTests") / TEXT("RoundTrip.invtrace");
+	UInventory* backpack = NewObject<UInventory>();
+	UInventory* stash = NewObject<UInventory>();
+
+	FInventoryTraceRecorder& recorder = FInventoryTraceRecorder::Get();
+	if (!recorder.Start(path))
+	{
+		AddError(TEXT("Could not start recording."));
+		return false;
+	}
+
+	recorder.Record(backpack, EInventoryTraceOp::Add, { FInventoryEntry(FName(TEXT("Gold")), 100), FInventoryEntry(FName(TEXT("Sword")), 1) });
+	recorder.Record(stash, EInventoryTraceOp::ServerModify, { FInventoryEntry(FName(TEXT("Gold")), -250) });
+	recorder.Record(backpack, EInventoryTraceOp::Remove, { FInventoryEntry(FName(TEXT("Sword")), 1) });
+	recorder.Stop();
+
+	FInventoryTraceReader reader;
+	TArray<FInventoryTraceEvent> events;
+	FInventoryTraceEvent event;
+	if (reader.Open(path))
+	{
+		while (reader.Next(event))
+		{
+			events.Add(event);
+		}
+	}
+
+	if (reader.IsError() || events.Num() != 3)
+	{
+		AddError(FString::Printf(TEXT("Expected three events back, got %i."), events.Num()));
+	}
+	else
+	{
+		if (events[0].InventoryId != backpack->GetPathName() || events[1].InventoryId != stash->GetPathName() || events[1].Op != EInventoryTraceOp::ServerModify)
+		{
+			AddError(TEXT("Inventory ids or ops did not survive the round trip."));
+		}
+
+		if (events[0].Entries.Num() != 2 || !(events[0].Entries[1] == FInventoryEntry(FName(TEXT("Sword")), 1)) || events[1].Entries[0].Quantity != -250)
+		{
+			AddError(TEXT("Entries did not survive the round trip."));
+		}
+
+		if (events[0].Time > events[1].Time || events[1].Time > events[2].Time)
+		{
+			AddError(TEXT("Event times went backwards."));
+		}
+	}
+
+	IFileManager::Get().Delete(*path);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryShrinkReleasesSlack, "Inventory.Shrink Releases Slack", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryShrinkReleasesSlack::RunTest(const FString& Parameters)
+{
+	UInventory* inventory = NewObject<UInventory>();
+
+	TArray<FName> removedItems;
+	for (int32 i = 0; i < 1000; i++)
+	{
+		const FName itemCode(*FString::Printf(TEXT("Item%i"), i));
+		inventory->AddNewEntry(FInventoryEntry(itemCode, i + 1));
+		if (i >= 10)
+		{
+			removedItems.Add(itemCode);
+		}
+	}
+	inventory->RemoveGroupOfItems(removedItems);
+
+	const FInventoryMemoryUsage before = inventory->GetMemoryUsage();
+	inventory->Shrink();
+	const FInventoryMemoryUsage after = inventory->GetMemoryUsage();
+
+	if (before.NumEntries != 10 || after.NumEntries != 10)
+	{
+		AddError(FString::Printf(TEXT("Expected 10 entries before and after shrinking, got %i and %i."), before.NumEntries, after.NumEntries));
+	}
+
+	if (after.AllocatedBytes >= before.AllocatedBytes || after.GetSlackBytes() >= before.GetSlackBytes())
+	{
+		AddError(FString::Printf(TEXT("Shrinking did not release memory (%llu -> %llu bytes allocated)."), (uint64)before.AllocatedBytes, (uint64)after.AllocatedBytes));
+	}
+
+	if (inventory->GetQuantityFor(FName(TEXT("Item9"))) != 10 || inventory->Contains(FName(TEXT("Item10"))))
+	{
+		AddError(TEXT("Shrinking changed the inventory contents."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventorySortedViewsStayOrdered, "Inventory.Sorted Views Stay Ordered", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventorySortedViewsStayOrdered::RunTest(const FString& Parameters)
+{
+	UInventory* inventory = NewObject<UInventory>();
+	inventory->EnableSortedView(EInventorySortOrder::Name);
+
+	FRandomStream random(7);
+	for (int32 i = 0; i < 500; i++)
+	{
+		inventory->ModifyEntry(FInventoryEntry(FName(*FString::Printf(TEXT("Item%03i"), random.RandRange(0, 199))), random.RandRange(-20, 40)));
+	}
+	inventory->EnableSortedView(EInventorySortOrder::Quantity);
+	for (int32 i = 0; i < 500; i++)
+	{
+		inventory->ModifyEntry(FInventoryEntry(FName(*FString::Printf(TEXT("Item%03i"), random.RandRange(0, 199))), random.RandRange(-20, 40)));
+	}
+
+	TArray<FInventoryEntry> byName;
+	for (const auto& pair : inventory->GetEntryMap())
+	{
+		if (pair.Value > 0)
+		{
+			byName.Emplace(pair.Key, pair.Value);
+		}
+	}
+	TArray<FInventoryEntry> byQuantity = byName;
+	byName.Sort([](const FInventoryEntry& a, const FInventoryEntry& b) { return a.ItemCode.Compare(b.ItemCode) < 0; });
+	byQuantity.Sort([](const FInventoryEntry& a, const FInventoryEntry& b)
+	{
+		return a.Quantity != b.Quantity ? a.Quantity > b.Quantity : a.ItemCode.Compare(b.ItemCode) < 0;
+	});
+
+	const int32 pageSize = 7;
+	for (int32 pageIndex = 0; pageIndex * pageSize < byName.Num(); pageIndex++)
+	{
+		const TArray<FInventoryEntry> namePage = inventory->GetSortedPage(EInventorySortOrder::Name, pageIndex, pageSize);
+		const TArray<FInventoryEntry> quantityPage = inventory->GetSortedPage(EInventorySortOrder::Quantity, pageIndex, pageSize);
+		for (int32 i = 0; i < pageSize && pageIndex * pageSize + i < byName.Num(); i++)
+		{
+			const int32 rank = pageIndex * pageSize + i;
+			if (!namePage.IsValidIndex(i) || !(namePage[i] == byName[rank]) || inventory->GetSortedRank(EInventorySortOrder::Name, byName[rank].ItemCode) != rank)
+			{
+				AddError(FString::Printf(TEXT("Name view is wrong at position %i."), rank));
+				return true;
+			}
+			if (!quantityPage.IsValidIndex(i) || !(quantityPage[i] == byQuantity[rank]) || inventory->GetSortedRank(EInventorySortOrder::Quantity, byQuantity[rank].ItemCode) != rank)
+			{
+				AddError(FString::Printf(TEXT("Quantity view is wrong at position %i."), rank));
+				return true;
+			}
+		}
+	}
+
+	if (inventory->GetSortedPage(EInventorySortOrder::Category, 0, pageSize).Num() != 0 || inventory->GetSortedRank(EInventorySortOrder::Name, FName(TEXT("NotHeld"))) != INDEX_NONE)
+	{
+		AddError(TEXT("Disabled views and missing items should come back empty."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryCountersAreRateLimited, "Inventory.Counters Are Rate Limited", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryCountersAreRateLimited::RunTest(const FString& Parameters)
+{
+	const FName gold(TEXT("CounterTestGold"));
+	FInventoryCounterPolicy policy;
+	policy.MaxUpdatesPerSecond = 4.0f;
+	policy.InterpolationSeconds = 0.5f;
+	FInventoryItemRegistry::Get().RegisterCounter(gold, policy);
+
+	// A thousand changes a second for two seconds, well past what an int32 can hold
+	FInventoryCounterSet server;
+	FInventoryCounterSet client;
+	TArray<FInventoryCounterValue> values;
+	int32 numSent = 0;
+	for (int32 i = 0; i < 2000; i++)
+	{
+		const double now = i / 1000.0;
+		server.Add(gold, 10000000);
+		values.Reset();
+		if (server.ConsumeDue(now, values))
+		{
+			numSent += values.Num();
+			client.ApplyReplicated(values, now);
+		}
+	}
+
+	if (numSent > 9)
+	{
+		AddError(FString::Printf(TEXT("Expected at most 9 updates in two seconds at 4 per second, sent %i."), numSent));
+	}
+
+	const double settleTime = 2.0 + server.GetSecondsUntilDue(2.0);
+	values.Reset();
+	server.ConsumeDue(settleTime, values);
+	client.ApplyReplicated(values, settleTime);
+
+	if (server.GetValue(gold) != 20000000000ll || client.GetValue(gold) != server.GetValue(gold) || server.HasDirty())
+	{
+		AddError(TEXT("The latest value did not reach the client."));
+	}
+
+	const double halfway = client.GetDisplayValue(gold, settleTime + 0.25);
+	if (halfway <= client.GetDisplayValue(gold, settleTime) || halfway >= 20000000000.0 || client.GetDisplayValue(gold, settleTime + 0.5) != 20000000000.0)
+	{
+		AddError(TEXT("Client display value should ease to the replicated value."));
+	}
+
+	server.Add(gold, MAX_int64);
+	server.Add(gold, 1);
+	if (server.GetValue(gold) != MAX_int64)
+	{
+		AddError(TEXT("Counters should saturate instead of overflowing."));
+	}
+
+	FInventoryItemRegistry::Get().UnregisterItem(gold);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryVerifierFindsViolations, "Inventory.Verifier Finds Violations", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryVerifierFindsViolations::RunTest(const FString& Parameters)
+{
+	UInventory* inventory = NewObject<UInventory>();
+	inventory->EnableSnapshots();
+	inventory->AddNewEntry(FInventoryEntry(FName(TEXT("Sword")), 1));
+	inventory->AddNewEntry(FInventoryEntry(FName(TEXT("Gold")), 50));
+
+	FInventoryVerificationSample sample;
+	sample.Context = TEXT("Test");
+	sample.Entries = { FInventoryEntry(FName(TEXT("Sword")), 1), FInventoryEntry(FName(TEXT("Gold")), 50) };
+	sample.bHasLookupCache = true;
+	sample.LookupCache.Add(FName(TEXT("Sword")), 0);
+	sample.LookupCache.Add(FName(TEXT("Gold")), 1);
+	sample.Snapshot = inventory->GetSnapshot();
+
+	TArray<FString> violations;
+	FInventoryVerifier::Verify(sample, violations);
+	if (violations.Num() != 0)
+	{
+		AddError(FString::Printf(TEXT("A consistent sample was reported: %s"), *FString::Join(violations, TEXT(" "))));
+	}
+
+	// Stale cache index, a duplicate, a non-positive quantity and a snapshot that no longer matches
+	sample.LookupCache.Add(FName(TEXT("Gold")), 0);
+	sample.Entries.Emplace(FName(TEXT("Sword")), 1);
+	sample.Entries.Emplace(FName(TEXT("Arrow")), 0);
+
+	violations.Reset();
+	FInventoryVerifier::Verify(sample, violations);
+	if (violations.Num() < 5)
+	{
+		AddError(FString::Printf(TEXT("Expected at least five violations, found %i."), violations.Num()));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryContainersMoveItems, "Inventory.Containers Move Items", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryContainersMoveItems::RunTest(const FString& Parameters)
+{
+	const FName backpack(TEXT("Backpack"));
+	const FName equipment(TEXT("Equipment"));
+	const FName bank(TEXT("Bank"));
+	const FName sword(TEXT("Sword"));
+	const FName gold(TEXT("Gold"));
+
+	UContainerInventoryComponent* component = NewObject<UContainerInventoryComponent>();
+	component->Containers.Emplace(backpack, EInventoryContainerReplication::OwnerOnly);
+	component->Containers.Emplace(equipment, EInventoryContainerReplication::Everyone);
+	component->Containers.Emplace(bank, EInventoryContainerReplication::OnDemand);
+
+	TArray<FInventoryContainerChange> changes;
+	changes.Emplace(backpack, sword, 1);
+	changes.Emplace(backpack, gold, 100);
+	changes.Emplace(bank, gold, 500);
+	changes.Emplace(FName(TEXT("Quiver")), gold, 1);
+	if (component->ModifyContainers(changes) != EChangeGroupStatus::SomeChangesLost)
+	{
+		AddError(TEXT("A change to a missing container was not reported."));
+	}
+
+	if (component->MoveItem(backpack, equipment, sword, 1) != ETransferStatus::Success
+		|| component->MoveItem(backpack, bank, gold, 60) != ETransferStatus::Success)
+	{
+		AddError(TEXT("Moves between containers failed."));
+	}
+
+	if (component->MoveItem(backpack, bank, gold, 41) != ETransferStatus::InsufficientQuantity
+		|| component->MoveItem(backpack, backpack, gold, 1) != ETransferStatus::InvalidInventory)
+	{
+		AddError(TEXT("Invalid moves were not rejected."));
+	}
+
+	if (component->GetQuantityIn(backpack, sword) != 0 || component->GetQuantityIn(equipment, sword) != 1
+		|| component->GetQuantityIn(backpack, gold) != 40 || component->GetQuantityIn(bank, gold) != 560)
+	{
+		AddError(FString::Printf(TEXT("Unexpected quantities after moving:\n%s"), *component->ToString()));
+	}
+
+	if (component->GetContainerEntries(backpack).Num() != 1 || component->GetQuantityFor(gold) != 40)
+	{
+		AddError(TEXT("The emptied stack is still in the backpack."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventorySendQueuePrioritizesAndMerges, "Inventory.Send Queue Prioritizes And Merges", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventorySendQueuePrioritizesAndMerges::RunTest(const FString& Parameters)
+{
+	UInventory* equipped = NewObject<UInventory>();
+	UInventory* backpack = NewObject<UInventory>();
+	UInventory* chest = NewObject<UInventory>();
+	const FName deltas(TEXT("Deltas"));
+	const FName sync(TEXT("Sync"));
+
+	TArray<int32> sent;
+	const auto sendAs = [&sent](int32 id) { return [&sent, id]() { sent.Add(id); return 10; }; };
+
+	FInventorySendQueue queue;
+	queue.Enqueue(chest, sync, EInventorySendPriority::Other, 0.0, sendAs(1));
+	queue.Enqueue(backpack, deltas, EInventorySendPriority::Backpack, 1.0, sendAs(2));
+	queue.Enqueue(chest, deltas, EInventorySendPriority::ViewedContainer, 2.0, sendAs(3));
+	queue.Enqueue(equipped, deltas, EInventorySendPriority::Equipped, 3.0, sendAs(4));
+
+	// Merged into the queued send, which moves up to the higher priority but keeps its place among equals
+	if (!queue.Enqueue(chest, deltas, EInventorySendPriority::Backpack, 4.0, sendAs(5)) || queue.Num() != 4)
+	{
+		AddError(TEXT("A second send for the same sender and channel was not merged."));
+	}
+
+	FInventoryQueuedSend send;
+	while (queue.Pop(send))
+	{
+		send.Send();
+	}
+
+	const TArray<int32> expected = { 4, 2, 3, 1 };
+	if (sent != expected)
+	{
+		AddError(FString::Printf(TEXT("Sends ran in the wrong order: %s"), *FString::JoinBy(sent, TEXT(", "), [](int32 id) { return FString::FromInt(id); })));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryAggregateViewsSumInventories, "Inventory.Aggregate Views Sum Inventories", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryAggregateViewsSumInventories::RunTest(const FString& Parameters)
+{
+	const FName gold(TEXT("Gold"));
+	FInventoryAggregateViewsPtr views = MakeShared<FInventoryAggregateViews, ESPMode::ThreadSafe>();
+	const int32 everyone = views->RegisterView(TEXT("Everyone"));
+
+	TMap<FName, int32> held;
+	held.Add(gold, 10);
+	const auto forEachHeld = [&held](auto&& visit)
+	{
+		for (const TPair<FName, int32>& entry : held)
+		{
+			visit(entry.Key, entry.Value);
+		}
+	};
+
+	FInventoryAggregateMembership first;
+	FInventoryAggregateMembership second;
+	if (!first.Join(views, TEXT("Everyone"), forEachHeld) || first.Join(views, TEXT("Everyone"), forEachHeld) || second.Join(views, TEXT("Team"), forEachHeld))
+	{
+		AddError(TEXT("Joining accepted a duplicate or unregistered view."));
+	}
+	second.Join(views, TEXT("Everyone"), forEachHeld);
+
+	first.OnQuantityChanged(gold, 10, 25);
+
+	// Changes from worker threads land in their own partial sums
+	ParallelFor(64, [&views, everyone, gold](int32 index)
+	{
+		views->Record(everyone, gold, 1, 0);
+	});
+
+	if (views->GetTotal(everyone, gold).Quantity != 0)
+	{
+		AddError(TEXT("Totals changed before they were merged."));
+	}
+
+	views->Merge();
+	FInventoryAggregateTotal total = views->GetTotal(everyone, gold);
+	if (total.Quantity != 25 + 10 + 64 || total.Holders != 2)
+	{
+		AddError(FString::Printf(TEXT("Expected 99 gold over 2 holders, got %lld over %d."), total.Quantity, total.Holders));
+	}
+
+	second.OnQuantityChanged(gold, 10, 0);
+	held[gold] = 25;
+	first.Leave(TEXT("Everyone"), forEachHeld);
+	views->Merge();
+	total = views->GetTotal(everyone, gold);
+	if (total.Quantity != 64 || total.Holders != 0)
+	{
+		AddError(FString::Printf(TEXT("Expected 64 gold over 0 holders after leaving, got %lld over %d."), total.Quantity, total.Holders));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryTimingWheelExpiresOnTime, "Inventory.Timing Wheel Expires On Time", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryTimingWheelExpiresOnTime::RunTest(const FString& Parameters)
+{
+	UInventory* inventory = NewObject<UInventory>();
+	const FName milk(TEXT("Milk"));
+	const FName rental(TEXT("RentalSword"));
+	const FName potion(TEXT("Potion"));
+
+	FInventoryTimingWheel wheel(0.5);
+	wheel.Schedule(3.0, FInventoryExpiryTimer(inventory, milk));
+	wheel.Schedule(5000.0, FInventoryExpiryTimer(inventory, rental));  // Starts two levels up
+	const uint64 cancelled = wheel.Schedule(2.0, FInventoryExpiryTimer(inventory, potion));
+
+	if (!wheel.Cancel(cancelled) || wheel.Cancel(cancelled) || wheel.Num() != 2)
+	{
+		AddError(TEXT("Cancelling a timer did not remove it exactly once."));
+	}
+
+	TArray<FInventoryExpiryTimer> expired;
+	wheel.Advance(2.9, expired);
+	if (expired.Num() != 0)
+	{
+		AddError(TEXT("A timer fired early."));
+	}
+
+	wheel.Advance(3.0, expired);
+	if (expired.Num() != 1 || expired[0].ItemCode != milk)
+	{
+		AddError(TEXT("The due timer did not fire on its tick."));
+	}
+
+	expired.Reset();
+	wheel.Advance(4999.0, expired);
+	if (expired.Num() != 0)
+	{
+		AddError(TEXT("A cascaded timer fired early."));
+	}
+
+	wheel.Advance(5000.4, expired);
+	if (expired.Num() != 1 || expired[0].ItemCode != rental || expired[0].Inventory.Get() != inventory || wheel.Num() != 0)
+	{
+		AddError(TEXT("The long timer did not fire after cascading down the wheel."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryAsyncRequestsResolveWithStatuses, "Inventory.Async Requests Resolve With Statuses", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryAsyncRequestsResolveWithStatuses::RunTest(const FString& Parameters)
+{
+	const FName gold(TEXT("Gold"));
+	const FName arrow(TEXT("Arrow"));
+
+	UContainerInventoryComponent* component = NewObject<UContainerInventoryComponent>();
+	component->Containers.Emplace(FName(TEXT("Backpack")), EInventoryContainerReplication::OwnerOnly);
+	IInventoryInterface* inventory = component;
+
+	TArray<FInventoryEntry> changes;
+	changes.Emplace(gold, 50);
+	changes.Emplace(arrow, -5);  // Not held
+
+	TArray<EChangeStatus> statuses;
+	int32 quantityWhenResolved = 0;
+	inventory->ModifyInventoryAsync(changes).Next([&statuses, &quantityWhenResolved, inventory, gold](const FInventoryRequestResult& result)
+	{
+		statuses = result.EntryStatuses;
+		quantityWhenResolved = inventory->GetQuantityFor(gold);
+	});
+
+	const TArray<EChangeStatus> expected = { EChangeStatus::Success, EChangeStatus::CouldNotMakeChange };
+	if (statuses != expected)
+	{
+		AddError(TEXT("The request did not resolve with one status per entry."));
+	}
+
+	if (quantityWhenResolved != 50)
+	{
+		AddError(TEXT("The request resolved before its changes were committed."));
+	}
+
+	TFuture<FInventoryRequestResult> spend = inventory->ModifyInventoryAsync({ FInventoryEntry(gold, -20) });
+	if (!spend.IsReady() || spend.Get().Outcome != EInventoryRequestOutcome::Committed || spend.Get().GroupStatus != EChangeGroupStatus::AllSuccessful)
+	{
+		AddError(TEXT("A request answered on the server was not resolved as committed."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPersistenceTellsEmptyFromMissing, "Inventory.Persistence Tells Empty From Missing", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryPersistenceTellsEmptyFromMissing::RunTest(const FString& Parameters)
+{
+	const FString directory = FPaths::ProjectIntermediateDir() / TEXT("InventoryTests") / TEXT("Persistence");
+	IFileManager::Get().DeleteDirectory(*directory, false, true);
+	FFileInventoryPersistenceBackend backend(directory);
+
+	TArray<FInventoryPersistenceRecord> batch;
+	batch.AddDefaulted_GetRef().InventoryId = TEXT("Emptied");
+	FInventoryPersistenceRecord& full = batch.AddDefaulted_GetRef();
+	full.InventoryId = TEXT("Full");
+	full.Entries.Emplace(FName(TEXT("Potion")), 3);
+	if (!backend.SaveBatch(batch))
+	{
+		AddError(TEXT("Saving to the file backend failed."));
+		return false;
+	}
+
+	FInventoryPersistenceRecord loaded;
+	if (backend.Load(TEXT("Emptied"), loaded) != EInventoryLoadResult::Found || loaded.Entries.Num() != 0)
+	{
+		AddError(TEXT("Inventory saved empty did not load as found and empty."));
+	}
+
+	if (backend.Load(TEXT("Full"), loaded) != EInventoryLoadResult::Found || loaded.Entries != full.Entries)
+	{
+		AddError(TEXT("Saved entries did not load back."));
+	}
+
+	if (backend.Load(TEXT("NeverSaved"), loaded) != EInventoryLoadResult::NotFound)
+	{
+		AddError(TEXT("Inventory never saved was not reported as not found."));
+	}
+
+	IFileManager::Get().DeleteDirectory(*directory, false, true);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPersistenceSavesCounters, "Inventory.Persistence Saves Counters", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryPersistenceSavesCounters::RunTest(const FString& Parameters)
+{
+	const FName gold(TEXT("PersistenceTestGold"));
+	FInventoryItemRegistry::Get().RegisterCounter(gold, FInventoryCounterPolicy());
+
+	UReplicationInventoryComponent* inventory = NewObject<UReplicationInventoryComponent>();
+	inventory->AddItemToInventory(FName(TEXT("Potion")), 2);
+	inventory->AddToCounter(gold, 5000000000ll);
+
+	FInventoryPersistenceRecord record;
+	record.InventoryId = TEXT("Rich");
+	inventory->GetEntries(record.Entries);
+	inventory->GetCounterValues(record.Counters);
+	if (record.Counters.Num() != 1 || record.Entries.ContainsByPredicate([gold](const FInventoryEntry& entry) { return entry.ItemCode == gold; }))
+	{
+		AddError(TEXT("Counters should be collected apart from the entries."));
+	}
+
+	const FString directory = FPaths::ProjectIntermediateDir() / TEXT("InventoryTests") / TEXT("PersistenceCounters");
+	IFileManager::Get().DeleteDirectory(*directory, false, true);
+	FFileInventoryPersistenceBackend backend(directory);
+
+	FInventoryPersistenceRecord loaded;
+	if (!backend.SaveBatch({ record }) || backend.Load(TEXT("Rich"), loaded) != EInventoryLoadResult::Found)
+	{
+		AddError(TEXT("Saving and loading through the file backend failed."));
+	}
+	else if (loaded.Counters.Num() != 1 || loaded.Counters[0].ItemCode != gold || loaded.Counters[0].Value != 5000000000ll || loaded.Entries != record.Entries)
+	{
+		AddError(TEXT("Saved counter value did not load back."));
+	}
+
+	IFileManager::Get().DeleteDirectory(*directory, false, true);
+	FInventoryItemRegistry::Get().UnregisterItem(gold);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPersistenceSavesExpiries, "Inventory.Persistence Saves Expiries", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryPersistenceSavesExpiries::RunTest(const FString& Parameters)
+{
+	const FString directory = FPaths::ProjectIntermediateDir() / TEXT("InventoryTests") / TEXT("PersistenceExpiries");
+	IFileManager::Get().DeleteDirectory(*directory, false, true);
+	FFileInventoryPersistenceBackend backend(directory);
+
+	FInventoryPersistenceRecord record;
+	record.InventoryId = TEXT("Renter");
+	record.Entries.Emplace(FName(TEXT("RentedSword")), 1);
+	record.Expiries.Emplace(FName(TEXT("RentedSword")), FDateTime::UtcNow() + FTimespan::FromHours(2.0));
+
+	FInventoryPersistenceRecord loaded;
+	if (!backend.SaveBatch({ record }) || backend.Load(TEXT("Renter"), loaded) != EInventoryLoadResult::Found)
+	{
+		AddError(TEXT("Saving and loading through the file backend failed."));
+	}
+	else if (loaded.Expiries.Num() != 1 || loaded.Expiries[0].ItemCode != record.Expiries[0].ItemCode || loaded.Expiries[0].ExpiresUtc != record.Expiries[0].ExpiresUtc)
+	{
+		AddError(TEXT("A saved expiry should load back as the same UTC time, not as a permanent item."));
+	}
+
+	IFileManager::Get().DeleteDirectory(*directory, false, true);
+	return true;
+}
+
+namespace
+{
+	// Fails every save while bFailing is set and keeps the last saved record per id
+	class FFlakyPersistenceBackend : public IInventoryPersistenceBackend
+	{
+	public:
+		virtual bool SaveBatch(const TArray<FInventoryPersistenceRecord>& records) override
+		{
+			FScopeLock lock(&Lock);
+			if (bFailing)
+			{
+				FailedSaves++;
+				return false;
+			}
+
+			for (const FInventoryPersistenceRecord& record : records)
+			{
+				Saved.Add(record.InventoryId, record);
+			}
+			return true;
+		}
+
+		virtual EInventoryLoadResult Load(const FString& inventoryId, FInventoryPersistenceRecord& outRecord) override
+		{
+			FScopeLock lock(&Lock);
+			const FInventoryPersistenceRecord* record = Saved.Find(inventoryId);
+			if (record == nullptr)
+			{
+				return EInventoryLoadResult::NotFound;
+			}
+			outRecord = *record;
+			return EInventoryLoadResult::Found;
+		}
+
+		FCriticalSection Lock;
+		bool bFailing = true;
+		int32 FailedSaves = 0;
+		TMap<FString, FInventoryPersistenceRecord> Saved;
+	};
+
+	FInventoryPersistenceRecord MakeRecord(const TCHAR* inventoryId, int32 potions)
+	{
+		FInventoryPersistenceRecord record;
+		record.InventoryId = inventoryId;
+		record.Entries.Emplace(FName(TEXT("Potion")), potions);
+		return record;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPersistenceKeepsFailedBatches, "Inventory.Persistence Keeps Failed Batches", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryPersistenceKeepsFailedBatches::RunTest(const FString& Parameters)
+{
+	TSharedRef<FFlakyPersistenceBackend, ESPMode::ThreadSafe> backend = MakeShared<FFlakyPersistenceBackend, ESPMode::ThreadSafe>();
+
+	FWriteBehindSettings settings;
+	settings.MaxSaveAttempts = 1;
+	settings.RetryIntervalSeconds = 0.05f;
+	FWriteBehindInventoryWriter writer(backend, settings);
+
+	TArray<FInventoryPersistenceRecord> first = { MakeRecord(TEXT("Stale"), 1), MakeRecord(TEXT("Untouched"), 2) };
+	writer.Enqueue(MoveTemp(first));
+
+	const double deadline = FPlatformTime::Seconds() + 5.0;
+	while (writer.NumUnsavedInventories() == 0 && FPlatformTime::Seconds() < deadline)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+
+	if (writer.NumUnsavedInventories() != 2)
+	{
+		AddError(TEXT("Records of a batch that failed every attempt were not kept."));
+	}
+
+	// Newer contents for one of the kept inventories supersede the failed record
+	TArray<FInventoryPersistenceRecord> second = { MakeRecord(TEXT("Stale"), 5) };
+	{
+		FScopeLock lock(&backend->Lock);
+		backend->bFailing = false;
+	}
+	writer.Enqueue(MoveTemp(second));
+
+	while ((writer.NumQueuedBatches() > 0 || writer.NumUnsavedInventories() > 0) && FPlatformTime::Seconds() < deadline)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+	writer.Shutdown();
+
+	FInventoryPersistenceRecord loaded;
+	if (backend->Load(TEXT("Untouched"), loaded) != EInventoryLoadResult::Found || loaded.Entries[0].Quantity != 2)
+	{
+		AddError(TEXT("Failed batch was dropped instead of saved on a later attempt."));
+	}
+
+	if (backend->Load(TEXT("Stale"), loaded) != EInventoryLoadResult::Found || loaded.Entries[0].Quantity != 5)
+	{
+		AddError(TEXT("A retried record overwrote newer contents of the same inventory."));
+	}
+
+	return true;
+}
+
+namespace
+{
+	// A server inventory owned by the server's only simulated client, and the client end of it in the same world
+	void SpawnInventoryPair(FInventorySimulatedServer& server, UInventoryLoopbackComponent*& outClient, UInventoryLoopbackComponent*& outServer)
+	{
+		AActor* serverActor = server.SpawnActor(0);
+		outServer = NewObject<UInventoryLoopbackComponent>(serverActor);
+		outServer->RegisterComponent();
+
+		AActor* clientActor = server.SpawnActor();
+		clientActor->SetReplicates(false);
+		clientActor->SetRole(ROLE_AutonomousProxy);
+		outClient = NewObject<UInventoryLoopbackComponent>(clientActor);
+		outClient->RegisterComponent();
+
+		outClient->Peer = outServer;
+		outServer->Peer = outClient;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryRequestsAreAnsweredInOrder, "Inventory.Requests Are Answered In Order", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryRequestsAreAnsweredInOrder::RunTest(const FString& Parameters)
+{
+	if (GetDefault<UInventoryRateLimitSettings>()->bScheduleOutgoingTraffic)
+	{
+		AddInfo(TEXT("Outgoing traffic is scheduled, so nothing is sent until the world ticks; skipping."));
+		return true;
+	}
+
+	const FName arrow(TEXT("Arrow"));
+	const FName gold(TEXT("RequestTestGold"));
+	FInventoryItemRegistry::Get().RegisterCounter(gold, FInventoryCounterPolicy());
+
+	FInventorySimulatedServer server(1);
+	UInventoryLoopbackComponent* client = nullptr;
+	UInventoryLoopbackComponent* serverInventory = nullptr;
+	SpawnInventoryPair(server, client, serverInventory);
+
+	const TArray<TArray<FInventoryEntry>> requests = {
+		{ FInventoryEntry(arrow, 10), FInventoryEntry(gold, 100) },
+		{ FInventoryEntry(FName(TEXT("Bolt")), -5) },  // Not held
+		{ FInventoryEntry(arrow, -4) }
+	};
+
+	TArray<int32> answeredIds;
+	TArray<FInventoryRequestResult> results;
+	TArray<int32> quantitiesWhenAnswered;
+	for (const TArray<FInventoryEntry>& changes : requests)
+	{
+		client->ModifyInventoryAsync(changes).Next([&answeredIds, &results, &quantitiesWhenAnswered, serverInventory, arrow](const FInventoryRequestResult& result)
+		{
+			answeredIds.Add(result.RequestId);
+			results.Add(result);
+			quantitiesWhenAnswered.Add(serverInventory->GetQuantityFor(arrow));
+		});
+	}
+
+	if (answeredIds.Num() != requests.Num() || answeredIds[1] != answeredIds[0] + 1 || answeredIds[2] != answeredIds[1] + 1)
+	{
+		AddError(TEXT("Requests were not answered in the order they were made."));
+	}
+	else
+	{
+		const TArray<int32> expectedQuantities = { 10, 10, 6 };
+		if (quantitiesWhenAnswered != expectedQuantities)
+		{
+			AddError(TEXT("A request was answered before its changes were applied."));
+		}
+
+		const TArray<EChangeStatus> expectedFirst = { EChangeStatus::Success, EChangeStatus::Success };
+		if (results[0].EntryStatuses != expectedFirst || results[1].GroupStatus == EChangeGroupStatus::AllSuccessful || results[2].GroupStatus != EChangeGroupStatus::AllSuccessful)
+		{
+			AddError(TEXT("Requests were answered with the wrong statuses."));
+		}
+	}
+
+	if (serverInventory->GetCounterValue(gold) != 100 || client->GetCounterValue(gold) != 100)
+	{
+		AddError(TEXT("The counter change in a request did not reach the client."));
+	}
+
+	FInventoryItemRegistry::Get().UnregisterItem(gold);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryRequestedCountersKeepTheirRate, "Inventory.Requested Counters Keep Their Rate", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryRequestedCountersKeepTheirRate::RunTest(const FString& Parameters)
+{
+	const int32 numRequests = 10;
+	const UInventoryRateLimitSettings* settings = GetDefault<UInventoryRateLimitSettings>();
+	if (settings->bEnableRateLimiting && settings->RequestBurst <= numRequests)
+	{
+		AddInfo(TEXT("The request burst is configured too low to send every request at once; skipping."));
+		return true;
+	}
+
+	if (settings->bScheduleOutgoingTraffic)
+	{
+		AddInfo(TEXT("Outgoing traffic is scheduled, so nothing is sent until the world ticks; skipping."));
+		return true;
+	}
+
+	const FName gold(TEXT("RequestRateTestGold"));
+	FInventoryCounterPolicy policy;
+	policy.MaxUpdatesPerSecond = 1.0f;
+	FInventoryItemRegistry::Get().RegisterCounter(gold, policy);
+
+	FInventorySimulatedServer server(1);
+	UInventoryLoopbackComponent* client = nullptr;
+	UInventoryLoopbackComponent* serverInventory = nullptr;
+	SpawnInventoryPair(server, client, serverInventory);
+
+	TArray<int32> answeredIds;
+	auto makeRequest = [client, gold, &answeredIds]()
+	{
+		client->ModifyInventoryAsync({ FInventoryEntry(gold, 1) }).Next([&answeredIds](const FInventoryRequestResult& result)
+		{
+			answeredIds.Add(result.RequestId);
+		});
+	};
+
+	// Only the first change is due; the others' answers wait for the counter's next update
+	for (int32 i = 0; i < numRequests; i++)
+	{
+		makeRequest();
+	}
+
+	if (serverInventory->NumCounterUpdatesSent != 1 || answeredIds.Num() != 1)
+	{
+		AddError(FString::Printf(TEXT("Expected 1 counter update and 1 answer within the first second, got %i updates and %i answers."), serverInventory->NumCounterUpdatesSent, answeredIds.Num()));
+	}
+
+	FPlatformProcess::Sleep(1.05f);
+	makeRequest();
+
+	bool bInOrder = answeredIds.Num() == numRequests + 1;
+	for (int32 i = 1; bInOrder && i < answeredIds.Num(); i++)
+	{
+		bInOrder = answeredIds[i] == answeredIds[i - 1] + 1;
+	}
+
+	if (serverInventory->NumCounterUpdatesSent != 2 || !bInOrder)
+	{
+		AddError(FString::Printf(TEXT("Expected 2 counter updates and %i answers in order after a second, got %i updates and %i answers."), numRequests + 1, serverInventory->NumCounterUpdatesSent, answeredIds.Num()));
+	}
+
+	if (client->GetCounterValue(gold) != numRequests + 1)
+	{
+		AddError(TEXT("Answers were released before the counter value they depend on."));
+	}
+
+	FInventoryItemRegistry::Get().UnregisterItem(gold);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryDroppedRequestsAreRejected, "Inventory.Dropped Requests Are Rejected", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryDroppedRequestsAreRejected::RunTest(const FString& Parameters)
+{
+	const UInventoryRateLimitSettings* settings = GetDefault<UInventoryRateLimitSettings>();
+	if (!settings->bEnableRateLimiting)
+	{
+		AddInfo(TEXT("Rate limiting is configured off; skipping."));
+		return true;
+	}
+
+	FInventorySimulatedServer server(1);
+	UInventoryLoopbackComponent* client = nullptr;
+	UInventoryLoopbackComponent* serverInventory = nullptr;
+	SpawnInventoryPair(server, client, serverInventory);
+
+	// More entries than the burst allows is always dropped
+	TArray<FInventoryEntry> changes;
+	for (int32 i = 0; i <= settings->EntryBurst; i++)
+	{
+		changes.Emplace(FName(*FString::Printf(TEXT("Item%i"), i)), 1);
+	}
+
+	TFuture<FInventoryRequestResult> future = client->ModifyInventoryAsync(changes);
+	if (!future.IsReady() || future.Get().Outcome != EInventoryRequestOutcome::Rejected)
+	{
+		AddError(TEXT("A request dropped by rate limiting was not answered as rejected."));
+	}
+
+	TArray<FInventoryEntry> entries;
+	serverInventory->GetEntries(entries);
+	if (entries.Num() != 0)
+	{
+		AddError(TEXT("A dropped request changed the inventory."));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPendingRequestsCancelAtEndPlay, "Inventory.Pending Requests Cancel At End Play", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryPendingRequestsCancelAtEndPlay::RunTest(const FString& Parameters)
+{
+	FInventorySimulatedServer server(1);
+	UInventoryLoopbackComponent* client = nullptr;
+	UInventoryLoopbackComponent* serverInventory = nullptr;
+	SpawnInventoryPair(server, client, serverInventory);
+
+	// Lost on the way, so never answered
+	client->Peer = nullptr;
+	TFuture<FInventoryRequestResult> first = client->ModifyInventoryAsync({ FInventoryEntry(FName(TEXT("Arrow")), 1) });
+	TFuture<FInventoryRequestResult> second = client->ModifyInventoryAsync({ FInventoryEntry(FName(TEXT("Arrow")), 2) });
+
+	if (first.IsReady() || second.IsReady())
+	{
+		AddError(TEXT("Requests were answered without reaching the server."));
+	}
+
+	client->GetOwner()->Destroy();
+
+	if (!first.IsReady() || !second.IsReady())
+	{
+		AddError(TEXT("Unanswered requests were left pending after EndPlay."));
+	}
+	else if (first.Get().Outcome != EInventoryRequestOutcome::Cancelled || second.Get().Outcome != EInventoryRequestOutcome::Cancelled || second.Get().RequestId != first.Get().RequestId + 1)
+	{
+		AddError(TEXT("Unanswered requests were not cancelled at EndPlay."));
+	}
+
+	return true;
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryTimingWheel.h"
+
+FInventoryTimingWheel::FInventoryTimingWheel(double secondsPerTick)
+	: SecondsPerTick(FMath::Max(secondsPerTick, 0.001)), CurrentTick(0), NextTimerId(1)
+{
+	Slots.SetNum(NumLevels * SlotsPerLevel);
+}
+
+uint64 FInventoryTimingWheel::Schedule(double expiryTime, const FInventoryExpiryTimer& timer)
+{
+	// The current tick has already been processed
+	const int64 expiryTick = FMath::Max((int64)FMath::CeilToDouble(expiryTime / SecondsPerTick), CurrentTick + 1);
+
+	const uint64 timerId = NextTimerId++;
+	FScheduledTimer& scheduled = Timers.Add(timerId);
+	scheduled.Timer = timer;
+	scheduled.ExpiryTick = expiryTick;
+	Insert(timerId, expiryTick);
+	return timerId;
+}
+
+bool FInventoryTimingWheel::Cancel(uint64 timerId)
+{
+	return Timers.Remove(timerId) > 0;
+}
+
+void FInventoryTimingWheel::Insert(uint64 timerId, int64 expiryTick)
+{
+	const int64 delta = expiryTick - CurrentTick;
+	int32 level = 0;
+	while (level < NumLevels - 1 && delta >= (int64(1) << (SlotBits * (level + 1))))
+	{
+		level++;
+	}
+
+	// Past the top level's range: park it in the furthest top slot and place it again when that slot comes round
+	const int64 horizon = int64(1) << (SlotBits * NumLevels);
+	const int64 placementTick = delta < horizon ? expiryTick : CurrentTick + horizon - 1;
+	GetSlot(level, placementTick).Add(timerId);
+}
+
+TArray<uint64>& FInventoryTimingWheel::GetSlot(int32 level, int64 tick)
+{
+	return Slots[level * SlotsPerLevel + (int32)((tick >> (SlotBits * level)) & (SlotsPerLevel - 1))];
+}
+
+void FInventoryTimingWheel::Advance(double currentTime, TArray<FInventoryExpiryTimer>& outExpired)
+{
+	const int64 targetTick = (int64)FMath::FloorToDouble(currentTime / SecondsPerTick);
+	while (CurrentTick < targetTick)
+	{
+		if (Timers.Num() == 0)
+		{
+			CurrentTick = targetTick;
+			break;
+		}
+
+		const int64 tick = ++CurrentTick;
+
+		// A slot of a higher level is due once every tick below it has passed; its timers move down
+		for (int32 level = NumLevels - 1; level > 0; level--)
+		{
+			if ((tick & ((int64(1) << (SlotBits * level)) - 1)) != 0)
+			{
+				continue;
+			}
+
+			TArray<uint64> cascading = MoveTemp(GetSlot(level, tick));
+			for (uint64 timerId : cascading)
+			{
+				if (const FScheduledTimer* scheduled = Timers.Find(timerId))
+				{
+					Insert(timerId, scheduled->ExpiryTick);
+				}
+			}
+		}
+
+		TArray<uint64> due = MoveTemp(GetSlot(0, tick));
+		for (uint64 timerId : due)
+		{
+			const FScheduledTimer* scheduled = Timers.Find(timerId);
+			if (scheduled == nullptr)
+			{
+				continue;
+			}
+
+			if (scheduled->ExpiryTick <= tick)
+			{
+				outExpired.Add(scheduled->Timer);
+				Timers.Remove(timerId);
+			}
+			else
+			{
+				Insert(timerId, scheduled->ExpiryTick);
+			}
+		}
+	}
+}
+
+int32 FInventoryTimingWheel::Num() const
+{
+	return Timers.Num();
+}
+
+double FInventoryTimingWheel::GetSecondsPerTick() const
+{
+	return SecondsPerTick;
+}
+
+SIZE_T FInventoryTimingWheel::GetAllocatedSize() const
+{
+	SIZE_T size = Timers.GetAllocatedSize() + Slots.GetAllocatedSize();
+	for (const TArray<uint64>& slot : Slots)
+	{
+		size += slot.GetAllocatedSize();
+	}
+	return size;
+}
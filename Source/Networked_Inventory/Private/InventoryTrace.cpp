@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryTrace.h"
+#include "InventoryNetSerialization.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "InventoryMemory.h"
+
+namespace InventoryTrace
+{
+	static const uint32 Magic = 0x54564E49;  // "INVT"
+	static const uint32 Version = 1;
+
+	// Each record starts with one of these
+	static const uint8 NameRecord = 0;
+	static const uint8 EventRecord = 1;
+
+	static const int32 FlushThreshold = 64 * 1024;
+}
+
+bool FInventoryTraceRecorder::bRecording = false;
+
+FInventoryTraceRecorder& FInventoryTraceRecorder::Get()
+{
+	static FInventoryTraceRecorder Recorder;
+	return Recorder;
+}
+
+FInventoryTraceRecorder::FInventoryTraceRecorder() : LastEventTime(0.0), NumEvents(0)
+{
+}
+
+FInventoryTraceRecorder::~FInventoryTraceRecorder()
+{
+	// Static teardown: logging may already be gone, so just get the data out
+	bRecording = false;
+	FlushBuffer();
+	File.Reset();
+}
+
+bool FInventoryTraceRecorder::Start(const FString& path)
+{
+	Stop();
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(path), true);
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*path));
+	if (!File.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open inventory trace %s for writing."), *path);
+		return false;
+	}
+
+	NameIndices.Reset();
+	ItemIndices.Reset();
+	InventoryIndices.Reset();
+	NumEvents = 0;
+	LastEventTime = FPlatformTime::Seconds();
+
+	Buffer.Reset();
+	FMemoryWriter writer(Buffer);
+	uint32 magic = InventoryTrace::Magic;
+	uint32 version = InventoryTrace::Version;
+	writer << magic << version;
+
+	bRecording = true;
+	UE_LOG(LogTemp, Log, TEXT("Recording inventory trace to %s."), *path);
+	return true;
+}
+
+void FInventoryTraceRecorder::Stop()
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	bRecording = false;
+	FlushBuffer();
+	File.Reset();
+
+	UE_LOG(LogTemp, Log, TEXT("Stopped inventory trace after %lld events."), NumEvents);
+}
+
+void FInventoryTraceRecorder::Record(const UObject* inventory, EInventoryTraceOp op, const TArray<FInventoryEntry>& entries)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (!bRecording || inventory == nullptr)
+	{
+		return;
+	}
+	check(IsInGameThread());
+
+	int32 inventoryIndex;
+	if (const int32* knownIndex = InventoryIndices.Find(inventory))
+	{
+		inventoryIndex = *knownIndex;
+	}
+	else
+	{
+		inventoryIndex = GetNameIndex(inventory->GetPathName());
+		InventoryIndices.Add(inventory, inventoryIndex);
+	}
+
+	TArray<uint32, TInlineAllocator<16>> itemIndices;
+	for (const FInventoryEntry& entry : entries)
+	{
+		const int32* knownIndex = ItemIndices.Find(entry.ItemCode);
+		itemIndices.Add(knownIndex ? *knownIndex : ItemIndices.Add(entry.ItemCode, GetNameIndex(entry.ItemCode.ToString())));
+	}
+
+	// Microseconds since the previous event
+	const double now = FPlatformTime::Seconds();
+	uint32 timeDelta = (uint32)FMath::Clamp((now - LastEventTime) * 1000000.0, 0.0, (double)MAX_uint32);
+	LastEventTime += timeDelta / 1000000.0;
+
+	FMemoryWriter writer(Buffer);
+	writer.Seek(Buffer.Num());
+
+	uint8 recordType = InventoryTrace::EventRecord;
+	uint8 opCode = (uint8)op;
+	uint32 packedInventory = inventoryIndex;
+	uint32 numEntries = entries.Num();
+	writer << recordType;
+	writer.SerializeIntPacked(timeDelta);
+	writer.SerializeIntPacked(packedInventory);
+	writer << opCode;
+	writer.SerializeIntPacked(numEntries);
+	for (int32 i = 0; i < entries.Num(); i++)
+	{
+		int32 quantity = entries[i].Quantity;
+		writer.SerializeIntPacked(itemIndices[i]);
+		InventoryNetSerialization::SerializeSignedPacked(writer, quantity);
+	}
+
+	NumEvents++;
+	if (Buffer.Num() >= InventoryTrace::FlushThreshold)
+	{
+		FlushBuffer();
+	}
+}
+
+int64 FInventoryTraceRecorder::NumRecordedEvents() const
+{
+	return NumEvents;
+}
+
+int32 FInventoryTraceRecorder::GetNameIndex(const FString& name)
+{
+	if (const int32* index = NameIndices.Find(name))
+	{
+		return *index;
+	}
+
+	// Name records are numbered implicitly in the order they appear
+	FMemoryWriter writer(Buffer);
+	writer.Seek(Buffer.Num());
+	uint8 recordType = InventoryTrace::NameRecord;
+	FString nameCopy = name;
+	writer << recordType << nameCopy;
+
+	return NameIndices.Add(name, NameIndices.Num());
+}
+
+void FInventoryTraceRecorder::FlushBuffer()
+{
+	if (File.IsValid() && Buffer.Num() > 0)
+	{
+		File->Write(Buffer.GetData(), Buffer.Num());
+	}
+	Buffer.Reset();
+}
+
+FInventoryTraceReader::FInventoryTraceReader() : Offset(0), Time(0.0), bError(false)
+{
+}
+
+bool FInventoryTraceReader::Open(const FString& path)
+{
+	Names.Reset();
+	Time = 0.0;
+	bError = false;
+
+	if (!FFileHelper::LoadFileToArray(Data, *path))
+	{
+		bError = true;
+		return false;
+	}
+
+	FMemoryReader reader(Data);
+	uint32 magic = 0;
+	uint32 version = 0;
+	reader << magic << version;
+	Offset = reader.Tell();
+
+	bError = reader.IsError() || magic != InventoryTrace::Magic || version != InventoryTrace::Version;
+	return !bError;
+}
+
+bool FInventoryTraceReader::Next(FInventoryTraceEvent& outEvent)
+{
+	FMemoryReader reader(Data);
+	reader.Seek(Offset);
+
+	while (!bError && reader.Tell() < Data.Num())
+	{
+		uint8 recordType = 0;
+		reader << recordType;
+
+		if (recordType == InventoryTrace::NameRecord)
+		{
+			reader << Names.AddDefaulted_GetRef();
+			continue;
+		}
+
+		if (recordType != InventoryTrace::EventRecord)
+		{
+			bError = true;
+			break;
+		}
+
+		uint32 timeDelta = 0;
+		uint32 inventoryIndex = 0;
+		uint8 opCode = 0;
+		uint32 numEntries = 0;
+		reader.SerializeIntPacked(timeDelta);
+		reader.SerializeIntPacked(inventoryIndex);
+		reader << opCode;
+		reader.SerializeIntPacked(numEntries);
+
+		// Every entry takes at least two bytes
+		if (reader.IsError() || !Names.IsValidIndex(inventoryIndex) || opCode >= (uint8)EInventoryTraceOp::Count || numEntries > (uint32)(Data.Num() - reader.Tell()) / 2)
+		{
+			bError = true;
+			break;
+		}
+
+		Time += timeDelta / 1000000.0;
+		outEvent.Time = Time;
+		outEvent.InventoryId = Names[inventoryIndex];
+		outEvent.Op = (EInventoryTraceOp)opCode;
+		outEvent.Entries.Reset(numEntries);
+
+		for (uint32 i = 0; i < numEntries; i++)
+		{
+			uint32 itemIndex = 0;
+			int32 quantity = 0;
+			reader.SerializeIntPacked(itemIndex);
+			InventoryNetSerialization::SerializeSignedPacked(reader, quantity);
+			if (!Names.IsValidIndex(itemIndex))
+			{
+				bError = true;
+				break;
+			}
+			outEvent.Entries.Emplace(FName(*Names[itemIndex]), quantity);
+		}
+
+		bError |= reader.IsError();
+		Offset = reader.Tell();
+		return !bError;
+	}
+
+	bError |= reader.IsError();
+	Offset = reader.Tell();
+	return false;
+}
+
+bool FInventoryTraceReader::IsError() const
+{
+	return bError;
+}
+
+static FAutoConsoleCommand StartInventoryTraceCommand(
+	TEXT("Inventory.Trace.Start"),
+	TEXT("Starts recording inventory mutations. Optional argument: trace file path."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		const FString path = args.Num() > 0 ? args[0]
+			: FPaths::ProjectSavedDir() / TEXT("InventoryTraces") / FString::Printf(TEXT("Inventory-%s.invtrace"), *FDateTime::Now().ToString());
+		FInventoryTraceRecorder::Get().Start(path);
+	}));
+
+static FAutoConsoleCommand StopInventoryTraceCommand(
+	TEXT("Inventory.Trace.Stop"),
+	TEXT("Stops recording inventory mutations."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FInventoryTraceRecorder::Get().Stop();
+	}));
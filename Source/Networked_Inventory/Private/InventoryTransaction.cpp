@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryTransaction.h"
+#include "InventoryInterface.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+
+FInventoryTransaction::FInventoryTransaction() : BuildStatus(ETransferStatus::Success), bCommitted(false)
+{
+}
+
+void FInventoryTransaction::Transfer(IInventoryInterface* source, IInventoryInterface* destination, const TArray<FInventoryEntry>& entries)
+{
+	if (source == nullptr || destination == nullptr || source == destination)
+	{
+		BuildStatus = ETransferStatus::InvalidInventory;
+		return;
+	}
+
+	// Adding the destination may grow the array, so the source is looked up again afterwards
+	FindOrAddChanges(source);
+	FInventoryChanges* destinationChanges = FindOrAddChanges(destination);
+	FInventoryChanges* sourceChanges = FindOrAddChanges(source);
+
+	for (const FInventoryEntry& entry : entries)
+	{
+		if (entry.Quantity <= 0)
+		{
+			BuildStatus = ETransferStatus::InvalidQuantity;
+			return;
+		}
+
+		sourceChanges->Changes.FindOrAdd(entry.ItemCode, 0) -= entry.Quantity;
+		destinationChanges->Changes.FindOrAdd(entry.ItemCode, 0) += entry.Quantity;
+	}
+}
+
+void FInventoryTransaction::Modify(IInventoryInterface* inventory, const TArray<FInventoryEntry>& changes)
+{
+	if (inventory == nullptr)
+	{
+		BuildStatus = ETransferStatus::InvalidInventory;
+		return;
+	}
+
+	FInventoryChanges* inventoryChanges = FindOrAddChanges(inventory);
+	for (const FInventoryEntry& entry : changes)
+	{
+		inventoryChanges->Changes.FindOrAdd(entry.ItemCode, 0) += entry.Quantity;
+	}
+}
+
+ETransferStatus FInventoryTransaction::Validate() const
+{
+	if (BuildStatus != ETransferStatus::Success)
+	{
+		return BuildStatus;
+	}
+
+	for (const FInventoryChanges& participant : Participants)
+	{
+		UObject* inventoryObject = participant.Inventory->_getUObject();
+		if (!IsValid(inventoryObject))
+		{
+			return ETransferStatus::InvalidInventory;
+		}
+
+		// Only the server may move items; a client would just desync from it
+		const UActorComponent* component = Cast<UActorComponent>(inventoryObject);
+		const AActor* owner = component ? component->GetOwner() : nullptr;
+		if (owner != nullptr && owner->GetLocalRole() != ROLE_Authority)
+		{
+			return ETransferStatus::NotAuthority;
+		}
+
+		for (const auto& pair : participant.Changes)
+		{
+			const int64 newQuantity = (int64)participant.Inventory->GetQuantityFor(pair.Key) + pair.Value;
+			if (newQuantity < 0)
+			{
+				return ETransferStatus::InsufficientQuantity;
+			}
+			if (newQuantity > MAX_int32)
+			{
+				return ETransferStatus::InvalidQuantity;
+			}
+		}
+	}
+
+	return ETransferStatus::Success;
+}
+
+ETransferStatus FInventoryTransaction::Commit()
+{
+	if (!ensureMsgf(!bCommitted, TEXT("Inventory transaction committed twice.")))
+	{
+		return ETransferStatus::InvalidInventory;
+	}
+
+	const ETransferStatus status = Validate();
+	if (status != ETransferStatus::Success)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Inventory transaction rejected: %s"), *UEnum::GetValueAsString(status));
+		return status;
+	}
+
+	bCommitted = true;
+
+	// Validation guarantees every resulting quantity fits in [0, MAX_int32], so each net change does as well
+	TArray<FInventoryEntry> changes;
+	for (const FInventoryChanges& participant : Participants)
+	{
+		changes.Reset(participant.Changes.Num());
+		for (const auto& pair : participant.Changes)
+		{
+			if (pair.Value != 0)
+			{
+				changes.Emplace(pair.Key, (int32)pair.Value);
+			}
+		}
+
+		if (changes.Num() > 0)
+		{
+			participant.Inventory->ModifyInventory(changes);
+		}
+	}
+
+	return ETransferStatus::Success;
+}
+
+const TMap<FName, int64>* FInventoryTransaction::FindChanges(const IInventoryInterface* inventory) const
+{
+	for (const FInventoryChanges& participant : Participants)
+	{
+		if (participant.Inventory == inventory)
+		{
+			return &participant.Changes;
+		}
+	}
+	return nullptr;
+}
+
+int32 FInventoryTransaction::NumInventories() const
+{
+	return Participants.Num();
+}
+
+FInventoryTransaction::FInventoryChanges* FInventoryTransaction::FindOrAddChanges(IInventoryInterface* inventory)
+{
+	// Transactions rarely touch more than a handful of inventories, so a linear search beats a map here
+	for (FInventoryChanges& participant : Participants)
+	{
+		if (participant.Inventory == inventory)
+		{
+			return &participant;
+		}
+	}
+
+	FInventoryChanges& participant = Participants.AddDefaulted_GetRef();
+	participant.Inventory = inventory;
+	return &participant;
+}
+
+ETransferStatus InventoryTransfer::TransferItems(IInventoryInterface* source, IInventoryInterface* destination, const TArray<FInventoryEntry>& entries)
+{
+	FInventoryTransaction transaction;
+	transaction.Transfer(source, destination, entries);
+	return transaction.Commit();
+}
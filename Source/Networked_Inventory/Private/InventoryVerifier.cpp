@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryVerifier.h"
+#include "InventoryMemory.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarInventoryVerify(
+	TEXT("Inventory.Verify"),
+	0,
+	TEXT("Checks a sample of inventory mutation batches for internal consistency on a background task (0 = off, 1 = on)."));
+
+static TAutoConsoleVariable<float> CVarInventoryVerifySampleRate(
+	TEXT("Inventory.Verify.SampleRate"),
+	0.01f,
+	TEXT("Fraction of inventory mutation batches checked while Inventory.Verify is on (0 to 1)."));
+
+FInventoryVerifier& FInventoryVerifier::Get()
+{
+	static FInventoryVerifier Verifier;
+	return Verifier;
+}
+
+FInventoryVerifier::FInventoryVerifier() : NumTasksInFlight(0), NumVerified(0), NumFound(0)
+{
+}
+
+bool FInventoryVerifier::ShouldSample()
+{
+	return CVarInventoryVerify.GetValueOnGameThread() != 0 && FMath::FRand() < CVarInventoryVerifySampleRate.GetValueOnGameThread();
+}
+
+void FInventoryVerifier::Submit(FInventoryVerificationSample&& sample)
+{
+	if (++NumTasksInFlight > MaxTasksInFlight)
+	{
+		--NumTasksInFlight;
+		return;
+	}
+
+	Async(EAsyncExecution::ThreadPool, [this, sample = MoveTemp(sample)]()
+	{
+		LLM_SCOPE_BYTAG(NetworkedInventory);
+		TArray<FString> violations;
+		Verify(sample, violations);
+
+		++NumVerified;
+		if (violations.Num() > 0)
+		{
+			NumFound += violations.Num();
+			UE_LOG(LogTemp, Error, TEXT("Inventory verifier found %i problem(s) in %s (%i entries, snapshot version %llu):"),
+				violations.Num(), *sample.Context, sample.Entries.Num(), sample.Snapshot.IsValid() ? sample.Snapshot->GetVersion() : 0ull);
+			for (const FString& violation : violations)
+			{
+				UE_LOG(LogTemp, Error, TEXT("  %s"), *violation);
+			}
+		}
+
+		--NumTasksInFlight;
+	});
+}
+
+void FInventoryVerifier::Verify(const FInventoryVerificationSample& sample, TArray<FString>& outViolations)
+{
+	TSet<FName> seenItems;
+	seenItems.Reserve(sample.Entries.Num());
+	for (int32 i = 0; i < sample.Entries.Num(); i++)
+	{
+		const FInventoryEntry& entry = sample.Entries[i];
+
+		bool bDuplicate = false;
+		seenItems.Add(entry.ItemCode, &bDuplicate);
+		if (bDuplicate)
+		{
+			outViolations.Add(FString::Printf(TEXT("Item %s appears more than once (again at index %i)."), *entry.ItemCode.ToString(), i));
+		}
+
+		if (entry.Quantity <= 0)
+		{
+			outViolations.Add(FString::Printf(TEXT("Item %s has non-positive quantity %i."), *entry.ItemCode.ToString(), entry.Quantity));
+		}
+
+		if (sample.bHasLookupCache)
+		{
+			const int32* cachedIndex = sample.LookupCache.Find(entry.ItemCode);
+			if (cachedIndex == nullptr)
+			{
+				outViolations.Add(FString::Printf(TEXT("Item %s at index %i is missing from the lookup cache."), *entry.ItemCode.ToString(), i));
+			}
+			else if (*cachedIndex != i && !bDuplicate)
+			{
+				outViolations.Add(FString::Printf(TEXT("Lookup cache has item %s at index %i, but it is at index %i."), *entry.ItemCode.ToString(), *cachedIndex, i));
+			}
+		}
+
+		if (sample.Snapshot.IsValid() && sample.Snapshot->GetQuantityFor(entry.ItemCode) != entry.Quantity)
+		{
+			outViolations.Add(FString::Printf(TEXT("Snapshot has %i of item %s, the inventory %i."), sample.Snapshot->GetQuantityFor(entry.ItemCode), *entry.ItemCode.ToString(), entry.Quantity));
+		}
+	}
+
+	if (sample.bHasLookupCache)
+	{
+		for (const auto& pair : sample.LookupCache)
+		{
+			if (!sample.Entries.IsValidIndex(pair.Value) || sample.Entries[pair.Value].ItemCode != pair.Key)
+			{
+				outViolations.Add(FString::Printf(TEXT("Lookup cache maps item %s to index %i, which holds something else."), *pair.Key.ToString(), pair.Value));
+			}
+		}
+	}
+
+	if (sample.Snapshot.IsValid() && sample.Snapshot->Num() != seenItems.Num())
+	{
+		outViolations.Add(FString::Printf(TEXT("Snapshot holds %i items, the inventory %i."), sample.Snapshot->Num(), seenItems.Num()));
+	}
+}
+
+int64 FInventoryVerifier::NumVerifiedSamples() const
+{
+	return NumVerified;
+}
+
+int64 FInventoryVerifier::NumViolations() const
+{
+	return NumFound;
+}
@@ -2,14 +2,48 @@
 
 
 #include "RPCBasedInventoryComponent.h"
+#include "TimerManager.h"
+#include "Serialization/BitWriter.h"
+#include "InventoryPersistenceSubsystem.h"
+#include "InventoryTrace.h"
+#include "InventoryRateLimitSubsystem.h"
+#include "InventoryBandwidthSubsystem.h"
+#include "InventorySyncChunk.h"
+#include "InventoryMemory.h"
+#include "InventoryItemRegistry.h"
+#include "InventoryNetSerialization.h"
+#include "InventoryAggregateSubsystem.h"
+
+static constexpr float SyncChunkInterval = 0.1f;
+
+static const FName DeltaSendChannel(TEXT("Deltas"));
+static const FName SyncSendChannel(TEXT("Sync"));
 
 // Sets default values for this component's properties
 URPCBasedInventoryComponent::URPCBasedInventoryComponent()
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
 	// No need to tick.
 	PrimaryComponentTick.bCanEverTick = false;
 
+	bRepairInFlight = false;
+	SyncCursor = 0;
+	SyncId = 0;
+	SyncByteAllowance = 0.0f;
+	bSyncInFlight = false;
+	ActiveSyncId = INDEX_NONE;
+	bSyncFailed = false;
+	SyncChunkEntries = 64;
+	SyncBytesPerSecond = 32768;
+	SendPriority = EInventorySendPriority::Backpack;
+	NextRequestId = 1;
+
 	Inventory = CreateDefaultSubobject<UInventory>(TEXT("Inventory"));
+	Inventory->OnChangesPending.AddUObject(this, &URPCBasedInventoryComponent::OnInventoryChangesPending);
+
+	Counters.Initialize(this,
+		[this](const TArray<FInventoryCounterValue>& values) { QueueCounterValues(values); },
+		[this](const FName itemCode, int64 oldValue, int64 newValue) { OnCounterChanged(itemCode, oldValue, newValue); });
 }
 
 // Called when the game starts
@@ -17,34 +51,251 @@ void URPCBasedInventoryComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
+	// The owning client starts out empty, so it asks for everything the server already holds
+	AActor* owner = GetOwner();
+	if (owner->GetLocalRole() != ROLE_Authority && owner->GetNetConnection() != nullptr)
+	{
+		// Reliable RPCs arrive in order, so the server has matched the item registry before it sends the inventory
+		Server_ReportItemRegistry(FInventoryItemRegistry::Get().BeginNetIndexAgreement(owner->GetNetConnection()));
+		Server_SetClientInventory();
+	}
+
+	if (!PersistenceId.IsEmpty() && GetOwner()->GetLocalRole() == ROLE_Authority)
+	{
+		if (UInventoryPersistenceSubsystem* persistence = UInventoryPersistenceSubsystem::Get(this))
+		{
+			TWeakObjectPtr<URPCBasedInventoryComponent> weakThis = this;
+			persistence->LoadAsync(this, PersistenceId, [weakThis](const FInventoryPersistenceRecord& record)
+			{
+				weakThis->ApplyLoadedRecord(record);
+			});
+		}
+	}
+}
+
+void URPCBasedInventoryComponent::Server_ReportItemRegistry_Implementation(uint32 checksum)
+{
+	FInventoryItemRegistry& registry = FInventoryItemRegistry::Get();
+	if (registry.AcceptNetIndexAgreement(GetOwner()->GetNetConnection(), checksum))
+	{
+		Client_AcceptItemRegistry(checksum);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: client item registry (checksum %08x) differs from the server's (%08x). Item codes will be sent by name."), *GetOwner()->GetName(), checksum, registry.GetNetIndexChecksum());
+	}
+}
+
+void URPCBasedInventoryComponent::Client_AcceptItemRegistry_Implementation(uint32 checksum)
+{
+	FInventoryItemRegistry::Get().ConfirmNetIndexAgreement(GetOwner()->GetNetConnection(), checksum);
+}
+
+void URPCBasedInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (!PersistenceId.IsEmpty())
+	{
+		if (UInventoryPersistenceSubsystem* persistence = UInventoryPersistenceSubsystem::Get(this))
+		{
+			persistence->FlushInventory(this);
+		}
+	}
+
+	Inventory->LeaveAllAggregateViews();
+	CounterAggregates.LeaveAll([this](auto&& removeEntry)
+	{
+		Counters.ForEachValue(removeEntry);
+	});
+	Inventory->ClearAllItemExpiries();
+	CancelPendingRequests();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void URPCBasedInventoryComponent::ApplyLoadedRecord(const FInventoryPersistenceRecord& record)
+{
+	Counters.SetAll(record.Counters);
+
+	// Turn the saved absolute quantities into changes, so the client receives them like any other modification
+	TMap<FName, int32> changes;
+	for (const auto& pair : Inventory->GetEntryMap())
+	{
+		changes.Add(pair.Key, -pair.Value);
+	}
+	for (const FInventoryEntry& entry : record.Entries)
+	{
+		changes.FindOrAdd(entry.ItemCode, 0) += entry.Quantity;
+	}
+
+	TArray<FInventoryEntry> finalChanges;
+	finalChanges.Reserve(changes.Num());
+	for (const auto& pair : changes)
+	{
+		if (pair.Value != 0)
+		{
+			finalChanges.Emplace(pair.Key, pair.Value);
+		}
+	}
+
+	if (finalChanges.Num() > 0)
+	{
+		ApplyServerModification(finalChanges);
+	}
+
+	// Expiries were saved as UTC times, so time the server was down counts towards them
+	Inventory->RestoreItemExpiries(record.Expiries);
+}
 
+void URPCBasedInventoryComponent::OnInventoryChangesPending()
+{
+	ScheduleChangeBroadcast();
+	MarkPersistenceDirty();
+}
+
+void URPCBasedInventoryComponent::MarkPersistenceDirty()
+{
+	if (!PersistenceId.IsEmpty() && GetOwner() && GetOwner()->GetLocalRole() == ROLE_Authority)
+	{
+		if (UInventoryPersistenceSubsystem* persistence = UInventoryPersistenceSubsystem::Get(this))
+		{
+			persistence->MarkDirty(this, PersistenceId);
+		}
+	}
 }
 
-void URPCBasedInventoryComponent::Server_ConfirmClientModification_Implementation(EChangeGroupStatus serverStatus)
+void URPCBasedInventoryComponent::Server_ConfirmClientModification_Implementation(EChangeGroupStatus serverStatus, uint64 clientHash)
 {
 	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
 
 	UE_LOG(LogTemp, Log, TEXT("Server confirming client changes..."));
-	if (serverStatus != EChangeGroupStatus::AllSuccessful)
+
+	FExpectedClientHash expected;
+	if (!ExpectedClientHashes.Dequeue(expected))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Client could not match changes; needs correction. Client status: %s"), *UEnum::GetValueAsString(serverStatus));
-		UE_LOG(LogTemp, Log, TEXT("Setting client to server inventory..."));
-		Server_SetClientInventory();
+		UE_LOG(LogTemp, Warning, TEXT("Received a confirmation that was not expected. Ignoring..."));
+		return;
+	}
+
+	if (!expected.bVerify)
+	{
+		return;
+	}
+
+	if (serverStatus != EChangeGroupStatus::AllSuccessful || clientHash != expected.Hash)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Client could not match changes; needs correction. Client status: %s, hash %llx, expected %llx"), *UEnum::GetValueAsString(serverStatus), clientHash, expected.Hash);
+		StartBucketRepair();
 		return;
 	}
 
 	UE_LOG(LogTemp, Log, TEXT("Server changes confirmed."));
 }
 
-void URPCBasedInventoryComponent::Client_ModifyInventory_Implementation(const TArray<FInventoryEntry>& inventoryChanges)
+bool URPCBasedInventoryComponent::HasRemoteClient() const
+{
+	// Without an owning connection the client RPCs run locally (or nowhere) and are never confirmed
+	const AActor* owner = GetOwner();
+	return owner != nullptr && owner->GetLocalRole() == ROLE_Authority && owner->GetNetConnection() != nullptr;
+}
+
+void URPCBasedInventoryComponent::ExpectClientHash()
+{
+	if (HasRemoteClient())
+	{
+		FExpectedClientHash expected;
+		expected.Hash = Inventory->GetStateHash().GetHash();
+		expected.bVerify = !bSyncInFlight;
+		ExpectedClientHashes.Enqueue(expected);
+	}
+}
+
+void URPCBasedInventoryComponent::StartBucketRepair()
+{
+	// Confirmations already in flight will disagree as well; one repair (or the running full sync) covers them all
+	if (bRepairInFlight || bSyncInFlight)
+	{
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Comparing bucket hashes with client..."));
+	bRepairInFlight = true;
+
+	// The client compares against everything the server has changed so far
+	SendQueuedDeltas();
+
+	TArray<uint64> bucketHashes;
+	Inventory->GetStateHash().GetBucketHashes(bucketHashes);
+	Client_CompareBucketHashes(bucketHashes);
+}
+
+void URPCBasedInventoryComponent::Client_CompareBucketHashes_Implementation(const TArray<uint64>& serverBucketHashes)
+{
+	// Every change the server made before sending these hashes has already been applied here
+	const uint32 bucketMask = Inventory->GetStateHash().GetDifferingBuckets(serverBucketHashes);
+	Server_RequestBuckets(bucketMask);
+}
+
+void URPCBasedInventoryComponent::Server_RequestBuckets_Implementation(uint32 bucketMask)
+{
+	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
+	if (!bRepairInFlight)
+	{
+		return;
+	}
+
+	TArray<FInventoryEntry> bucketEntries;
+	Inventory->GetEntriesInBuckets(bucketMask, bucketEntries);
+
+	UE_LOG(LogTemp, Log, TEXT("Sending %i entries to repair diverged buckets %x."), bucketEntries.Num(), bucketMask);
+	SendQueuedDeltas();  // Otherwise they would be applied on top of the repaired quantities
+	ExpectClientHash();
+	Client_ReplaceBuckets(bucketMask, bucketEntries);
+}
+
+void URPCBasedInventoryComponent::Client_ReplaceBuckets_Implementation(uint32 bucketMask, const FInventoryEntryBatch& bucketEntries)
+{
+	Inventory->ReplaceBuckets(bucketMask, bucketEntries.Entries);
+	Server_ConfirmBucketRepair(Inventory->GetStateHash().GetHash());
+}
+
+void URPCBasedInventoryComponent::Server_ConfirmBucketRepair_Implementation(uint64 clientHash)
+{
+	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
+
+	FExpectedClientHash expected;
+	if (!ExpectedClientHashes.Dequeue(expected))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Received a repair confirmation that was not expected. Ignoring..."));
+		return;
+	}
+
+	bRepairInFlight = false;
+
+	if (expected.bVerify && clientHash != expected.Hash)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Client still diverged after bucket repair. Setting client to server inventory..."));
+		Server_SetClientInventory();
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Client repaired."));
+}
+
+void URPCBasedInventoryComponent::Client_ModifyInventory_Implementation(const FInventoryEntryBatch& inventoryBatch)
 {
+	const TArray<FInventoryEntry>& inventoryChanges = inventoryBatch.Entries;
+
 	if (GetOwner()->GetLocalRole() == ROLE_Authority)
 	{
 		UE_LOG(LogTemp, Log, TEXT("Cannot run inventory modifications intended for client on server. Cancelling..."));
 		return;
 	}
 
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::ClientModify, inventoryChanges);
+	}
+
 	checkCode(
 		for (const FInventoryEntry& entry : inventoryChanges)
 		{
@@ -57,12 +308,77 @@ void URPCBasedInventoryComponent::Client_ModifyInventory_Implementation(const TA
 
 	TTuple<EChangeGroupStatus, TArray<EChangeStatus>> pair = Inventory->ModifyGroupOfEntries(inventoryChanges);
 
-	Server_ConfirmClientModification(pair.Key);
+	Server_ConfirmClientModification(pair.Key, Inventory->GetStateHash().GetHash());
+}
+
+void URPCBasedInventoryComponent::Server_ModifyInventory_Implementation(const FInventoryEntryBatch& inventoryBatch)
+{
+	AdmitClientModification(0, inventoryBatch);
+}
+
+void URPCBasedInventoryComponent::Server_ModifyInventoryRequest_Implementation(int32 requestId, const FInventoryEntryBatch& inventoryBatch)
+{
+	AdmitClientModification(requestId, inventoryBatch);
 }
 
-void URPCBasedInventoryComponent::Server_ModifyInventory_Implementation(const TArray<FInventoryEntry>& inventoryChanges)
+void URPCBasedInventoryComponent::AdmitClientModification(int32 requestId, const FInventoryEntryBatch& inventoryBatch)
 {
 	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
+
+	UInventoryRateLimitSubsystem* rateLimiter = UInventoryRateLimitSubsystem::Get(this);
+	if (rateLimiter == nullptr)
+	{
+		ApplyClientModification(requestId, inventoryBatch);
+		return;
+	}
+
+	TWeakObjectPtr<URPCBasedInventoryComponent> weakThis = this;
+	const EInventoryRequestAdmission admission = rateLimiter->Submit(GetOwner()->GetNetConnection(), inventoryBatch.Entries.Num(), [weakThis, requestId, inventoryBatch]()
+	{
+		if (weakThis.IsValid())
+		{
+			weakThis->ApplyClientModification(requestId, inventoryBatch);
+		}
+	});
+
+	if (admission == EInventoryRequestAdmission::Dropped)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Client inventory request of %i entries dropped by rate limiting."), inventoryBatch.Entries.Num());
+		if (requestId != 0)
+		{
+			FInventoryRequestResult result;
+			result.RequestId = requestId;
+			result.Outcome = EInventoryRequestOutcome::Rejected;
+			result.GroupStatus = EChangeGroupStatus::SomeChangesLost;
+			CompleteRequest(result);
+		}
+	}
+}
+
+void URPCBasedInventoryComponent::ApplyClientModification(int32 requestId, const FInventoryEntryBatch& inventoryBatch)
+{
+	// Recorded once admitted, so a replayed trace only holds the requests the server actually applied
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::ServerModify, inventoryBatch.Entries);
+	}
+
+	TArray<FName> changedCounters;
+	TTuple<EChangeGroupStatus, TArray<EChangeStatus>> statuses = ApplyServerModification(inventoryBatch, &changedCounters);
+	if (requestId != 0)
+	{
+		FInventoryRequestResult result;
+		result.RequestId = requestId;
+		result.GroupStatus = statuses.Key;
+		result.EntryStatuses = MoveTemp(statuses.Value);
+		CompleteRequest(result, changedCounters);
+	}
+}
+
+TTuple<EChangeGroupStatus, TArray<EChangeStatus>> URPCBasedInventoryComponent::ApplyServerModification(const FInventoryEntryBatch& inventoryBatch, TArray<FName>* outChangedCounters)
+{
+	const TArray<FInventoryEntry>& inventoryChanges = inventoryBatch.Entries;
+
 	checkCode(
 		for (const FInventoryEntry& entry : inventoryChanges)
 		{
@@ -73,6 +389,55 @@ void URPCBasedInventoryComponent::Server_ModifyInventory_Implementation(const TA
 		}
 	);
 
+	// Counter items are accumulated and sent on their own schedule instead of with the batch
+	const FInventoryItemRegistry& registry = FInventoryItemRegistry::Get();
+	const auto isCounter = [&registry](const FInventoryEntry& entry) { return registry.GetCounterPolicy(entry.ItemCode) != nullptr; };
+	if (inventoryChanges.ContainsByPredicate(isCounter))
+	{
+		FInventoryEntryBatch itemBatch;
+		for (const FInventoryEntry& entry : inventoryChanges)
+		{
+			if (isCounter(entry))
+			{
+				Counters.Add(entry.ItemCode, entry.Quantity);
+				if (outChangedCounters != nullptr)
+				{
+					outChangedCounters->AddUnique(entry.ItemCode);
+				}
+			}
+			else
+			{
+				itemBatch.Entries.Add(entry);
+			}
+		}
+
+		const TTuple<EChangeGroupStatus, TArray<EChangeStatus>> itemStatuses = itemBatch.Entries.Num() > 0
+			? ApplyServerModification(itemBatch)
+			: MakeTuple(EChangeGroupStatus::AllSuccessful, TArray<EChangeStatus>());
+
+		// Counter changes always apply
+		TTuple<EChangeGroupStatus, TArray<EChangeStatus>> statuses(itemStatuses.Key, TArray<EChangeStatus>());
+		statuses.Value.Reserve(inventoryChanges.Num());
+		int32 itemIndex = 0;
+		for (const FInventoryEntry& entry : inventoryChanges)
+		{
+			statuses.Value.Add(isCounter(entry) ? EChangeStatus::Success : itemStatuses.Value[itemIndex++]);
+		}
+		return statuses;
+	}
+
+	const bool bRemoteClient = HasRemoteClient();
+	if (bRemoteClient)
+	{
+		for (const FInventoryEntry& entry : inventoryChanges)
+		{
+			if (!UnsentDeltaBases.Contains(entry.ItemCode))
+			{
+				UnsentDeltaBases.Add(entry.ItemCode, Inventory->GetQuantityFor(entry.ItemCode));
+			}
+		}
+	}
+
 	TTuple<EChangeGroupStatus, TArray<EChangeStatus>> pair = Inventory->ModifyGroupOfEntries(inventoryChanges);
 
 	if (pair.Key != EChangeGroupStatus::AllSuccessful)
@@ -80,89 +445,829 @@ void URPCBasedInventoryComponent::Server_ModifyInventory_Implementation(const TA
 		UE_LOG(LogTemp, Warning, TEXT("Not all inventory changes successful. Some lost."));
 	}
 
-	Client_ModifyInventory(inventoryChanges);
-}
+	if (!bRemoteClient)
+	{
+		ExpectClientHash();
+		Client_ModifyInventory(inventoryBatch);
+		return pair;
+	}
 
-UInventory* URPCBasedInventoryComponent::GetInventory()
-{
-	return Inventory;
+	ScheduleDeltaSend();
+	return pair;
 }
 
-FString URPCBasedInventoryComponent::ToString() const
+void URPCBasedInventoryComponent::ScheduleDeltaSend()
 {
-	return Inventory->ToString();
+	// Changes made while a send is still queued go out with it as one net change per item
+	UInventoryBandwidthSubsystem* bandwidth = UInventoryBandwidthSubsystem::Get(this);
+	TWeakObjectPtr<URPCBasedInventoryComponent> weakThis = this;
+	if (bandwidth == nullptr || !bandwidth->Enqueue(GetOwner()->GetNetConnection(), this, DeltaSendChannel, SendPriority, [weakThis]()
+	{
+		return weakThis.IsValid() ? weakThis->SendQueuedDeltas() : 0;
+	}))
+	{
+		SendQueuedDeltas();
+	}
 }
 
-int32 URPCBasedInventoryComponent::Num() const
+void URPCBasedInventoryComponent::QueueCounterValues(const TArray<FInventoryCounterValue>& values)
 {
-	return Inventory->Num();
-}
+	// Answers waiting for these values can follow them
+	for (const FInventoryCounterValue& value : values)
+	{
+		AwaitedCounters.Remove(value.ItemCode);
+	}
 
-bool URPCBasedInventoryComponent::Contains(const FName itemCode) const
-{
-	return Inventory->Contains(itemCode);
-}
+	if (!HasRemoteClient())
+	{
+		return;
+	}
 
-void URPCBasedInventoryComponent::ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges)
-{
-	Server_ModifyInventory(inventoryChanges);
+	for (const FInventoryCounterValue& value : values)
+	{
+		UnsentCounterValues.Add(value.ItemCode, value.Value);
+	}
+	ScheduleDeltaSend();
 }
 
-void URPCBasedInventoryComponent::AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges)
+int32 URPCBasedInventoryComponent::SendQueuedDeltas()
 {
-	checkCode(
-		for (const FInventoryEntry& entry : inventoryChanges)
+	FInventoryEntryBatch batch;
+	batch.Entries.Reserve(UnsentDeltaBases.Num());
+	for (const auto& pair : UnsentDeltaBases)
+	{
+		const int32 delta = Inventory->GetQuantityFor(pair.Key) - pair.Value;
+		if (delta != 0)
 		{
-			if (entry.Quantity <= 0)
-			{
-				UE_LOG(LogTemp, Warning, TEXT("Adding non-positive quantity of item %s. Quantity to add: %i"), *entry.ItemCode.ToString(), entry.Quantity);
-			}
+			batch.Entries.Emplace(pair.Key, delta);
 		}
-	);
-	Server_ModifyInventory(inventoryChanges);
+	}
+	UnsentDeltaBases.Reset();
+
+	int32 bytesSent = 0;
+	if (batch.Entries.Num() > 0)
+	{
+		// Measured with the same encoding the RPC uses
+		FBitWriter writer(0, true);
+		bool bSuccess = true;
+		batch.NetSerialize(writer, nullptr, bSuccess);
+
+		ExpectClientHash();
+		Client_ModifyInventory(batch);
+		bytesSent = (int32)writer.GetNumBytes();
+	}
+
+	if (UnsentCounterValues.Num() > 0)
+	{
+		TArray<FInventoryCounterValue> values;
+		values.Reserve(UnsentCounterValues.Num());
+		FBitWriter writer(0, true);
+		for (const auto& pair : UnsentCounterValues)
+		{
+			FName itemCode = pair.Key;
+			int64 value = pair.Value;
+			InventoryNetSerialization::SerializeItemCode(writer, itemCode, nullptr);
+			writer << value;
+			values.Emplace(pair.Key, pair.Value);
+		}
+		UnsentCounterValues.Reset();
+
+		SendCounterValues(values);
+		bytesSent += (int32)writer.GetNumBytes();
+	}
+
+	if (UnsentResults.Num() > 0 && AwaitedCounters.Num() == 0)
+	{
+		SendAnswers(UnsentResults);
+		UnsentResults.Reset();
+	}
+	return bytesSent;
 }
 
-void URPCBasedInventoryComponent::RemoveItemsFromInventory(const TArray<FInventoryEntry>& inventoryChanges)
+void URPCBasedInventoryComponent::CompleteRequest(const FInventoryRequestResult& result, const TArray<FName>& changedCounters)
 {
-	TArray<FInventoryEntry> finalChanges;
-	finalChanges.Reserve(inventoryChanges.Num());
-	for (const FInventoryEntry& entry : inventoryChanges)
+	// A request only resolves once the client holds its changes, so answers wait for any deltas still queued and for
+	// the counters the request changed. Those that are due go out now rather than next tick; the rest keep their rate.
+	if (changedCounters.Num() > 0 && HasRemoteClient())
 	{
-		checkCode(
-			if (entry.Quantity <= 0)
+		Counters.Flush();
+		for (const FName itemCode : changedCounters)
+		{
+			if (Counters.IsDirty(itemCode))
 			{
-				UE_LOG(LogTemp, Warning, TEXT("Removing non-positive quantity of item %s. Quantity to remove: %i"), *entry.ItemCode.ToString(), entry.Quantity);
+				AwaitedCounters.Add(itemCode);
 			}
-		);
-		FInventoryEntry newEntry;
-		newEntry.ItemCode = entry.ItemCode;
-		newEntry.Quantity = -entry.Quantity;
-		finalChanges.Add(newEntry);  // Flip so it is removed rather than added
+		}
+	}
+
+	if (UnsentDeltaBases.Num() > 0 || UnsentCounterValues.Num() > 0 || AwaitedCounters.Num() > 0 || UnsentResults.Num() > 0)
+	{
+		UnsentResults.Add(result);
+		return;
 	}
 
-	Server_ModifyInventory(finalChanges);
+	SendAnswers({ result });
 }
 
-void URPCBasedInventoryComponent::Server_SetClientInventory_Implementation()
+void URPCBasedInventoryComponent::Client_CompleteRequests_Implementation(const TArray<FInventoryRequestResult>& results)
 {
-	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
-	Client_SetInventory(GetInventory());
+	for (const FInventoryRequestResult& result : results)
+	{
+		TPromise<FInventoryRequestResult>* found = PendingRequests.Find(result.RequestId);
+		if (found == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Received an answer to unknown inventory request %i. Ignoring..."), result.RequestId);
+			continue;
+		}
+
+		// Continuations run inside SetValue and may make new requests, so the promise leaves the map first
+		TPromise<FInventoryRequestResult> promise = MoveTemp(*found);
+		PendingRequests.Remove(result.RequestId);
+		promise.SetValue(result);
+	}
 }
 
-void URPCBasedInventoryComponent::Client_SetInventory_Implementation(const UInventory* inventoryPtr)
+void URPCBasedInventoryComponent::CancelPendingRequests()
 {
-	ensure(GetOwner()->GetLocalRole() != ROLE_Authority);
-	Inventory = DuplicateObject<UInventory>(inventoryPtr, this, TEXT("Inventory"));
-	Server_ConfirmClientSetInventory(ESetStatus::Success);
+	TMap<int32, TPromise<FInventoryRequestResult>> cancelled = MoveTemp(PendingRequests);
+	PendingRequests.Reset();
+	for (auto& pair : cancelled)
+	{
+		FInventoryRequestResult result;
+		result.RequestId = pair.Key;
+		result.Outcome = EInventoryRequestOutcome::Cancelled;
+		result.GroupStatus = EChangeGroupStatus::SomeChangesLost;
+		pair.Value.SetValue(result);
+	}
 }
 
-void URPCBasedInventoryComponent::Server_ConfirmClientSetInventory_Implementation(ESetStatus serverStatus)
+TFuture<FInventoryRequestResult> URPCBasedInventoryComponent::ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges)
 {
-	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
-	if (serverStatus != ESetStatus::Success)
+	if (FInventoryTraceRecorder::IsRecording())
 	{
-		UE_LOG(LogTemp, Error, TEXT("Client could not set inventory; needs correction. Client status: %s"), *UEnum::GetValueAsString<ESetStatus>(serverStatus));
-		UE_LOG(LogTemp, Log, TEXT("Attempting to set client to server inventory..."));
-		Server_SetClientInventory();
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Modify, inventoryChanges);
+	}
+
+	if (GetOwner() == nullptr || GetOwner()->GetLocalRole() == ROLE_Authority)
+	{
+		return MakeCompletedRequest(EInventoryRequestOutcome::Committed, ApplyServerModification(inventoryChanges));
+	}
+
+	// Sent straight away even while earlier requests are unanswered; the server applies them in order
+	const int32 requestId = NextRequestId++;
+	TFuture<FInventoryRequestResult> future = PendingRequests.Add(requestId).GetFuture();
+	SendRequest(requestId, inventoryChanges);
+	return future;
+}
+
+void URPCBasedInventoryComponent::SendRequest(int32 requestId, const FInventoryEntryBatch& inventoryBatch)
+{
+	Server_ModifyInventoryRequest(requestId, inventoryBatch);
+}
+
+void URPCBasedInventoryComponent::SendAnswers(const TArray<FInventoryRequestResult>& results)
+{
+	Client_CompleteRequests(results);
+}
+
+void URPCBasedInventoryComponent::SendCounterValues(const TArray<FInventoryCounterValue>& counterValues)
+{
+	Client_UpdateCounters(counterValues);
+}
+
+UInventory* URPCBasedInventoryComponent::GetInventory()
+{
+	return Inventory;
+}
+
+FString URPCBasedInventoryComponent::ToString() const
+{
+	return Inventory->ToString();
+}
+
+void URPCBasedInventoryComponent::GetEntries(TArray<FInventoryEntry>& outEntries) const
+{
+	const TMap<FName, int32>& entries = Inventory->GetEntryMap();
+	outEntries.Reset(entries.Num());
+	for (const auto& pair : entries)
+	{
+		outEntries.Emplace(pair.Key, pair.Value);
+	}
+}
+
+int32 URPCBasedInventoryComponent::GetQuantityFor(const FName itemCode) const
+{
+	if (FInventoryItemRegistry::Get().GetCounterPolicy(itemCode) != nullptr)
+	{
+		return (int32)FMath::Min<int64>(Counters.GetValue(itemCode), MAX_int32);
+	}
+	return Inventory->GetQuantityFor(itemCode);
+}
+
+int32 URPCBasedInventoryComponent::Num() const
+{
+	return Inventory->Num();
+}
+
+bool URPCBasedInventoryComponent::Contains(const FName itemCode) const
+{
+	return Inventory->Contains(itemCode);
+}
+
+int32 URPCBasedInventoryComponent::CountItemsWithTag(const FName tag) const
+{
+	return Inventory->CountItemsWithTag(tag);
+}
+
+int64 URPCBasedInventoryComponent::GetQuantityForTag(const FName tag) const
+{
+	return Inventory->GetQuantityForTag(tag);
+}
+
+const TSet<FName>* URPCBasedInventoryComponent::GetItemsWithTag(const FName tag) const
+{
+	return Inventory->GetItemsWithTag(tag);
+}
+
+void URPCBasedInventoryComponent::EnableSnapshots()
+{
+	Inventory->EnableSnapshots();
+}
+
+FInventorySnapshotPtr URPCBasedInventoryComponent::GetSnapshot() const
+{
+	return Inventory->GetSnapshot();
+}
+
+bool URPCBasedInventoryComponent::JoinAggregateView(const FName view)
+{
+	if (!Inventory->JoinAggregateView(view))
+	{
+		return false;
+	}
+
+	// Counter items live here rather than in the inventory, so they join the view on their own
+	if (UInventoryAggregateSubsystem* aggregates = UInventoryAggregateSubsystem::Get(this))
+	{
+		CounterAggregates.Join(aggregates->GetViews(), view, [this](auto&& addEntry)
+		{
+			Counters.ForEachValue(addEntry);
+		});
+	}
+	return true;
+}
+
+bool URPCBasedInventoryComponent::LeaveAggregateView(const FName view)
+{
+	CounterAggregates.Leave(view, [this](auto&& removeEntry)
+	{
+		Counters.ForEachValue(removeEntry);
+	});
+	return Inventory->LeaveAggregateView(view);
+}
+
+bool URPCBasedInventoryComponent::SetItemExpiry(const FName itemCode, float lifetimeSeconds)
+{
+	if (GetOwner() && GetOwner()->GetLocalRole() != ROLE_Authority)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Expiry can only be set on the server. Ignoring expiry of item %s."), *itemCode.ToString());
+		return false;
+	}
+
+	if (!Inventory->SetItemExpiry(itemCode, lifetimeSeconds))
+	{
+		return false;
+	}
+
+	MarkPersistenceDirty();
+	return true;
+}
+
+bool URPCBasedInventoryComponent::ClearItemExpiry(const FName itemCode)
+{
+	if (!Inventory->ClearItemExpiry(itemCode))
+	{
+		return false;
+	}
+
+	MarkPersistenceDirty();
+	return true;
+}
+
+void URPCBasedInventoryComponent::GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const
+{
+	Inventory->GetItemExpiries(outExpiries);
+}
+
+float URPCBasedInventoryComponent::GetItemLifetimeRemaining(const FName itemCode) const
+{
+	return Inventory->GetItemLifetimeRemaining(itemCode);
+}
+
+void URPCBasedInventoryComponent::EnableSortedView(EInventorySortOrder order)
+{
+	Inventory->EnableSortedView(order);
+}
+
+void URPCBasedInventoryComponent::DisableSortedView(EInventorySortOrder order)
+{
+	Inventory->DisableSortedView(order);
+}
+
+TArray<FInventoryEntry> URPCBasedInventoryComponent::GetSortedPage(EInventorySortOrder order, int32 pageIndex, int32 pageSize) const
+{
+	return Inventory->GetSortedPage(order, pageIndex, pageSize);
+}
+
+int32 URPCBasedInventoryComponent::GetSortedRank(EInventorySortOrder order, const FName itemCode) const
+{
+	return Inventory->GetSortedRank(order, itemCode);
+}
+
+bool URPCBasedInventoryComponent::AddToCounter(const FName itemCode, int64 delta)
+{
+	return Counters.Add(itemCode, delta);
+}
+
+bool URPCBasedInventoryComponent::SetCounter(const FName itemCode, int64 value)
+{
+	return Counters.Set(itemCode, value);
+}
+
+int64 URPCBasedInventoryComponent::GetCounterValue(const FName itemCode) const
+{
+	return Counters.GetValue(itemCode);
+}
+
+int64 URPCBasedInventoryComponent::GetDisplayedCounterValue(const FName itemCode) const
+{
+	return (int64)FMath::RoundToDouble(Counters.GetDisplayValue(itemCode));
+}
+
+void URPCBasedInventoryComponent::GetCounterValues(TArray<FInventoryCounterValue>& outValues) const
+{
+	Counters.GetValues(outValues);
+}
+
+void URPCBasedInventoryComponent::OnCounterChanged(const FName itemCode, int64 oldValue, int64 newValue)
+{
+	CounterAggregates.OnQuantityChanged(itemCode, oldValue, newValue);
+	MarkPersistenceDirty();
+}
+
+void URPCBasedInventoryComponent::Client_UpdateCounters_Implementation(const TArray<FInventoryCounterValue>& counterValues)
+{
+	Counters.ApplyReplicated(counterValues);
+}
+
+FInventoryMemoryUsage URPCBasedInventoryComponent::GetMemoryUsage() const
+{
+	FInventoryMemoryUsage usage = Inventory->GetMemoryUsage();
+
+	// Sync bookkeeping only lives for the duration of a sync and counters are small, so all of it counts as used
+	const SIZE_T syncBytes = SyncQueue.GetAllocatedSize() + SyncQueuedItems.GetAllocatedSize() + ReceivedSyncItems.GetAllocatedSize() + Counters.GetAllocatedSize()
+		+ UnsentDeltaBases.GetAllocatedSize() + UnsentCounterValues.GetAllocatedSize() + AwaitedCounters.GetAllocatedSize();
+	usage.AllocatedBytes += syncBytes;
+	usage.UsedBytes += syncBytes;
+	return usage;
+}
+
+void URPCBasedInventoryComponent::Shrink()
+{
+	Inventory->Shrink();
+}
+
+void URPCBasedInventoryComponent::SubmitModification(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (GetOwner() == nullptr || GetOwner()->GetLocalRole() == ROLE_Authority)
+	{
+		ApplyServerModification(inventoryChanges);
+	}
+	else
+	{
+		Server_ModifyInventory(inventoryChanges);
+	}
+}
+
+void URPCBasedInventoryComponent::ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Modify, inventoryChanges);
+	}
+
+	SubmitModification(inventoryChanges);
+}
+
+void URPCBasedInventoryComponent::AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Add, inventoryChanges);
+	}
+
+	checkCode(
+		for (const FInventoryEntry& entry : inventoryChanges)
+		{
+			if (entry.Quantity <= 0)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Adding non-positive quantity of item %s. Quantity to add: %i"), *entry.ItemCode.ToString(), entry.Quantity);
+			}
+		}
+	);
+	SubmitModification(inventoryChanges);
+}
+
+void URPCBasedInventoryComponent::RemoveItemsFromInventory(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Remove, inventoryChanges);
+	}
+
+	TArray<FInventoryEntry> finalChanges;
+	finalChanges.Reserve(inventoryChanges.Num());
+	for (const FInventoryEntry& entry : inventoryChanges)
+	{
+		checkCode(
+			if (entry.Quantity <= 0)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Removing non-positive quantity of item %s. Quantity to remove: %i"), *entry.ItemCode.ToString(), entry.Quantity);
+			}
+		);
+		FInventoryEntry newEntry;
+		newEntry.ItemCode = entry.ItemCode;
+		newEntry.Quantity = -entry.Quantity;
+		finalChanges.Add(newEntry);  // Flip so it is removed rather than added
+	}
+
+	SubmitModification(finalChanges);
+}
+
+void URPCBasedInventoryComponent::Server_SetClientInventory_Implementation()
+{
+	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
+	StartInventorySync();
+
+	Counters.MarkAllDirty();
+}
+
+void URPCBasedInventoryComponent::StartInventorySync()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	// A sync already streaming ends with the complete current state anyway
+	if (bSyncInFlight || !HasRemoteClient())
+	{
+		return;
+	}
+
+	bSyncInFlight = true;
+	SyncId++;
+	SyncCursor = 0;
+	SyncByteAllowance = 0.0f;
+
+	// Priority items first, in tag order, then everything else
+	SyncQueue.Reset(Inventory->Num());
+	SyncQueuedItems.Reset();
+	for (const FName& tag : PrioritySyncTags)
+	{
+		if (const TSet<FName>* taggedItems = Inventory->GetItemsWithTag(tag))
+		{
+			for (const FName& itemCode : *taggedItems)
+			{
+				bool bAlreadyQueued = false;
+				SyncQueuedItems.Add(itemCode, &bAlreadyQueued);
+				if (!bAlreadyQueued)
+				{
+					SyncQueue.Add(itemCode);
+				}
+			}
+		}
+	}
+	for (const auto& pair : Inventory->GetEntryMap())
+	{
+		bool bAlreadyQueued = false;
+		SyncQueuedItems.Add(pair.Key, &bAlreadyQueued);
+		if (!bAlreadyQueued)
+		{
+			SyncQueue.Add(pair.Key);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Streaming %i entries to client in chunks of %i..."), SyncQueue.Num(), SyncChunkEntries);
+	Client_BeginInventorySync(SyncId);
+	SendInventorySyncChunks();
+
+	if (bSyncInFlight)
+	{
+		GetWorld()->GetTimerManager().SetTimer(SyncTimerHandle, this, &URPCBasedInventoryComponent::SendInventorySyncChunks, SyncChunkInterval, true);
+	}
+}
+
+void URPCBasedInventoryComponent::SendInventorySyncChunks()
+{
+	// Unused allowance carries over, but never more than a second's worth, so a stall cannot turn into a burst
+	SyncByteAllowance = FMath::Min(SyncByteAllowance + SyncBytesPerSecond * SyncChunkInterval, (float)SyncBytesPerSecond);
+
+	// Waits behind every other inventory change queued for this client
+	UInventoryBandwidthSubsystem* bandwidth = UInventoryBandwidthSubsystem::Get(this);
+	TWeakObjectPtr<URPCBasedInventoryComponent> weakThis = this;
+	if (bandwidth == nullptr || !bandwidth->Enqueue(GetOwner()->GetNetConnection(), this, SyncSendChannel, EInventorySendPriority::Other, [weakThis]()
+	{
+		return weakThis.IsValid() ? weakThis->SendInventorySyncChunksNow() : 0;
+	}))
+	{
+		SendInventorySyncChunksNow();
+	}
+}
+
+int32 URPCBasedInventoryComponent::SendInventorySyncChunksNow()
+{
+	if (!bSyncInFlight)
+	{
+		return 0;
+	}
+
+	const float allowanceBefore = SyncByteAllowance;
+
+	TArray<FInventoryEntry> chunkEntries;
+	bool bItemsLeft = true;
+	do
+	{
+		// Quantities are read at send time, so every change made before this point is already included
+		chunkEntries.Reset(SyncChunkEntries);
+		for (; SyncCursor < SyncQueue.Num() && chunkEntries.Num() < SyncChunkEntries; SyncCursor++)
+		{
+			chunkEntries.Emplace(SyncQueue[SyncCursor], Inventory->GetQuantityFor(SyncQueue[SyncCursor]));
+		}
+
+		if (chunkEntries.Num() > 0)
+		{
+			SendInventorySyncChunk(chunkEntries);
+		}
+
+		bItemsLeft = QueueItemsAddedDuringSync();
+	}
+	while (bItemsLeft && SyncByteAllowance > 0.0f);
+
+	if (bItemsLeft)
+	{
+		return FMath::Max(0, (int32)(allowanceBefore - SyncByteAllowance));
+	}
+
+	// Items changed after their chunk went out; still unverified, like everything else sent during the sync
+	SendQueuedDeltas();
+
+	GetWorld()->GetTimerManager().ClearTimer(SyncTimerHandle);
+	SyncQueue.Empty();
+	SyncQueuedItems.Empty();
+	bSyncInFlight = false;
+
+	Client_EndInventorySync(SyncId);
+	ExpectClientHash();
+	return FMath::Max(0, (int32)(allowanceBefore - SyncByteAllowance));
+}
+
+bool URPCBasedInventoryComponent::QueueItemsAddedDuringSync()
+{
+	if (SyncCursor < SyncQueue.Num())
+	{
+		return true;
+	}
+
+	// Items added while streaming were never queued; they follow under the same budget instead of in one burst
+	for (const auto& pair : Inventory->GetEntryMap())
+	{
+		bool bAlreadyQueued = false;
+		SyncQueuedItems.Add(pair.Key, &bAlreadyQueued);
+		if (!bAlreadyQueued)
+		{
+			SyncQueue.Add(pair.Key);
+		}
+	}
+	return SyncCursor < SyncQueue.Num();
+}
+
+void URPCBasedInventoryComponent::SendInventorySyncChunk(const TArray<FInventoryEntry>& entries)
+{
+	// Late joiners and resynced clients get the complete instance data of every streamed entry that has any
+	const FInventoryInstanceStore& store = Inventory->GetInstanceStore();
+	TArray<FInventoryInstanceRecord> instances;
+	if (store.Num() > 0)
+	{
+		for (const FInventoryEntry& entry : entries)
+		{
+			if (const FInventoryInstanceData* data = store.Find(entry.ItemCode))
+			{
+				instances.Emplace(entry.ItemCode, *data);
+			}
+		}
+	}
+
+	TArray<uint8> compressedEntries;
+	int32 uncompressedSize = 0;
+	if (!InventorySyncChunk::Encode(entries, instances, compressedEntries, uncompressedSize))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not compress inventory sync chunk of %i entries."), entries.Num());
+		return;
+	}
+
+	// The chunk carries current quantities, so queued changes to these items are already covered
+	for (const FInventoryEntry& entry : entries)
+	{
+		UnsentDeltaBases.Remove(entry.ItemCode);
+	}
+
+	SyncByteAllowance -= compressedEntries.Num();
+	Client_ReceiveInventorySyncChunk(SyncId, uncompressedSize, compressedEntries);
+}
+
+void URPCBasedInventoryComponent::Client_BeginInventorySync_Implementation(int32 syncId)
+{
+	ActiveSyncId = syncId;
+	bSyncFailed = false;
+	ReceivedSyncItems.Reset();
+}
+
+void URPCBasedInventoryComponent::Client_ReceiveInventorySyncChunk_Implementation(int32 syncId, int32 uncompressedSize, const TArray<uint8>& compressedEntries)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (syncId != ActiveSyncId)
+	{
+		return;
+	}
+
+	TArray<FInventoryEntry> entries;
+	TArray<FInventoryInstanceRecord> instances;
+	if (!InventorySyncChunk::Decode(compressedEntries, uncompressedSize, entries, instances))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Received a corrupt inventory sync chunk."));
+		bSyncFailed = true;
+		return;
+	}
+
+	// Applied right away, so received entries can be queried before the sync completes
+	for (const FInventoryEntry& entry : entries)
+	{
+		ReceivedSyncItems.Add(entry.ItemCode);
+	}
+	Inventory->SetQuantities(entries);
+
+	// The chunk holds the whole instance data of its entries: anything it leaves out is no longer set on the server
+	FInventoryInstanceStore& store = Inventory->GetInstanceStore();
+	for (const FInventoryEntry& entry : entries)
+	{
+		store.Release(entry.ItemCode);
+	}
+
+	FInventoryInstanceDataDelta delta;
+	delta.ChangedFields = (1 << FInventoryInstanceData::NumFields) - 1;
+	for (const FInventoryInstanceRecord& instance : instances)
+	{
+		if (Inventory->Contains(instance.ItemCode))
+		{
+			delta.ItemCode = instance.ItemCode;
+			delta.Values = instance.Data;
+			store.ApplyDelta(delta);
+		}
+	}
+}
+
+void URPCBasedInventoryComponent::Client_EndInventorySync_Implementation(int32 syncId)
+{
+	if (syncId != ActiveSyncId)
+	{
+		return;
+	}
+
+	// Anything not streamed is no longer held by the server
+	TArray<FName> staleItems;
+	for (const auto& pair : Inventory->GetEntryMap())
+	{
+		if (!ReceivedSyncItems.Contains(pair.Key))
+		{
+			staleItems.Add(pair.Key);
+		}
+	}
+	Inventory->RemoveGroupOfItems(staleItems);
+
+	ActiveSyncId = INDEX_NONE;
+	ReceivedSyncItems.Empty();
+
+	Server_ConfirmInventorySync(bSyncFailed ? ESetStatus::CouldNotSetInventory : ESetStatus::Success, Inventory->GetStateHash().GetHash());
+}
+
+void URPCBasedInventoryComponent::Server_ConfirmInventorySync_Implementation(ESetStatus serverStatus, uint64 clientHash)
+{
+	ensure(GetOwner()->GetLocalRole() == ROLE_Authority);
+
+	FExpectedClientHash expected;
+	if (!ExpectedClientHashes.Dequeue(expected))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Received a sync confirmation that was not expected. Ignoring..."));
+		return;
+	}
+
+	if (serverStatus != ESetStatus::Success || (expected.bVerify && clientHash != expected.Hash))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Client could not set inventory; needs correction. Client status: %s"), *UEnum::GetValueAsString<ESetStatus>(serverStatus));
+		UE_LOG(LogTemp, Log, TEXT("Attempting to set client to server inventory..."));
+		StartInventorySync();
+	}
+}
+
+bool URPCBasedInventoryComponent::IsSyncing() const
+{
+	return ActiveSyncId != INDEX_NONE;
+}
+
+bool URPCBasedInventoryComponent::SetInstanceField(const FName itemCode, EInstanceDataField field, int32 value)
+{
+	if (GetOwner() && GetOwner()->GetLocalRole() != ROLE_Authority)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Instance data can only be changed on the server. Ignoring change to item %s."), *itemCode.ToString());
+		return false;
+	}
+
+	if (!Inventory->SetInstanceField(itemCode, field, value))
+	{
+		return false;
+	}
+
+	// Batch every field change made this frame into a single delta RPC
+	UWorld* world = GetWorld();
+	if (world == nullptr)
+	{
+		FlushInstanceData();
+	}
+	else if (!InstanceDataFlushHandle.IsValid())
+	{
+		InstanceDataFlushHandle = world->GetTimerManager().SetTimerForNextTick(this, &URPCBasedInventoryComponent::FlushInstanceData);
+	}
+
+	return true;
+}
+
+int32 URPCBasedInventoryComponent::GetInstanceField(const FName itemCode, EInstanceDataField field) const
+{
+	return Inventory->GetInstanceField(itemCode, field);
+}
+
+void URPCBasedInventoryComponent::FlushInstanceData()
+{
+	InstanceDataFlushHandle.Invalidate();
+
+	FInventoryInstanceStore& store = Inventory->GetInstanceStore();
+	if (!store.HasPendingDeltas())
+	{
+		return;
+	}
+
+	TArray<FInventoryInstanceDataDelta> deltas;
+	store.ConsumeDeltas(deltas);
+	Client_ApplyInstanceDataDeltas(deltas);
+}
+
+void URPCBasedInventoryComponent::Client_ApplyInstanceDataDeltas_Implementation(const TArray<FInventoryInstanceDataDelta>& deltas)
+{
+	if (GetOwner()->GetLocalRole() == ROLE_Authority)
+	{
+		return;
+	}
+
+	FInventoryInstanceStore& store = Inventory->GetInstanceStore();
+	for (const FInventoryInstanceDataDelta& delta : deltas)
+	{
+		// The entry may already have been removed by an earlier modification
+		if (Inventory->Contains(delta.ItemCode))
+		{
+			store.ApplyDelta(delta);
+		}
+	}
+}
+
+void URPCBasedInventoryComponent::ScheduleChangeBroadcast()
+{
+	UWorld* world = GetWorld();
+	if (world == nullptr)
+	{
+		BroadcastPendingChanges();
+	}
+	else if (!ChangeBroadcastHandle.IsValid())
+	{
+		ChangeBroadcastHandle = world->GetTimerManager().SetTimerForNextTick(this, &URPCBasedInventoryComponent::BroadcastPendingChanges);
+	}
+}
+
+void URPCBasedInventoryComponent::BroadcastPendingChanges()
+{
+	ChangeBroadcastHandle.Invalidate();
+
+	FInventoryChangeSet changeSet;
+	Inventory->ConsumeChanges(changeSet);
+
+	if (!changeSet.IsEmpty())
+	{
+		OnInventoryChanged.Broadcast(changeSet);
 	}
 }
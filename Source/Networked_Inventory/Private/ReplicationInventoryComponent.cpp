@@ -2,17 +2,49 @@
 
 
 #include "ReplicationInventoryComponent.h"
+#include "TimerManager.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "InventoryPersistenceSubsystem.h"
+#include "InventoryTrace.h"
+#include "InventoryMemory.h"
+#include "InventoryItemRegistry.h"
+#include "InventoryVerifier.h"
+#include "InventoryAggregateSubsystem.h"
+
+static constexpr float EntryStreamInterval = 0.1f;
+
+class FInventoryMutationScope
+{
+public:
+	FInventoryMutationScope(UReplicationInventoryComponent* component) : Component(component)
+	{
+		if (Component->MutationDepth++ == 0)
+		{
+			Component->BeginMutation();
+		}
+	}
+
+	~FInventoryMutationScope()
+	{
+		if (--Component->MutationDepth == 0)
+		{
+			Component->EndMutation();
+		}
+	}
+
+private:
+	UReplicationInventoryComponent* Component;
+};
 
 void UReplicationInventoryComponent::RebuildCache()
 {
 	LookupCache.Empty();
-	for (int32 i = 0; i < InventoryArray.Num(); i++)
+	for (int32 i = 0; i < InventoryArray.Entries.Num(); i++)
 	{
-		LookupCache.Add(InventoryArray[i].ItemCode, i);
-		check(InventoryArray[i] == InventoryArray[LookupCache[InventoryArray[i].ItemCode]]);
+		LookupCache.Add(InventoryArray.Entries[i].ItemCode, i);
 	}
 
-	check(LookupCache.Num() == InventoryArray.Num());
+	check(LookupCache.Num() == InventoryArray.Entries.Num());  // Anything deeper is left to FInventoryVerifier
 }
 
 UReplicationInventoryComponent::UReplicationInventoryComponent()
@@ -20,17 +52,123 @@ UReplicationInventoryComponent::UReplicationInventoryComponent()
 	// No need to tick.
 	PrimaryComponentTick.bCanEverTick = false;
 
-	// ...
+	MutationDepth = 0;
+	bInventoryArrayDirty = false;
+	bInstanceRecordsDirty = false;
+	bCounterValuesDirty = false;
+	bManageNetDormancy = false;
+	DormancyIdleSeconds = 5.0f;
+	SyncChunkEntries = 64;
+
+	Counters.Initialize(this,
+		[this](const TArray<FInventoryCounterValue>& values) { SendCounters(values); },
+		[this](const FName itemCode, int64 oldValue, int64 newValue) { OnCounterChanged(itemCode, oldValue, newValue); });
+}
+
+void UReplicationInventoryComponent::BeginMutation()
+{
+	AActor* owner = GetOwner();
+	if (!bManageNetDormancy || owner == nullptr || owner->GetLocalRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	// Replicated properties of a dormant actor must be flushed before they are changed
+	if (owner->NetDormancy > DORM_Awake)
+	{
+		owner->FlushNetDormancy();
+		owner->SetNetDormancy(DORM_Awake);
+	}
+}
+
+void UReplicationInventoryComponent::EndMutation()
+{
+	Snapshots.Publish();
+
+	if (FInventoryVerifier::ShouldSample())
+	{
+		SubmitVerificationSample();
+	}
+
+	if (bInventoryArrayDirty)
+	{
+		InventoryArray.MarkChanged();
+		MARK_PROPERTY_DIRTY_FROM_NAME(UReplicationInventoryComponent, InventoryArray, this);
+		bInventoryArrayDirty = false;
+	}
+
+	if (bInstanceRecordsDirty)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UReplicationInventoryComponent, InstanceRecords, this);
+		bInstanceRecordsDirty = false;
+	}
+
+	if (bCounterValuesDirty)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UReplicationInventoryComponent, CounterValues, this);
+		bCounterValuesDirty = false;
+	}
+
+	AActor* owner = GetOwner();
+	UWorld* world = GetWorld();
+	if (owner == nullptr || world == nullptr || owner->GetLocalRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	MarkPersistenceDirty();
+
+	if (!bManageNetDormancy)
+	{
+		return;
+	}
+
+	// Go back to sleep once the inventory has been quiet long enough for the changes to have replicated
+	world->GetTimerManager().SetTimer(DormancyTimerHandle, this, &UReplicationInventoryComponent::EnterDormancy, DormancyIdleSeconds, false);
+}
+
+void UReplicationInventoryComponent::ContinueEntryStreams()
+{
+	if (!InventoryArray.ConsumePendingEntries())
+	{
+		return;
+	}
+
+	// Some connection still has entries to receive; the property stays dirty until it has been replicated again
+	AActor* owner = GetOwner();
+	if (owner->NetDormancy > DORM_Awake)
+	{
+		owner->FlushNetDormancy();
+	}
+	MARK_PROPERTY_DIRTY_FROM_NAME(UReplicationInventoryComponent, InventoryArray, this);
+}
+
+void UReplicationInventoryComponent::EnterDormancy()
+{
+	AActor* owner = GetOwner();
+	if (owner != nullptr && owner->NetDormancy == DORM_Awake)
+	{
+		owner->SetNetDormancy(DORM_DormantAll);
+	}
 }
 
 void UReplicationInventoryComponent::GetLifetimeReplicatedProps(TArray <FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-	DOREPLIFETIME(UReplicationInventoryComponent, InventoryArray);
+
+	// Push based: the server only compares these when a mutation batch has marked them dirty
+	FDoRepLifetimeParams params;
+	params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UReplicationInventoryComponent, InventoryArray, params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UReplicationInventoryComponent, InstanceRecords, params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UReplicationInventoryComponent, CounterValues, params);
 }
 
 TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UReplicationInventoryComponent::ModifyGroupOfEntries(const TArray<FInventoryEntry>& inventoryChanges)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryMutationScope mutationScope(this);
+
 	TArray<EChangeStatus> changeStatuses;
 	changeStatuses.Reserve(inventoryChanges.Num());
 
@@ -54,6 +192,9 @@ TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UReplicationInventoryComponent
 
 TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UReplicationInventoryComponent::ModifyGroupOfEntries(const TMap<FName, int32>& inventoryChanges)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryMutationScope mutationScope(this);
+
 	TArray<EChangeStatus> changeStatuses;
 	changeStatuses.Reserve(inventoryChanges.Num());
 
@@ -80,6 +221,11 @@ TTuple<EChangeGroupStatus, TArray<EChangeStatus>> UReplicationInventoryComponent
 
 void UReplicationInventoryComponent::AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges)
 {
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Add, inventoryChanges);
+	}
+
 	checkCode(
 		for (const FInventoryEntry& entry : inventoryChanges)
 		{
@@ -94,6 +240,11 @@ void UReplicationInventoryComponent::AddItemsToInventory(const TArray<FInventory
 
 void UReplicationInventoryComponent::RemoveItemsFromInventory(const TArray<FInventoryEntry>& inventoryChanges)
 {
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Remove, inventoryChanges);
+	}
+
 	TArray<FInventoryEntry> finalChanges;
 	finalChanges.Reserve(inventoryChanges.Num());
 	for (const FInventoryEntry& entry : inventoryChanges)
@@ -115,47 +266,69 @@ void UReplicationInventoryComponent::RemoveItemsFromInventory(const TArray<FInve
 
 EAddStatus UReplicationInventoryComponent::AddNewEntry(const FInventoryEntry& entry)
 {
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryMutationScope mutationScope(this);
+
 	if (Contains(entry.ItemCode))
 	{
 		return EAddStatus::ItemAlreadyInInventory;
 	}
 
-	InventoryArray.Add(entry);
-	LookupCache[entry.ItemCode] = InventoryArray.Num() - 1;
+	InventoryArray.Entries.Add(entry);
+	LookupCache.Add(entry.ItemCode, InventoryArray.Entries.Num() - 1);
+	bInventoryArrayDirty = true;
 
-	check(InventoryArray[LookupCache[entry.ItemCode]] == entry);
+	check(InventoryArray.Entries[LookupCache[entry.ItemCode]] == entry);
+
+	OnEntryChanged(entry.ItemCode, 0, entry.Quantity);
 
 	return EAddStatus::Success;
 }
 
 EChangeStatus UReplicationInventoryComponent::ModifyEntry(const FInventoryEntry& entryChange)
 {
+	if (FInventoryItemRegistry::Get().GetCounterPolicy(entryChange.ItemCode) != nullptr)
+	{
+		return AddToCounter(entryChange.ItemCode, entryChange.Quantity) ? EChangeStatus::Success : EChangeStatus::CouldNotMakeChange;
+	}
+
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	FInventoryMutationScope mutationScope(this);
+
 	if (!Contains(entryChange.ItemCode))
 	{
-		InventoryArray.Emplace(entryChange.ItemCode, 0);
-		LookupCache.Add(entryChange.ItemCode, InventoryArray.Num() - 1);
+		InventoryArray.Entries.Emplace(entryChange.ItemCode, 0);
+		LookupCache.Add(entryChange.ItemCode, InventoryArray.Entries.Num() - 1);
 	}
-	int32& quantityRef = InventoryArray[LookupCache[entryChange.ItemCode]].Quantity;
+	int32& quantityRef = InventoryArray.Entries[LookupCache[entryChange.ItemCode]].Quantity;
+	const int32 oldQuantity = quantityRef;
 	quantityRef += entryChange.Quantity;
+	bInventoryArrayDirty = true;
 
-	check(quantityRef == InventoryArray[LookupCache[entryChange.ItemCode]].Quantity);
+	check(quantityRef == InventoryArray.Entries[LookupCache[entryChange.ItemCode]].Quantity);
 
 	if (quantityRef <= 0)
 	{
 		UE_LOG(LogTemp, Log, TEXT("Non-positive quantity for item %s. Quantity: %i. Removing..."), *entryChange.ItemCode.ToString(), entryChange.Quantity);
 
-		ERemovalStatus status = RemoveItem(entryChange.ItemCode);
+		ERemovalStatus status = RemoveEntry(entryChange.ItemCode, oldQuantity);
 		if (status != ERemovalStatus::Success)
 		{
 			return EChangeStatus::CouldNotMakeChange;
 		}
+
+		return EChangeStatus::Success;
 	}
 
+	OnEntryChanged(entryChange.ItemCode, oldQuantity, quantityRef);
+
 	return EChangeStatus::Success;
 }
 
 TArray<ERemovalStatus> UReplicationInventoryComponent::RemoveGroupOfItems(const TArray<FName>& itemsToRemove)
 {
+	FInventoryMutationScope mutationScope(this);
+
 	TArray<ERemovalStatus> removalStatuses;
 	removalStatuses.Reserve(itemsToRemove.Num());
 
@@ -170,11 +343,11 @@ TArray<ERemovalStatus> UReplicationInventoryComponent::RemoveGroupOfItems(const
 
 ERemovalStatus UReplicationInventoryComponent::RemoveItem(const FName itemCode)
 {
+	FInventoryMutationScope mutationScope(this);
+
 	if (Contains(itemCode))
 	{
-		InventoryArray.RemoveAt(LookupCache[itemCode]);  // Exception coming from here, when using RemoveAtSwap()
-		RebuildCache();  // Rebuild the cache entries
-		return ERemovalStatus::Success;
+		return RemoveEntry(itemCode, InventoryArray.Entries[LookupCache[itemCode]].Quantity);
 	}
 	else
 	{
@@ -182,11 +355,219 @@ ERemovalStatus UReplicationInventoryComponent::RemoveItem(const FName itemCode)
 	}
 }
 
+ERemovalStatus UReplicationInventoryComponent::RemoveEntry(const FName itemCode, int32 previousQuantity)
+{
+	if (!Contains(itemCode))
+	{
+		return ERemovalStatus::ItemNotInInventory;
+	}
+
+	InventoryArray.Entries.RemoveAt(LookupCache[itemCode]);  // Exception coming from here, when using RemoveAtSwap()
+	RebuildCache();  // Rebuild the cache entries
+	bInventoryArrayDirty = true;
+	InstanceData.Release(itemCode);
+	RemoveInstanceRecord(itemCode);
+	OnEntryChanged(itemCode, previousQuantity, 0);
+	return ERemovalStatus::Success;
+}
+
+void UReplicationInventoryComponent::OnEntryChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity)
+{
+	TagIndex.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	Snapshots.OnQuantityChanged(itemCode, newQuantity);
+	Aggregates.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	Expiries.OnQuantityChanged(itemCode, newQuantity);
+	for (FInventorySortedView& view : SortedViews)
+	{
+		view.OnQuantityChanged(itemCode, oldQuantity, newQuantity);
+	}
+
+	if (PendingChanges.Record(itemCode, oldQuantity, newQuantity))
+	{
+		UWorld* world = GetWorld();
+		if (world == nullptr)
+		{
+			BroadcastPendingChanges();
+		}
+		else if (!ChangeBroadcastHandle.IsValid())
+		{
+			ChangeBroadcastHandle = world->GetTimerManager().SetTimerForNextTick(this, &UReplicationInventoryComponent::BroadcastPendingChanges);
+		}
+	}
+}
+
+void UReplicationInventoryComponent::BroadcastPendingChanges()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	ChangeBroadcastHandle.Invalidate();
+
+	FInventoryChangeSet changeSet;
+	PendingChanges.Consume(changeSet);
+
+	if (!changeSet.IsEmpty())
+	{
+		OnInventoryChanged.Broadcast(changeSet);
+	}
+}
+
+int32 UReplicationInventoryComponent::CountItemsWithTag(const FName tag) const
+{
+	return TagIndex.CountItemsWithTag(tag);
+}
+
+int64 UReplicationInventoryComponent::GetQuantityForTag(const FName tag) const
+{
+	return TagIndex.GetQuantityForTag(tag);
+}
+
+const TSet<FName>* UReplicationInventoryComponent::GetItemsWithTag(const FName tag) const
+{
+	return TagIndex.GetItemsWithTag(tag);
+}
+
+void UReplicationInventoryComponent::RebuildTagIndex()
+{
+	TagIndex.Reset();
+	for (FInventorySortedView& view : SortedViews)
+	{
+		view.Reset();
+	}
+
+	for (const FInventoryEntry& entry : InventoryArray.Entries)
+	{
+		TagIndex.OnQuantityChanged(entry.ItemCode, 0, entry.Quantity);
+		for (FInventorySortedView& view : SortedViews)
+		{
+			view.OnQuantityChanged(entry.ItemCode, 0, entry.Quantity);
+		}
+	}
+}
+
+bool UReplicationInventoryComponent::JoinAggregateView(const FName view)
+{
+	UInventoryAggregateSubsystem* aggregates = UInventoryAggregateSubsystem::Get(this);
+	return aggregates != nullptr && Aggregates.Join(aggregates->GetViews(), view, [this](auto&& addEntry)
+	{
+		for (const FInventoryEntry& entry : InventoryArray.Entries)
+		{
+			addEntry(entry.ItemCode, entry.Quantity);
+		}
+		Counters.ForEachValue(addEntry);
+	});
+}
+
+bool UReplicationInventoryComponent::LeaveAggregateView(const FName view)
+{
+	return Aggregates.Leave(view, [this](auto&& removeEntry)
+	{
+		for (const FInventoryEntry& entry : InventoryArray.Entries)
+		{
+			removeEntry(entry.ItemCode, entry.Quantity);
+		}
+		Counters.ForEachValue(removeEntry);
+	});
+}
+
+void UReplicationInventoryComponent::LeaveAllAggregateViews()
+{
+	Aggregates.LeaveAll([this](auto&& removeEntry)
+	{
+		for (const FInventoryEntry& entry : InventoryArray.Entries)
+		{
+			removeEntry(entry.ItemCode, entry.Quantity);
+		}
+		Counters.ForEachValue(removeEntry);
+	});
+}
+
+bool UReplicationInventoryComponent::SetItemExpiry(const FName itemCode, float lifetimeSeconds)
+{
+	if (GetOwner() && GetOwner()->GetLocalRole() != ROLE_Authority)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Expiry can only be set on the server. Ignoring expiry of item %s."), *itemCode.ToString());
+		return false;
+	}
+
+	if (!LookupCache.Contains(itemCode) || !Expiries.Set(this, itemCode, lifetimeSeconds))
+	{
+		return false;
+	}
+
+	MarkPersistenceDirty();
+	return true;
+}
+
+bool UReplicationInventoryComponent::ClearItemExpiry(const FName itemCode)
+{
+	if (!Expiries.Clear(itemCode))
+	{
+		return false;
+	}
+
+	MarkPersistenceDirty();
+	return true;
+}
+
+void UReplicationInventoryComponent::GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const
+{
+	Expiries.GetExpiries(outExpiries);
+}
+
+float UReplicationInventoryComponent::GetItemLifetimeRemaining(const FName itemCode) const
+{
+	return Expiries.GetLifetimeRemaining(itemCode);
+}
+
+void UReplicationInventoryComponent::EnableSortedView(EInventorySortOrder order)
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	if (GetSortedView(order) != nullptr)
+	{
+		return;
+	}
+
+	FInventorySortedView& view = SortedViews.Emplace_GetRef(order);
+	for (const FInventoryEntry& entry : InventoryArray.Entries)
+	{
+		view.OnQuantityChanged(entry.ItemCode, 0, entry.Quantity);
+	}
+}
+
+void UReplicationInventoryComponent::DisableSortedView(EInventorySortOrder order)
+{
+	SortedViews.RemoveAll([order](const FInventorySortedView& view) { return view.GetOrder() == order; });
+}
+
+const FInventorySortedView* UReplicationInventoryComponent::GetSortedView(EInventorySortOrder order) const
+{
+	return SortedViews.FindByPredicate([order](const FInventorySortedView& view) { return view.GetOrder() == order; });
+}
+
+TArray<FInventoryEntry> UReplicationInventoryComponent::GetSortedPage(EInventorySortOrder order, int32 pageIndex, int32 pageSize) const
+{
+	TArray<FInventoryEntry> page;
+	if (const FInventorySortedView* view = GetSortedView(order))
+	{
+		view->GetPage(pageIndex, pageSize, page);
+	}
+	return page;
+}
+
+int32 UReplicationInventoryComponent::GetSortedRank(EInventorySortOrder order, const FName itemCode) const
+{
+	const FInventorySortedView* view = GetSortedView(order);
+	return view ? view->GetRank(itemCode) : INDEX_NONE;
+}
+
 int32 UReplicationInventoryComponent::GetQuantityFor(const FName itemCode) const
 {
-	if (Contains(itemCode))
+	if (FInventoryItemRegistry::Get().GetCounterPolicy(itemCode) != nullptr)
+	{
+		return (int32)FMath::Min<int64>(Counters.GetValue(itemCode), MAX_int32);
+	}
+	else if (Contains(itemCode))
 	{
-		return InventoryArray[LookupCache[itemCode]].Quantity;
+		return InventoryArray.Entries[LookupCache[itemCode]].Quantity;
 	}
 	else
 	{
@@ -196,32 +577,45 @@ int32 UReplicationInventoryComponent::GetQuantityFor(const FName itemCode) const
 
 bool UReplicationInventoryComponent::Contains(const FName itemCode) const
 {
-	checkCode(
-		auto pred = [&itemCode](const FInventoryEntry& entry)
-		{
-			return entry.ItemCode == itemCode;
-		};
-	check(static_cast<bool>(InventoryArray.FindByPredicate(pred)) == LookupCache.Contains(itemCode));
-	);
-
 	return LookupCache.Contains(itemCode);
 }
 
 int32 UReplicationInventoryComponent::Num() const
 {
-	check(InventoryArray.Num() == LookupCache.Num());
-	return InventoryArray.Num();
+	check(InventoryArray.Entries.Num() == LookupCache.Num());
+	return InventoryArray.Entries.Num();
 }
 
 void UReplicationInventoryComponent::ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges)
 {
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Modify, inventoryChanges);
+	}
+
 	ModifyGroupOfEntries(inventoryChanges);
 }
 
+TFuture<FInventoryRequestResult> UReplicationInventoryComponent::ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges)
+{
+	if (GetOwner() && GetOwner()->GetLocalRole() != ROLE_Authority)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replicated inventories can only be changed on the server. Rejecting request of %i entries."), inventoryChanges.Num());
+		return MakeCompletedRequest(EInventoryRequestOutcome::Rejected, MakeTuple(EChangeGroupStatus::SomeChangesLost, TArray<EChangeStatus>()));
+	}
+
+	if (FInventoryTraceRecorder::IsRecording())
+	{
+		FInventoryTraceRecorder::Get().Record(this, EInventoryTraceOp::Modify, inventoryChanges);
+	}
+
+	return MakeCompletedRequest(EInventoryRequestOutcome::Committed, ModifyGroupOfEntries(inventoryChanges));
+}
+
 FString UReplicationInventoryComponent::ToString() const
 {
 	FString s = "{\n";
-	for (const auto& entry : InventoryArray)
+	for (const auto& entry : InventoryArray.Entries)
 	{
 		s.Appendf(TEXT("\t%s: %i\n"), *entry.ItemCode.ToString(), entry.Quantity);
 	}
@@ -229,15 +623,368 @@ FString UReplicationInventoryComponent::ToString() const
 	return s;
 }
 
+void UReplicationInventoryComponent::GetEntries(TArray<FInventoryEntry>& outEntries) const
+{
+	outEntries = InventoryArray.Entries;
+}
+
 void UReplicationInventoryComponent::OnRep_InventoryArray()
 {
-	UE_LOG(LogTemp, Log, TEXT("Received new value for inventory array!"));
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+
+	// Entries arrive a few at a time and in no particular order, so only the quantities they replaced are kept
 	RebuildCache();
+	for (const auto& pair : InventoryArray.ReceivedPreviousQuantities)
+	{
+		const int32 quantity = GetQuantityFor(pair.Key);
+		if (quantity != pair.Value)
+		{
+			OnEntryChanged(pair.Key, pair.Value, quantity);
+		}
+	}
+	InventoryArray.ReceivedPreviousQuantities.Reset();
+
+	Snapshots.Publish();
+
+	if (FInventoryVerifier::ShouldSample())
+	{
+		SubmitVerificationSample();
+	}
+}
+
+void UReplicationInventoryComponent::SubmitVerificationSample() const
+{
+	FInventoryVerificationSample sample;
+	sample.Context = GetPathName();
+	sample.Entries = InventoryArray.Entries;
+	sample.bHasLookupCache = true;
+	sample.LookupCache = LookupCache;
+	sample.Snapshot = Snapshots.GetLatest();
+	FInventoryVerifier::Get().Submit(MoveTemp(sample));
+}
+
+void UReplicationInventoryComponent::EnableSnapshots()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	Snapshots.EnableFrom([this](auto&& addEntry)
+	{
+		for (const FInventoryEntry& entry : InventoryArray.Entries)
+		{
+			addEntry(entry.ItemCode, entry.Quantity);
+		}
+	});
+}
+
+FInventorySnapshotPtr UReplicationInventoryComponent::GetSnapshot() const
+{
+	return Snapshots.GetLatest();
+}
+
+bool UReplicationInventoryComponent::SetInstanceField(const FName itemCode, EInstanceDataField field, int32 value)
+{
+	if (GetOwner() && GetOwner()->GetLocalRole() != ROLE_Authority)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Instance data can only be changed on the server. Ignoring change to item %s."), *itemCode.ToString());
+		return false;
+	}
+
+	if (!Contains(itemCode))
+	{
+		return false;
+	}
+
+	InstanceData.SetField(itemCode, field, value);
+
+	// Fold every field change made this frame into the replicated records once
+	UWorld* world = GetWorld();
+	if (world == nullptr)
+	{
+		FlushInstanceData();
+	}
+	else if (!InstanceDataFlushHandle.IsValid())
+	{
+		InstanceDataFlushHandle = world->GetTimerManager().SetTimerForNextTick(this, &UReplicationInventoryComponent::FlushInstanceData);
+	}
+
+	return true;
+}
+
+int32 UReplicationInventoryComponent::GetInstanceField(const FName itemCode, EInstanceDataField field) const
+{
+	return InstanceData.GetField(itemCode, field);
+}
+
+const FInventoryInstanceData* UReplicationInventoryComponent::FindInstanceData(const FName itemCode) const
+{
+	return InstanceData.Find(itemCode);
+}
+
+void UReplicationInventoryComponent::FlushInstanceData()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	InstanceDataFlushHandle.Invalidate();
+
+	if (!InstanceData.HasPendingDeltas())
+	{
+		return;
+	}
+
+	FInventoryMutationScope mutationScope(this);
+
+	TArray<FInventoryInstanceDataDelta> deltas;
+	InstanceData.ConsumeDeltas(deltas);
+
+	for (const FInventoryInstanceDataDelta& delta : deltas)
+	{
+		if (const int32* index = InstanceRecordLookup.Find(delta.ItemCode))
+		{
+			InstanceRecords[*index].Data = delta.Values;
+		}
+		else
+		{
+			InstanceRecordLookup.Add(delta.ItemCode, InstanceRecords.Emplace(delta.ItemCode, delta.Values));
+		}
+	}
+	bInstanceRecordsDirty = true;
+}
+
+void UReplicationInventoryComponent::RemoveInstanceRecord(const FName itemCode)
+{
+	int32 index;
+	if (!InstanceRecordLookup.RemoveAndCopyValue(itemCode, index))
+	{
+		return;
+	}
+
+	InstanceRecords.RemoveAtSwap(index);
+	bInstanceRecordsDirty = true;
+	if (index < InstanceRecords.Num())
+	{
+		InstanceRecordLookup[InstanceRecords[index].ItemCode] = index;
+	}
+}
+
+void UReplicationInventoryComponent::OnRep_InstanceRecords()
+{
+	LLM_SCOPE_BYTAG(NetworkedInventory);
+	InstanceData.Reset();
+	InstanceRecordLookup.Empty(InstanceRecords.Num());
+
+	FInventoryInstanceDataDelta delta;
+	delta.ChangedFields = (1 << FInventoryInstanceData::NumFields) - 1;
+	for (int32 i = 0; i < InstanceRecords.Num(); i++)
+	{
+		delta.ItemCode = InstanceRecords[i].ItemCode;
+		delta.Values = InstanceRecords[i].Data;
+		InstanceData.ApplyDelta(delta);
+		InstanceRecordLookup.Add(delta.ItemCode, i);
+	}
+}
+
+bool UReplicationInventoryComponent::AddToCounter(const FName itemCode, int64 delta)
+{
+	return Counters.Add(itemCode, delta);
+}
+
+bool UReplicationInventoryComponent::SetCounter(const FName itemCode, int64 value)
+{
+	return Counters.Set(itemCode, value);
+}
+
+int64 UReplicationInventoryComponent::GetCounterValue(const FName itemCode) const
+{
+	return Counters.GetValue(itemCode);
+}
+
+int64 UReplicationInventoryComponent::GetDisplayedCounterValue(const FName itemCode) const
+{
+	return (int64)FMath::RoundToDouble(Counters.GetDisplayValue(itemCode));
+}
+
+void UReplicationInventoryComponent::GetCounterValues(TArray<FInventoryCounterValue>& outValues) const
+{
+	Counters.GetValues(outValues);
+}
+
+void UReplicationInventoryComponent::SendCounters(const TArray<FInventoryCounterValue>& values)
+{
+	// Wakes a dormant owner and marks the values dirty once, like any other batch
+	FInventoryMutationScope mutationScope(this);
+
+	for (const FInventoryCounterValue& value : values)
+	{
+		if (const int32* index = CounterValueLookup.Find(value.ItemCode))
+		{
+			CounterValues[*index].Value = value.Value;
+		}
+		else
+		{
+			CounterValueLookup.Add(value.ItemCode, CounterValues.Add(value));
+		}
+	}
+	bCounterValuesDirty = true;
+}
+
+void UReplicationInventoryComponent::OnCounterChanged(const FName itemCode, int64 oldValue, int64 newValue)
+{
+	Aggregates.OnQuantityChanged(itemCode, oldValue, newValue);
+
+	// Counters reach clients on their own schedule, but are saved with the rest of the inventory
+	MarkPersistenceDirty();
+}
+
+void UReplicationInventoryComponent::MarkPersistenceDirty()
+{
+	if (!PersistenceId.IsEmpty())
+	{
+		if (UInventoryPersistenceSubsystem* persistence = UInventoryPersistenceSubsystem::Get(this))
+		{
+			persistence->MarkDirty(this, PersistenceId);
+		}
+	}
+}
+
+void UReplicationInventoryComponent::OnRep_CounterValues()
+{
+	Counters.ApplyReplicated(CounterValues);
+}
+
+FInventoryMemoryUsage UReplicationInventoryComponent::GetMemoryUsage() const
+{
+	FInventoryMemoryUsage usage;
+	usage.NumEntries = InventoryArray.Entries.Num();
+
+	const SIZE_T entryBytes = InventoryArray.Entries.GetAllocatedSize() + LookupCache.GetAllocatedSize()
+		+ InstanceRecords.GetAllocatedSize() + InstanceRecordLookup.GetAllocatedSize();
+	SIZE_T indexBytes = InstanceData.GetAllocatedSize() + TagIndex.GetAllocatedSize() + PendingChanges.GetAllocatedSize() + Snapshots.GetAllocatedSize() + SortedViews.GetAllocatedSize()
+		+ Counters.GetAllocatedSize() + CounterValues.GetAllocatedSize() + CounterValueLookup.GetAllocatedSize() + Expiries.GetAllocatedSize();
+	for (const FInventorySortedView& view : SortedViews)
+	{
+		indexBytes += view.GetAllocatedSize();
+	}
+	usage.AllocatedBytes = entryBytes + indexBytes;
+	usage.UsedBytes = InventoryMemory::GetUsedSize(InventoryArray.Entries) + InventoryMemory::GetUsedSize(LookupCache)
+		+ InventoryMemory::GetUsedSize(InstanceRecords) + InventoryMemory::GetUsedSize(InstanceRecordLookup) + indexBytes;
+	return usage;
+}
+
+void UReplicationInventoryComponent::Shrink()
+{
+	check(MutationDepth == 0);
+
+	// Shrinking keeps element order, so nothing is marked dirty for replication
+	InventoryArray.Entries.Shrink();
+	InstanceRecords.Shrink();
+	LookupCache.Compact();
+	LookupCache.Shrink();
+	InstanceRecordLookup.Compact();
+	InstanceRecordLookup.Shrink();
+	InstanceData.Shrink();
+	TagIndex.Shrink();
+	PendingChanges.Shrink();
+}
+
+void UReplicationInventoryComponent::BeginDestroy()
+{
+	LeaveAllAggregateViews();
+	Expiries.ClearAll();
+	InstanceData.Reset();  // Free every instance payload in one go
+	Super::BeginDestroy();
 }
 
 void UReplicationInventoryComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
+	AActor* owner = GetOwner();
+	if (owner->GetLocalRole() != ROLE_Authority)
+	{
+		// Item codes replicate by name until the server has matched the owning client's item registry
+		if (owner->GetNetConnection() != nullptr)
+		{
+			Server_ReportItemRegistry(FInventoryItemRegistry::Get().BeginNetIndexAgreement(owner->GetNetConnection()));
+		}
+		return;
+	}
+
+	if (bManageNetDormancy)
+	{
+		GetWorld()->GetTimerManager().SetTimer(DormancyTimerHandle, this, &UReplicationInventoryComponent::EnterDormancy, DormancyIdleSeconds, false);
+	}
+
+	InventoryArray.PriorityTags = PrioritySyncTags;
+	InventoryArray.MaxEntriesPerUpdate = SyncChunkEntries;
+	if (GetNetMode() != NM_Standalone)
+	{
+		GetWorld()->GetTimerManager().SetTimer(EntryStreamTimerHandle, this, &UReplicationInventoryComponent::ContinueEntryStreams, EntryStreamInterval, true);
+	}
+
+	if (!PersistenceId.IsEmpty())
+	{
+		if (UInventoryPersistenceSubsystem* persistence = UInventoryPersistenceSubsystem::Get(this))
+		{
+			TWeakObjectPtr<UReplicationInventoryComponent> weakThis = this;
+			persistence->LoadAsync(this, PersistenceId, [weakThis](const FInventoryPersistenceRecord& record)
+			{
+				weakThis->ApplyLoadedRecord(record);
+			});
+		}
+	}
+}
+
+void UReplicationInventoryComponent::Server_ReportItemRegistry_Implementation(uint32 checksum)
+{
+	FInventoryItemRegistry& registry = FInventoryItemRegistry::Get();
+	if (registry.AcceptNetIndexAgreement(GetOwner()->GetNetConnection(), checksum))
+	{
+		Client_AcceptItemRegistry(checksum);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: client item registry (checksum %08x) differs from the server's (%08x). Item codes will be sent by name."), *GetOwner()->GetName(), checksum, registry.GetNetIndexChecksum());
+	}
+}
+
+void UReplicationInventoryComponent::Client_AcceptItemRegistry_Implementation(uint32 checksum)
+{
+	FInventoryItemRegistry::Get().ConfirmNetIndexAgreement(GetOwner()->GetNetConnection(), checksum);
+}
+
+void UReplicationInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (!PersistenceId.IsEmpty())
+	{
+		if (UInventoryPersistenceSubsystem* persistence = UInventoryPersistenceSubsystem::Get(this))
+		{
+			persistence->FlushInventory(this);
+		}
+	}
+
+	// Destroyed actors stop counting and expiring now rather than at the next garbage collection
+	LeaveAllAggregateViews();
+	Expiries.ClearAll();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UReplicationInventoryComponent::ApplyLoadedRecord(const FInventoryPersistenceRecord& record)
+{
+	Counters.SetAll(record.Counters);
+
+	// Saved quantities are absolute; apply them as one batch of changes
+	TMap<FName, int32> changes;
+	for (const FInventoryEntry& entry : InventoryArray.Entries)
+	{
+		changes.Add(entry.ItemCode, -entry.Quantity);
+	}
+	for (const FInventoryEntry& entry : record.Entries)
+	{
+		changes.FindOrAdd(entry.ItemCode, 0) += entry.Quantity;
+	}
+
+	ModifyGroupOfEntries(changes);
+
+	// Expiries were saved as UTC times, so time the server was down counts towards them
+	TArray<FInventoryItemExpiry> heldExpiries = record.Expiries.FilterByPredicate([this](const FInventoryItemExpiry& expiry) { return LookupCache.Contains(expiry.ItemCode); });
+	Expiries.Restore(this, heldExpiries);
 }
\ No newline at end of file
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SQLiteInventoryPersistenceBackend.h"
+#include "SQLiteDatabase.h"
+#include "Misc/ScopeLock.h"
+
+FSQLiteInventoryPersistenceBackend::FSQLiteInventoryPersistenceBackend(const FString& databasePath) : Database(MakeUnique<FSQLiteDatabase>())
+{
+	if (!Database->Open(*databasePath, ESQLiteDatabaseOpenMode::ReadWriteCreate))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open inventory database %s: %s"), *databasePath, *Database->GetLastError());
+		return;
+	}
+
+	Database->Execute(TEXT("PRAGMA journal_mode=WAL;"));
+	Database->Execute(TEXT("CREATE TABLE IF NOT EXISTS inventory_entries (inventory_id TEXT NOT NULL, item_code TEXT NOT NULL, quantity INTEGER NOT NULL, PRIMARY KEY (inventory_id, item_code));"));
+	Database->Execute(TEXT("CREATE TABLE IF NOT EXISTS inventories (inventory_id TEXT NOT NULL PRIMARY KEY);"));
+	Database->Execute(TEXT("CREATE TABLE IF NOT EXISTS inventory_counters (inventory_id TEXT NOT NULL, item_code TEXT NOT NULL, value INTEGER NOT NULL, PRIMARY KEY (inventory_id, item_code));"));
+	Database->Execute(TEXT("CREATE TABLE IF NOT EXISTS inventory_expiries (inventory_id TEXT NOT NULL, item_code TEXT NOT NULL, expires_utc_ticks INTEGER NOT NULL, PRIMARY KEY (inventory_id, item_code));"));
+}
+
+FSQLiteInventoryPersistenceBackend::~FSQLiteInventoryPersistenceBackend()
+{
+	if (Database->IsValid())
+	{
+		Database->Close();
+	}
+}
+
+bool FSQLiteInventoryPersistenceBackend::IsValid() const
+{
+	return Database->IsValid();
+}
+
+bool FSQLiteInventoryPersistenceBackend::SaveBatch(const TArray<FInventoryPersistenceRecord>& records)
+{
+	FScopeLock lock(&DatabaseLock);
+	if (!Database->IsValid())
+	{
+		return false;
+	}
+
+	FSQLitePreparedStatement headerStatement = Database->PrepareStatement(TEXT("INSERT OR IGNORE INTO inventories (inventory_id) VALUES ($id);"));
+	FSQLitePreparedStatement deleteStatement = Database->PrepareStatement(TEXT("DELETE FROM inventory_entries WHERE inventory_id = $id;"));
+	FSQLitePreparedStatement insertStatement = Database->PrepareStatement(TEXT("INSERT INTO inventory_entries (inventory_id, item_code, quantity) VALUES ($id, $item, $quantity);"));
+	FSQLitePreparedStatement deleteCountersStatement = Database->PrepareStatement(TEXT("DELETE FROM inventory_counters WHERE inventory_id = $id;"));
+	FSQLitePreparedStatement insertCounterStatement = Database->PrepareStatement(TEXT("INSERT INTO inventory_counters (inventory_id, item_code, value) VALUES ($id, $item, $value);"));
+	FSQLitePreparedStatement deleteExpiriesStatement = Database->PrepareStatement(TEXT("DELETE FROM inventory_expiries WHERE inventory_id = $id;"));
+	FSQLitePreparedStatement insertExpiryStatement = Database->PrepareStatement(TEXT("INSERT INTO inventory_expiries (inventory_id, item_code, expires_utc_ticks) VALUES ($id, $item, $expires);"));
+	if (!headerStatement.IsValid() || !deleteStatement.IsValid() || !insertStatement.IsValid() || !deleteCountersStatement.IsValid() || !insertCounterStatement.IsValid()
+		|| !deleteExpiriesStatement.IsValid() || !insertExpiryStatement.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not prepare inventory statements: %s"), *Database->GetLastError());
+		return false;
+	}
+
+	if (!Database->Execute(TEXT("BEGIN TRANSACTION;")))
+	{
+		return false;
+	}
+
+	bool bSuccess = true;
+	for (const FInventoryPersistenceRecord& record : records)
+	{
+		headerStatement.Reset();
+		headerStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+		bSuccess &= headerStatement.Execute();
+
+		deleteStatement.Reset();
+		deleteStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+		bSuccess &= deleteStatement.Execute();
+
+		for (const FInventoryEntry& entry : record.Entries)
+		{
+			insertStatement.Reset();
+			insertStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+			insertStatement.SetBindingValueByName(TEXT("$item"), entry.ItemCode.ToString());
+			insertStatement.SetBindingValueByName(TEXT("$quantity"), entry.Quantity);
+			bSuccess &= insertStatement.Execute();
+		}
+
+		deleteCountersStatement.Reset();
+		deleteCountersStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+		bSuccess &= deleteCountersStatement.Execute();
+
+		for (const FInventoryCounterValue& counter : record.Counters)
+		{
+			insertCounterStatement.Reset();
+			insertCounterStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+			insertCounterStatement.SetBindingValueByName(TEXT("$item"), counter.ItemCode.ToString());
+			insertCounterStatement.SetBindingValueByName(TEXT("$value"), counter.Value);
+			bSuccess &= insertCounterStatement.Execute();
+		}
+
+		deleteExpiriesStatement.Reset();
+		deleteExpiriesStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+		bSuccess &= deleteExpiriesStatement.Execute();
+
+		for (const FInventoryItemExpiry& expiry : record.Expiries)
+		{
+			insertExpiryStatement.Reset();
+			insertExpiryStatement.SetBindingValueByName(TEXT("$id"), record.InventoryId);
+			insertExpiryStatement.SetBindingValueByName(TEXT("$item"), expiry.ItemCode.ToString());
+			insertExpiryStatement.SetBindingValueByName(TEXT("$expires"), expiry.ExpiresUtc.GetTicks());
+			bSuccess &= insertExpiryStatement.Execute();
+		}
+
+		if (!bSuccess)
+		{
+			break;
+		}
+	}
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Saving inventory batch failed: %s"), *Database->GetLastError());
+		Database->Execute(TEXT("ROLLBACK;"));
+		return false;
+	}
+
+	return Database->Execute(TEXT("COMMIT;"));
+}
+
+EInventoryLoadResult FSQLiteInventoryPersistenceBackend::Load(const FString& inventoryId, FInventoryPersistenceRecord& outRecord)
+{
+	FScopeLock lock(&DatabaseLock);
+	if (!Database->IsValid())
+	{
+		return EInventoryLoadResult::Failed;
+	}
+
+	FSQLitePreparedStatement statement = Database->PrepareStatement(TEXT("SELECT item_code, quantity FROM inventory_entries WHERE inventory_id = $id;"));
+	FSQLitePreparedStatement headerStatement = Database->PrepareStatement(TEXT("SELECT 1 FROM inventories WHERE inventory_id = $id;"));
+	FSQLitePreparedStatement countersStatement = Database->PrepareStatement(TEXT("SELECT item_code, value FROM inventory_counters WHERE inventory_id = $id;"));
+	FSQLitePreparedStatement expiriesStatement = Database->PrepareStatement(TEXT("SELECT item_code, expires_utc_ticks FROM inventory_expiries WHERE inventory_id = $id;"));
+	if (!statement.IsValid() || !headerStatement.IsValid() || !countersStatement.IsValid() || !expiriesStatement.IsValid())
+	{
+		return EInventoryLoadResult::Failed;
+	}
+
+	statement.SetBindingValueByName(TEXT("$id"), inventoryId);
+
+	outRecord.InventoryId = inventoryId;
+	outRecord.Entries.Reset();
+	ESQLitePreparedStatementStepResult stepResult;
+	while ((stepResult = statement.Step()) == ESQLitePreparedStatementStepResult::Row)
+	{
+		FString itemCode;
+		int32 quantity = 0;
+		statement.GetColumnValueByIndex(0, itemCode);
+		statement.GetColumnValueByIndex(1, quantity);
+		outRecord.Entries.Emplace(FName(*itemCode), quantity);
+	}
+
+	if (stepResult != ESQLitePreparedStatementStepResult::Done)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Loading inventory %s failed: %s"), *inventoryId, *Database->GetLastError());
+		return EInventoryLoadResult::Failed;
+	}
+
+	countersStatement.SetBindingValueByName(TEXT("$id"), inventoryId);
+	outRecord.Counters.Reset();
+	while ((stepResult = countersStatement.Step()) == ESQLitePreparedStatementStepResult::Row)
+	{
+		FString itemCode;
+		int64 value = 0;
+		countersStatement.GetColumnValueByIndex(0, itemCode);
+		countersStatement.GetColumnValueByIndex(1, value);
+		outRecord.Counters.Emplace(FName(*itemCode), value);
+	}
+
+	if (stepResult != ESQLitePreparedStatementStepResult::Done)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Loading counters of inventory %s failed: %s"), *inventoryId, *Database->GetLastError());
+		return EInventoryLoadResult::Failed;
+	}
+
+	expiriesStatement.SetBindingValueByName(TEXT("$id"), inventoryId);
+	outRecord.Expiries.Reset();
+	while ((stepResult = expiriesStatement.Step()) == ESQLitePreparedStatementStepResult::Row)
+	{
+		FString itemCode;
+		int64 expiresUtcTicks = 0;
+		expiriesStatement.GetColumnValueByIndex(0, itemCode);
+		expiriesStatement.GetColumnValueByIndex(1, expiresUtcTicks);
+		outRecord.Expiries.Emplace(FName(*itemCode), FDateTime(expiresUtcTicks));
+	}
+
+	if (stepResult != ESQLitePreparedStatementStepResult::Done)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Loading expiries of inventory %s failed: %s"), *inventoryId, *Database->GetLastError());
+		return EInventoryLoadResult::Failed;
+	}
+
+	// Databases written before the inventories table existed only have entry rows
+	if (outRecord.Entries.Num() > 0 || outRecord.Counters.Num() > 0)
+	{
+		return EInventoryLoadResult::Found;
+	}
+
+	headerStatement.SetBindingValueByName(TEXT("$id"), inventoryId);
+	switch (headerStatement.Step())
+	{
+	case ESQLitePreparedStatementStepResult::Row:
+		return EInventoryLoadResult::Found;
+	case ESQLitePreparedStatementStepResult::Done:
+		return EInventoryLoadResult::NotFound;
+	default:
+		return EInventoryLoadResult::Failed;
+	}
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Structs.h"
+#include "InventoryNetSerialization.h"
+
+namespace
+{
+	// Guards against malformed packets asking for huge allocations
+	constexpr uint32 MaxEntriesPerBatch = 1 << 16;
+}
+
+bool FInventoryEntry::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	InventoryNetSerialization::SerializeItemCode(Ar, ItemCode, Map);
+	InventoryNetSerialization::SerializeSignedPacked(Ar, Quantity);
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FInventoryEntryBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 count = Entries.Num();
+	Ar.SerializeIntPacked(count);
+
+	if (Ar.IsLoading())
+	{
+		if (count > MaxEntriesPerBatch)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Inventory batch of %u entries exceeds the limit of %u."), count, MaxEntriesPerBatch);
+			Ar.SetError();
+			bOutSuccess = false;
+			return true;
+		}
+		Entries.SetNum(count);
+	}
+
+	// Entries are grouped into runs of the same sign: [sign bit][run length] followed by that many
+	// (item code, magnitude) pairs. Additions and removals tend to come in runs, so signs are nearly free.
+	uint32 index = 0;
+	while (index < count && !Ar.IsError())
+	{
+		uint8 bNegative = 0;
+		uint32 runLength = 0;
+		if (Ar.IsSaving())
+		{
+			bNegative = Entries[index].Quantity < 0 ? 1 : 0;
+			while (index + runLength < count && (Entries[index + runLength].Quantity < 0) == (bNegative != 0))
+			{
+				runLength++;
+			}
+		}
+
+		Ar.SerializeBits(&bNegative, 1);
+		Ar.SerializeIntPacked(runLength);
+
+		if (runLength == 0 || runLength > count - index)
+		{
+			Ar.SetError();
+			break;
+		}
+
+		for (uint32 i = index; i < index + runLength; i++)
+		{
+			FInventoryEntry& entry = Entries[i];
+			InventoryNetSerialization::SerializeItemCode(Ar, entry.ItemCode, Map);
+
+			uint32 magnitude = bNegative ? 0u - static_cast<uint32>(entry.Quantity) : static_cast<uint32>(entry.Quantity);
+			Ar.SerializeIntPacked(magnitude);
+
+			if (Ar.IsLoading())
+			{
+				entry.Quantity = bNegative ? static_cast<int32>(0u - magnitude) : static_cast<int32>(magnitude);
+			}
+		}
+
+		index += runLength;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
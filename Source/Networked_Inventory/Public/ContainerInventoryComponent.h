@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Structs.h"
+#include "InventoryInterface.h"
+#include "InventoryMemory.h"
+#include "Templates/Tuple.h"
+#include "Components/ActorComponent.h"
+#include "ContainerInventoryComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryContainerChanged, FName, ContainerName);
+
+USTRUCT(BlueprintType)
+struct FInventoryContainerSpec
+{
+	GENERATED_BODY()
+
+	FInventoryContainerSpec() : Name(), Replication(EInventoryContainerReplication::OwnerOnly) {}
+	FInventoryContainerSpec(FName name, EInventoryContainerReplication replication) : Name(name), Replication(replication) {}
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory")
+		FName Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory")
+		EInventoryContainerReplication Replication;
+};
+
+/**
+ * Several named containers (backpack, equipment, bank, ...) in one component. Containers that replicate the same way
+ * share one contiguous entry array: owner-only and everyone containers are replicated properties, on-demand containers
+ * are only sent to the owner between OpenContainer() and CloseContainer(), one RPC per batch of changes.
+ * Every change made inside one call, including both halves of a cross-container move, is replicated together.
+ *
+ * The IInventoryInterface functions act on the first container.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class NETWORKED_INVENTORY_API UContainerInventoryComponent : public UActorComponent, public IInventoryInterface
+{
+	GENERATED_BODY()
+
+private:
+	typedef TTuple<uint8, FName> FContainerItemKey;
+
+	UPROPERTY(ReplicatedUsing = OnRep_OwnerEntries)
+		TArray<FInventoryContainerEntry> OwnerEntries;
+
+	UPROPERTY(ReplicatedUsing = OnRep_PublicEntries)
+		TArray<FInventoryContainerEntry> PublicEntries;
+
+	// Server: every on-demand container. Client: only the open ones.
+	TArray<FInventoryContainerEntry> OnDemandEntries;
+
+	// Index of each held item within its container's entry array
+	TMap<FContainerItemKey, int32> EntryLookup;
+
+	TArray<FInventoryContainerEntry>& GetStorage(EInventoryContainerReplication replication);
+	const TArray<FInventoryContainerEntry>& GetStorage(EInventoryContainerReplication replication) const;
+
+	int32 GetQuantityAt(uint8 container, const FName itemCode) const;
+
+	EChangeStatus ModifyEntryAt(uint8 container, const FName itemCode, int32 quantity);
+
+	// Swaps the last entry into the gap
+	void RemoveStorageEntry(TArray<FInventoryContainerEntry>& storage, int32 index);
+
+	void RebuildLookup(EInventoryContainerReplication replication);
+
+	bool HasAuthority() const;
+
+	bool HasRemoteClient() const;
+
+	UFUNCTION()
+		void OnRep_OwnerEntries(const TArray<FInventoryContainerEntry>& previousEntries);
+
+	UFUNCTION()
+		void OnRep_PublicEntries(const TArray<FInventoryContainerEntry>& previousEntries);
+
+	void ApplyReplicatedStorage(EInventoryContainerReplication replication, const TArray<FInventoryContainerEntry>& previousEntries);
+
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_OpenContainer(uint8 container);
+
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_CloseContainer(uint8 container);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_ReceiveContainer(uint8 container, const FInventoryEntryBatch& entries);
+
+	// Absolute quantities of every changed entry in the open on-demand containers; zero means removed
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_UpdateContainers(const TArray<FInventoryContainerEntry>& entries);
+
+	void ReplaceOnDemandContainer(uint8 container, const TArray<FInventoryEntry>& entries);
+
+	void ApplyOnDemandEntry(const FInventoryContainerEntry& entry);
+
+	friend class FContainerMutationScope;
+
+	int32 MutationDepth;
+
+	bool bOwnerEntriesDirty;
+	bool bPublicEntriesDirty;
+
+	// One bit per container
+	uint32 ChangedContainers;
+	uint32 OpenContainers;
+
+	// Server: changes to open on-demand containers made during the current batch
+	TSet<FContainerItemKey> PendingOnDemandChanges;
+
+	void EndMutation();
+
+	void BroadcastContainerChanges(uint32 changedContainers);
+
+public:
+	UContainerInventoryComponent();
+
+	// Containers are addressed by bit masks, so at most this many are used
+	static constexpr int32 MaxContainers = 32;
+
+	// Fixed once the component is in play
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory")
+		TArray<FInventoryContainerSpec> Containers;
+
+	// Fired once per batch for each container whose contents changed, on the server and on clients that can see it
+	UPROPERTY(BlueprintAssignable, Category = "Networked Inventory")
+		FOnInventoryContainerChanged OnContainerChanged;
+
+	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual bool IsSupportedForNetworking() const override { return true; }
+
+	// INDEX_NONE if there is no such container
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 FindContainer(const FName containerName) const;
+
+	// Server only. Quantities are deltas; entries that reach zero are removed.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		EChangeStatus ModifyContainer(const FName containerName, const FInventoryEntry& entryChange);
+
+	// Server only. Applied as one batch.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		EChangeGroupStatus ModifyContainers(const TArray<FInventoryContainerChange>& changes);
+
+	// Server only. Both containers change in the same batch, or neither does.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		ETransferStatus MoveItem(const FName fromContainer, const FName toContainer, const FName itemCode, int32 quantity);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 GetQuantityIn(const FName containerName, const FName itemCode) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		TArray<FInventoryEntry> GetContainerEntries(const FName containerName) const;
+
+	// False on clients for on-demand containers that are not open
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		bool IsContainerAvailable(const FName containerName) const;
+
+	// Asks the server to start sending an on-demand container. Owning client only.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void OpenContainer(const FName containerName);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void CloseContainer(const FName containerName);
+
+	virtual void ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
+
+	// Answered at once on the server; rejected on clients
+	virtual TFuture<FInventoryRequestResult> ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges) override;
+
+	virtual void AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
+
+	virtual void RemoveItemsFromInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		virtual FString ToString() const override;
+
+	virtual void GetEntries(TArray<FInventoryEntry>& outEntries) const override;
+
+	virtual int32 GetQuantityFor(const FName itemCode) const override;
+
+	FInventoryMemoryUsage GetMemoryUsage() const;
+
+	// Compacts the containers, e.g. after a bulk removal. Not allowed inside a batch.
+	void Shrink();
+};
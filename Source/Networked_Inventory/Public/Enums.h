@@ -39,3 +39,73 @@ enum class EAddStatus : uint8
 	Success UMETA(DisplayName = "Success"),
 	ItemAlreadyInInventory UMETA(DisplayName = "Item Already In Inventory")
 };
+
+UENUM(BlueprintType)
+enum class EInstanceDataField : uint8
+{
+	Durability UMETA(DisplayName = "Durability"),
+	Charges UMETA(DisplayName = "Charges"),
+	Roll UMETA(DisplayName = "Roll"),
+	Enchantment UMETA(DisplayName = "Enchantment"),
+	MAX UMETA(Hidden)
+};
+
+UENUM(BlueprintType)
+enum class ETransferStatus : uint8
+{
+	Success UMETA(DisplayName = "Success"),
+	InvalidInventory UMETA(DisplayName = "Invalid Inventory"),
+	NotAuthority UMETA(DisplayName = "Not Authority"),
+	InvalidQuantity UMETA(DisplayName = "Invalid Quantity"),
+	InsufficientQuantity UMETA(DisplayName = "Insufficient Quantity")
+};
+
+UENUM(BlueprintType)
+enum class EInventoryThrottlePolicy : uint8
+{
+	Defer UMETA(DisplayName = "Defer"),
+	Drop UMETA(DisplayName = "Drop")
+};
+
+UENUM(BlueprintType)
+enum class EInventoryRequestAdmission : uint8
+{
+	Executed UMETA(DisplayName = "Executed"),
+	Deferred UMETA(DisplayName = "Deferred"),
+	Dropped UMETA(DisplayName = "Dropped")
+};
+
+UENUM(BlueprintType)
+enum class EInventorySortOrder : uint8
+{
+	Name UMETA(DisplayName = "Name"),
+	Quantity UMETA(DisplayName = "Quantity"),
+	Category UMETA(DisplayName = "Category")
+};
+
+UENUM(BlueprintType)
+enum class EInventoryContainerReplication : uint8
+{
+	OwnerOnly UMETA(DisplayName = "Owner Only"),
+	Everyone UMETA(DisplayName = "Everyone"),
+	OnDemand UMETA(DisplayName = "On Demand"),
+	MAX UMETA(Hidden)
+};
+
+// Most urgent first
+UENUM(BlueprintType)
+enum class EInventorySendPriority : uint8
+{
+	Equipped UMETA(DisplayName = "Equipped"),
+	Backpack UMETA(DisplayName = "Backpack"),
+	ViewedContainer UMETA(DisplayName = "Viewed Container"),
+	Other UMETA(DisplayName = "Other")
+};
+
+UENUM(BlueprintType)
+enum class EInventoryRequestOutcome : uint8
+{
+	Committed UMETA(DisplayName = "Committed"),
+	Rejected UMETA(DisplayName = "Rejected"),
+	Cancelled UMETA(DisplayName = "Cancelled")
+};
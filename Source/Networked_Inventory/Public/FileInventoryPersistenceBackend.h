@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryPersistence.h"
+
+/**
+ * Local stand-in for a database: one small binary file per inventory id under a directory.
+ */
+class NETWORKED_INVENTORY_API FFileInventoryPersistenceBackend : public IInventoryPersistenceBackend
+{
+public:
+	FFileInventoryPersistenceBackend(const FString& directory);
+
+	virtual bool SaveBatch(const TArray<FInventoryPersistenceRecord>& records) override;
+	virtual EInventoryLoadResult Load(const FString& inventoryId, FInventoryPersistenceRecord& outRecord) override;
+
+private:
+	FString GetPathFor(const FString& inventoryId) const;
+
+	FString Directory;
+};
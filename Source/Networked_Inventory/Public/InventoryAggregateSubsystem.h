@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryAggregates.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryAggregateSubsystem.generated.h"
+
+/**
+ * Owns the world's aggregate views (see FInventoryAggregateViews) and merges their partial sums once per frame.
+ * Register a view, then have each inventory that should count towards it join it (JoinAggregateView).
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryAggregateSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UInventoryAggregateSubsystem* Get(const UObject* worldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		void RegisterView(const FName view);
+
+	// Summed over every inventory in the view, as of the start of this frame
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		int64 GetItemTotal(const FName view, const FName itemCode) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		int32 GetHolderCount(const FName view, const FName itemCode) const;
+
+	// Null if the view is not registered
+	const TMap<FName, FInventoryAggregateTotal>* GetTotals(const FName view) const;
+
+	const FInventoryAggregateViewsPtr& GetViews() const;
+
+private:
+	bool Tick(float deltaTime);
+
+	FInventoryAggregateViewsPtr Views;
+
+	FDelegateHandle TickHandle;
+};
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeRWLock.h"
+
+struct FInventoryAggregateTotal
+{
+	int64 Quantity = 0;
+
+	// Inventories holding at least one
+	int32 Holders = 0;
+};
+
+/**
+ * Per-item totals and holder counts over groups of inventories (the whole server, a team, a guild, ...).
+ * Inventories report every change as it happens into partial sums owned by the calling thread; Merge() folds
+ * them into the totals once per frame, so queries are a single map lookup and never walk the inventories.
+ * Views are registered and queried on the game thread; changes may be recorded from any thread.
+ */
+class NETWORKED_INVENTORY_API FInventoryAggregateViews
+{
+public:
+	// Returns the view's id; registering an existing name returns the same id
+	int32 RegisterView(const FName view);
+
+	// INDEX_NONE if the view is not registered
+	int32 FindView(const FName view) const;
+
+	// Visible to queries after the next Merge()
+	void Record(int32 viewId, const FName itemCode, int64 quantityDelta, int32 holderDelta);
+
+	void Merge();
+
+	// As of the last Merge()
+	FInventoryAggregateTotal GetTotal(int32 viewId, const FName itemCode) const;
+
+	// Every item with a non-zero total, as of the last Merge(). Null if the view is not registered.
+	const TMap<FName, FInventoryAggregateTotal>* GetTotals(int32 viewId) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	typedef TTuple<int32, FName> FViewItemKey;
+
+	struct FPartialSums
+	{
+		FCriticalSection Lock;
+		TMap<FViewItemKey, FInventoryAggregateTotal> Deltas;
+	};
+
+	void Apply(const TMap<FViewItemKey, FInventoryAggregateTotal>& deltas);
+
+	TArray<FName> ViewNames;
+	TArray<TMap<FName, FInventoryAggregateTotal>> Totals;
+
+	// Merge() runs on the game thread too, so its partial sums need no lock
+	TMap<FViewItemKey, FInventoryAggregateTotal> GameThreadDeltas;
+
+	mutable FRWLock WorkerPartialsLock;
+	TMap<uint32, TUniquePtr<FPartialSums>> WorkerPartials;
+};
+
+typedef TSharedPtr<FInventoryAggregateViews, ESPMode::ThreadSafe> FInventoryAggregateViewsPtr;
+
+/**
+ * The aggregate views one inventory contributes to. Joining adds what the inventory already holds; leaving takes it
+ * back out, so totals stay exact as inventories come and go.
+ */
+class NETWORKED_INVENTORY_API FInventoryAggregateMembership
+{
+public:
+	// forEachEntry(addEntry) must call addEntry(itemCode, quantity) for every entry held, counter items included
+	template<typename ForEachEntryType>
+	bool Join(const FInventoryAggregateViewsPtr& views, const FName view, ForEachEntryType forEachEntry)
+	{
+		const int32 viewId = views.IsValid() ? views->FindView(view) : INDEX_NONE;
+		if (viewId == INDEX_NONE || (Views.IsValid() && Views != views) || ViewIds.Contains(viewId))
+		{
+			return false;
+		}
+
+		Views = views;
+		ViewIds.Add(viewId);
+		forEachEntry([this, viewId](const FName itemCode, int64 quantity)
+		{
+			Views->Record(viewId, itemCode, quantity, 1);
+		});
+		return true;
+	}
+
+	template<typename ForEachEntryType>
+	bool Leave(const FName view, ForEachEntryType forEachEntry)
+	{
+		const int32 viewId = Views.IsValid() ? Views->FindView(view) : INDEX_NONE;
+		if (viewId == INDEX_NONE || ViewIds.Remove(viewId) == 0)
+		{
+			return false;
+		}
+
+		forEachEntry([this, viewId](const FName itemCode, int64 quantity)
+		{
+			Views->Record(viewId, itemCode, -quantity, -1);
+		});
+		return true;
+	}
+
+	template<typename ForEachEntryType>
+	void LeaveAll(ForEachEntryType forEachEntry)
+	{
+		for (int32 viewId : ViewIds)
+		{
+			forEachEntry([this, viewId](const FName itemCode, int64 quantity)
+			{
+				Views->Record(viewId, itemCode, -quantity, -1);
+			});
+		}
+		ViewIds.Reset();
+	}
+
+	// Also takes the values of counter items, which can exceed an int32
+	void OnQuantityChanged(const FName itemCode, int64 oldQuantity, int64 newQuantity);
+
+private:
+	// Kept alive by its members, so changes made after the owning world is gone are harmless
+	FInventoryAggregateViewsPtr Views;
+
+	TArray<int32> ViewIds;
+};
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "InventoryAsyncAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryRequestAnswered, const FInventoryRequestResult&, Result);
+
+/**
+ * Latent Blueprint node for IInventoryInterface::ModifyInventoryAsync. Further requests can be made while it waits;
+ * they are applied in the order they were made.
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryModifyAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	// inventory must implement IInventoryInterface
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory", meta = (BlueprintInternalUseOnly = "true", DisplayName = "Modify Inventory Async"))
+		static UInventoryModifyAsyncAction* ModifyInventoryAsync(UObject* inventory, const TArray<FInventoryEntry>& inventoryChanges);
+
+	// The server applied the request; EntryStatuses tells which entries went through
+	UPROPERTY(BlueprintAssignable)
+		FOnInventoryRequestAnswered OnCommitted;
+
+	// Rejected by the server, or the inventory went away first
+	UPROPERTY(BlueprintAssignable)
+		FOnInventoryRequestAnswered OnFailed;
+
+	virtual void Activate() override;
+
+private:
+	UPROPERTY()
+		UObject* Inventory;
+
+	TArray<FInventoryEntry> Changes;
+
+	void OnAnswered(const FInventoryRequestResult& result);
+};
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "InventoryRateLimitSubsystem.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryBandwidthSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FInventoryBandwidthStats
+{
+	GENERATED_BODY()
+
+	FInventoryBandwidthStats() : QueuedSends(0), MaxQueueDepth(0), SentSends(0), MergedSends(0), SentBytes(0), AverageLatencyMs(0.0f), MaxLatencyMs(0.0f) {}
+
+	// Currently waiting, over all connections
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 QueuedSends;
+
+	// Deepest any single connection's queue has been
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 MaxQueueDepth;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 SentSends;
+
+	// Sends folded into one that was already queued
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 MergedSends;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int64 SentBytes;
+
+	// From the first queued change to the send
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		float AverageLatencyMs;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		float MaxLatencyMs;
+};
+
+struct FInventoryQueuedSend
+{
+	TWeakObjectPtr<const UObject> Sender;
+	FName Channel;
+	EInventorySendPriority Priority;
+	double EnqueueTime;
+
+	// Sends whatever the sender has pending and returns the bytes it sent
+	TFunction<int32()> Send;
+};
+
+/**
+ * Outgoing inventory sends waiting for one connection. At most one send is queued per sender and channel; later
+ * requests are merged into it, since it sends the sender's latest pending state when it finally runs.
+ */
+class NETWORKED_INVENTORY_API FInventorySendQueue
+{
+public:
+	// Returns true if the send was merged into one already queued, which keeps its place and takes the higher priority
+	bool Enqueue(const UObject* sender, FName channel, EInventorySendPriority priority, double now, TFunction<int32()> send);
+
+	// Most urgent first, oldest first within a priority. Returns false if the queue is empty.
+	bool Pop(FInventoryQueuedSend& outSend);
+
+	int32 Num() const;
+
+private:
+	// Only a handful of inventories share a connection, so plain scans are cheapest
+	TArray<FInventoryQueuedSend> Sends;
+};
+
+/**
+ * Server-side scheduler for inventory traffic to clients. Each connection drains its queue once per frame, most
+ * urgent sends first, within a byte budget (see UInventoryRateLimitSettings), so a full inventory sync cannot hold
+ * up changes to what the player has equipped. A send may take the budget below zero; the connection then waits
+ * until it has paid that back.
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryBandwidthSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UInventoryBandwidthSubsystem* Get(const UObject* worldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Returns false if traffic is not scheduled (turned off, or no connection); the caller should send right away then
+	bool Enqueue(const UObject* connection, const UObject* sender, FName channel, EInventorySendPriority priority, TFunction<int32()> send);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		FInventoryBandwidthStats GetStats() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void ResetStats();
+
+	int32 GetQueueDepth(const UObject* connection) const;
+
+private:
+	struct FConnectionQueue
+	{
+		FInventorySendQueue Sends;
+		FInventoryTokenBucket Bytes;
+	};
+
+	bool Tick(float deltaTime);
+
+	TMap<TWeakObjectPtr<const UObject>, FConnectionQueue> Connections;
+
+	FInventoryBandwidthStats Stats;
+
+	double TotalLatencySeconds;
+
+	FDelegateHandle TickHandle;
+};
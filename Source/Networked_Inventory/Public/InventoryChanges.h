@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "InventoryChanges.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryChanged, const FInventoryChangeSet&, ChangeSet);
+
+/**
+ * Collects entry changes between broadcasts, keeping the first old quantity and the latest new quantity per item,
+ * so a burst of modifications in one frame turns into a single FInventoryChangeSet.
+ */
+class NETWORKED_INVENTORY_API FInventoryChangeAccumulator
+{
+public:
+	// Returns true if this is the first change since the last Consume()
+	bool Record(const FName itemCode, int32 oldQuantity, int32 newQuantity);
+
+	bool HasChanges() const;
+	void Consume(FInventoryChangeSet& outChangeSet);
+
+	SIZE_T GetAllocatedSize() const;
+	void Shrink();
+
+private:
+	TMap<FName, TPair<int32, int32>> PendingChanges;
+};
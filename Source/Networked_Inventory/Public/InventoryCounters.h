@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "Engine/EngineTypes.h"
+
+class UActorComponent;
+
+/**
+ * Values of an inventory's high-frequency counter items (see FInventoryCounterPolicy).
+ * On the server every change is folded into the value at once and only marked dirty; ConsumeDue() hands out the
+ * latest value of each dirty counter at most MaxUpdatesPerSecond times a second, so traffic stays bounded however
+ * often a counter changes. On clients the replicated values are eased towards over the policy's interpolation time.
+ * Values saturate instead of overflowing and never go below zero.
+ */
+class NETWORKED_INVENTORY_API FInventoryCounterSet
+{
+public:
+	void Add(const FName itemCode, int64 delta);
+	void Set(const FName itemCode, int64 value);
+
+	int64 GetValue(const FName itemCode) const;
+
+	// Interpolated value on clients; the same as GetValue() wherever values are not replicated in
+	double GetDisplayValue(const FName itemCode, double now) const;
+
+	bool HasDirty() const;
+
+	// True while the counter has a change not yet handed out by ConsumeDue()
+	bool IsDirty(const FName itemCode) const;
+
+	// Seconds until the next dirty counter may be sent; negative if none is dirty
+	double GetSecondsUntilDue(double now) const;
+
+	// Latest values of the dirty counters whose rate allows sending now. Returns false if there were none.
+	bool ConsumeDue(double now, TArray<FInventoryCounterValue>& outValues);
+
+	// Makes every counter due again, e.g. for a full resync
+	void MarkAllDirty();
+
+	void ApplyReplicated(const TArray<FInventoryCounterValue>& values, double now);
+
+	void GetValues(TArray<FInventoryCounterValue>& outValues) const;
+
+	int32 Num() const;
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FCounter
+	{
+		int64 Value = 0;
+
+		// Taken from the item's policy when the counter is first used
+		double MinSendInterval = 0.0;
+		double InterpolationSeconds = 0.0;
+
+		double LastSentTime = -DBL_MAX;
+		bool bDirty = false;
+
+		// Client: where the displayed value started easing from, and when
+		double StartValue = 0.0;
+		double StartTime = -DBL_MAX;
+	};
+
+	FCounter& FindOrAddCounter(const FName itemCode);
+
+	void MarkDirty(FCounter& counter);
+
+	TMap<FName, FCounter> Counters;
+	int32 NumDirty = 0;
+};
+
+/**
+ * An inventory component's counters: changes on the server go into an FInventoryCounterSet, and the values that are
+ * due are handed to the component's Send function from a timer on its world. Shared by the inventory components so
+ * the scheduling lives in one place; each only decides how the values travel to its clients.
+ */
+class NETWORKED_INVENTORY_API FInventoryCounterReplicator
+{
+public:
+	typedef TFunction<void(const TArray<FInventoryCounterValue>&)> FSendFunction;
+
+	// Called on the server after every change, with the old and new value
+	typedef TFunction<void(const FName, int64, int64)> FChangedFunction;
+
+	void Initialize(UActorComponent* owner, FSendFunction send, FChangedFunction onChanged);
+
+	// Server only; false (and a warning) anywhere else
+	bool Add(const FName itemCode, int64 delta);
+	bool Set(const FName itemCode, int64 value);
+
+	// Replaces every value, e.g. with saved ones. Counters missing from values go to zero.
+	void SetAll(const TArray<FInventoryCounterValue>& values);
+
+	int64 GetValue(const FName itemCode) const;
+	double GetDisplayValue(const FName itemCode) const;
+	void GetValues(TArray<FInventoryCounterValue>& outValues) const;
+
+	// Server: true while a change to the counter waits for its rate to allow sending
+	bool IsDirty(const FName itemCode) const;
+
+	// callback(itemCode, value) for every counter above zero
+	template<typename CallbackType>
+	void ForEachValue(CallbackType&& callback) const
+	{
+		TArray<FInventoryCounterValue> values;
+		Counters.GetValues(values);
+		for (const FInventoryCounterValue& value : values)
+		{
+			if (value.Value > 0)
+			{
+				callback(value.ItemCode, value.Value);
+			}
+		}
+	}
+
+	// Sends every counter again, e.g. to a client that has just joined
+	void MarkAllDirty();
+
+	// Sends the counters that are due now rather than on the next tick
+	void Flush();
+
+	// Client
+	void ApplyReplicated(const TArray<FInventoryCounterValue>& values);
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	bool CanChange(const FName itemCode) const;
+
+	void ScheduleFlush();
+
+	TWeakObjectPtr<UActorComponent> Owner;
+	FSendFunction Send;
+	FChangedFunction OnChanged;
+
+	FInventoryCounterSet Counters;
+	FTimerHandle FlushHandle;
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "Engine/NetSerialization.h"
+#include "InventoryEntryStream.generated.h"
+
+/**
+ * Replicated entry array that streams to each connection in bounded steps. Every net update sends a connection at most
+ * MaxEntriesPerUpdate changed entries, items carrying one of PriorityTags first, and remembers per connection what it
+ * has sent; removals always go out at once. A late joiner, or a client the inventory just became relevant to, therefore
+ * fills up over several updates instead of receiving the whole array in one burst, and can query what has arrived.
+ *
+ * The server calls MarkChanged() after changing Entries and, while HasPendingEntries() reports a connection left
+ * behind, keeps the property dirty so the rest follows. Clients read ReceivedPreviousQuantities in their RepNotify.
+ */
+USTRUCT()
+struct NETWORKED_INVENTORY_API FInventoryEntryStream
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FInventoryEntry> Entries;
+
+	TArray<FName> PriorityTags;
+
+	int32 MaxEntriesPerUpdate = 64;
+
+	// Client: quantity each item had before the updates received since this was last reset
+	TMap<FName, int32> ReceivedPreviousQuantities;
+
+	void MarkChanged();
+
+	// Server: true if an update since the last call had to leave entries for a later one. Clears the flag.
+	bool ConsumePendingEntries();
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+private:
+	bool WriteDelta(FNetDeltaSerializeInfo& DeltaParms);
+	bool ReadDelta(FNetDeltaSerializeInfo& DeltaParms);
+
+	bool IsPriority(const FName itemCode) const;
+
+	// Zero is never used, so a state that was only partly sent never matches
+	uint32 ChangeKey = 1;
+
+	bool bHasPendingEntries = false;
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryEntryStream> : public TStructOpsTypeTraitsBase2<FInventoryEntryStream>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
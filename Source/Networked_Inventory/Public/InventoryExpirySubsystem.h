@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "InventoryTimingWheel.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryExpirySubsystem.generated.h"
+
+/**
+ * Expires items for every inventory in the world from one shared FInventoryTimingWheel, driven by world time.
+ * Everything that expires in a frame is removed from its inventory in a single group change, so it replicates as
+ * one delta. Inventories schedule through FInventoryExpiryTracker (SetItemExpiry on the components).
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryExpirySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UInventoryExpirySubsystem* Get(const UObject* worldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Seconds of world time
+	double GetTime() const;
+
+	uint64 Schedule(double expiryTime, const FInventoryExpiryTimer& timer);
+
+	void Cancel(uint64 timerId);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		int32 NumPendingExpiries() const;
+
+	// Removes everything that has expired by now. Called every frame.
+	void ExpireItems();
+
+private:
+	bool Tick(float deltaTime);
+
+	FInventoryTimingWheel Wheel;
+
+	TArray<FInventoryExpiryTimer> ExpiredScratch;
+
+	FDelegateHandle TickHandle;
+};
+
+/**
+ * The pending expiries of one inventory's items. An item's expiry is dropped when the item is removed, so a stack
+ * that is used up and collected again does not inherit it.
+ */
+class NETWORKED_INVENTORY_API FInventoryExpiryTracker
+{
+public:
+	// Replaces any earlier expiry of the item. owner is what the subsystem removes the item from when it expires.
+	bool Set(UObject* owner, const FName itemCode, float lifetimeSeconds);
+
+	bool Clear(const FName itemCode);
+
+	void ClearAll();
+
+	// Negative if the item does not expire
+	float GetLifetimeRemaining(const FName itemCode) const;
+
+	// Every pending expiry as a UTC time, for saving
+	void GetExpiries(TArray<FInventoryItemExpiry>& outExpiries) const;
+
+	// Sets the expiries of a loaded inventory, whose items must already be held. Anything already past expires on
+	// the next tick.
+	void Restore(UObject* owner, const TArray<FInventoryItemExpiry>& expiries);
+
+	void OnQuantityChanged(const FName itemCode, int32 newQuantity);
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FPendingExpiry
+	{
+		uint64 TimerId;
+		double ExpiryTime;
+
+		// The same moment in wall-clock time. World time restarts with the server, so this is what gets saved.
+		FDateTime ExpiryUtc;
+	};
+
+	TWeakObjectPtr<UInventoryExpirySubsystem> Subsystem;
+
+	TMap<FName, FPendingExpiry> Expiries;
+};
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Templates/UniquePtr.h"
+#include "InventoryInstanceData.generated.h"
+
+/**
+ * Fixed-schema, plain-data payload attached to a single inventory entry (durability, rolls, enchantments...).
+ * Lives in an FInventoryInstanceArena, so items never need their own UObject or heap allocation.
+ */
+USTRUCT(BlueprintType)
+struct FInventoryInstanceData
+{
+	GENERATED_BODY()
+
+	static constexpr int32 NumFields = static_cast<int32>(EInstanceDataField::MAX);
+
+	FInventoryInstanceData() : Durability(0), Charges(0), Roll(0), Enchantment(0) {}
+
+	UPROPERTY(BlueprintReadWrite, Category = "Networked Inventory")
+		int32 Durability;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Networked Inventory")
+		int32 Charges;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Networked Inventory")
+		int32 Roll;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Networked Inventory")
+		int32 Enchantment;
+
+	int32 GetField(EInstanceDataField field) const;
+	void SetField(EInstanceDataField field, int32 value);
+
+	FORCEINLINE bool operator==(const FInventoryInstanceData& Other) const
+	{
+		return Durability == Other.Durability && Charges == Other.Charges && Roll == Other.Roll && Enchantment == Other.Enchantment;
+	}
+};
+
+/**
+ * Packed change to the instance data of one entry. Only the fields flagged in ChangedFields go over the wire.
+ */
+USTRUCT()
+struct FInventoryInstanceDataDelta
+{
+	GENERATED_BODY()
+
+	FInventoryInstanceDataDelta() : ItemCode(), ChangedFields(0), Values() {}
+
+	UPROPERTY()
+		FName ItemCode;
+
+	// One bit per EInstanceDataField
+	UPROPERTY()
+		uint8 ChangedFields;
+
+	UPROPERTY()
+		FInventoryInstanceData Values;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryInstanceDataDelta> : public TStructOpsTypeTraitsBase2<FInventoryInstanceDataDelta>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Replicated mirror of one entry's instance data, used by UReplicationInventoryComponent.
+ * Property replication only sends the fields of Data that actually changed.
+ */
+USTRUCT()
+struct FInventoryInstanceRecord
+{
+	GENERATED_BODY()
+
+	FInventoryInstanceRecord() : ItemCode(), Data() {}
+	FInventoryInstanceRecord(FName code, const FInventoryInstanceData& data) : ItemCode(code), Data(data) {}
+
+	UPROPERTY()
+		FName ItemCode;
+
+	UPROPERTY()
+		FInventoryInstanceData Data;
+};
+
+/**
+ * Pool allocator for instance data. Slots are handed out from fixed-size blocks and recycled through a free list;
+ * everything is released in one go by Reset() or when the arena is destroyed.
+ */
+class NETWORKED_INVENTORY_API FInventoryInstanceArena
+{
+public:
+	static constexpr int32 SlotsPerBlock = 128;
+
+	FInventoryInstanceArena() : HighWaterMark(0) {}
+
+	FInventoryInstanceArena(const FInventoryInstanceArena&) = delete;
+	FInventoryInstanceArena& operator=(const FInventoryInstanceArena&) = delete;
+
+	int32 Allocate();
+	void Free(int32 handle);
+	void Reset();
+
+	FInventoryInstanceData& Get(int32 handle);
+	const FInventoryInstanceData& Get(int32 handle) const;
+
+	int32 Num() const;
+	SIZE_T GetAllocatedSize() const;
+
+	// Live slots cannot move, so only trailing blocks with no live slots are released
+	void Shrink();
+
+private:
+	TArray<TUniquePtr<FInventoryInstanceData[]>> Blocks;
+	TArray<int32> FreeHandles;
+	int32 HighWaterMark;
+};
+
+/**
+ * Per-inventory instance data: an arena plus the item code -> slot mapping and per-field dirty tracking
+ * used to build packed deltas.
+ */
+class NETWORKED_INVENTORY_API FInventoryInstanceStore
+{
+public:
+	bool Contains(const FName itemCode) const;
+	const FInventoryInstanceData* Find(const FName itemCode) const;
+	int32 GetField(const FName itemCode, EInstanceDataField field) const;
+
+	void SetField(const FName itemCode, EInstanceDataField field, int32 value);
+	void Release(const FName itemCode);
+	void Reset();
+
+	bool HasPendingDeltas() const;
+	void ConsumeDeltas(TArray<FInventoryInstanceDataDelta>& outDeltas);
+	void ApplyDelta(const FInventoryInstanceDataDelta& delta);
+
+	int32 Num() const;
+	SIZE_T GetAllocatedSize() const;
+	void Shrink();
+
+	template<typename FuncType>
+	void ForEach(FuncType func) const
+	{
+		for (const auto& pair : Handles)
+		{
+			func(pair.Key, Arena.Get(pair.Value));
+		}
+	}
+
+private:
+	FInventoryInstanceArena Arena;
+
+	TMap<FName, int32> Handles;
+
+	TMap<FName, uint8> DirtyFields;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
 #include "Structs.h"
+#include "Async/Future.h"
 #include "InventoryInterface.generated.h"
 
 // This class does not need to be modified.
@@ -32,9 +33,33 @@ public:
 	UFUNCTION(Category = "Networked Inventory")
 		virtual void RemoveItemsFromInventory(const TArray<FInventoryEntry>& inventoryChanges) = 0;
 
+	// Resolves on the game thread once the server has committed or refused the change, with one status per entry.
+	// Any number of requests can be in flight; the server applies them in the order they were made, so a dependent
+	// request can be sent without waiting for the one before it.
+	// The default rejects every request without applying it; inventories that support requests override it.
+	virtual TFuture<FInventoryRequestResult> ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges);
+
 	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
 		virtual void AddItemToInventory(const FName itemCode, int32 quantity);
 
 	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
 		virtual FString ToString() const = 0;
+
+	// Copy of every entry currently held, in no particular order. The default asks GetQuantityFor about every item
+	// in FInventoryItemRegistry, so it misses unregistered items; inventories that hold those should override it.
+	// Each default is built on the other, so implementations must override at least one of the two.
+	virtual void GetEntries(TArray<FInventoryEntry>& outEntries) const;
+
+	// Zero if the item is not held. The default scans GetEntries.
+	virtual int32 GetQuantityFor(const FName itemCode) const;
+
+	// Full values of the counter items (see FInventoryCounterPolicy), which GetEntries leaves out. None by default.
+	virtual void GetCounterValues(TArray<FInventoryCounterValue>& outValues) const;
+
+	// Pending item expiries, so they can be saved with the entries. None by default.
+	virtual void GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const;
+
+protected:
+	// For requests answered on the spot, which all have request id 0
+	static TFuture<FInventoryRequestResult> MakeCompletedRequest(EInventoryRequestOutcome outcome, const TTuple<EChangeGroupStatus, TArray<EChangeStatus>>& statuses);
 };
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+// Marks an item as a high-frequency counter (currency, ammo, resources): 64-bit, accumulated on the server and
+// replicated as its latest value at a bounded rate
+struct FInventoryCounterPolicy
+{
+	// Upper bound on replicated updates per second for one counter, however often it changes
+	float MaxUpdatesPerSecond = 5.0f;
+
+	// How long clients take to glide from the displayed value to a newly replicated one; zero snaps
+	float InterpolationSeconds = 0.2f;
+};
+
+// The compact wire indices of the registered items at one point in time. Immutable once built, so a connection can
+// keep the table it agreed on while the registry changes.
+struct FInventoryNetIndexTable
+{
+	TArray<FName> Items;
+	TMap<FName, int32> Indices;
+
+	// CRC of the sorted, lowercased codes; equal checksums mean equal indices
+	uint32 Checksum = 0;
+};
+
+typedef TSharedPtr<const FInventoryNetIndexTable, ESPMode::ThreadSafe> FInventoryNetIndexTablePtr;
+
+/**
+ * Static, per-item-code metadata shared by every inventory (categories/tags, ...).
+ * Items should be registered at startup, before any inventory holds them.
+ */
+class NETWORKED_INVENTORY_API FInventoryItemRegistry
+{
+public:
+	static FInventoryItemRegistry& Get();
+
+	void RegisterItem(const FName itemCode, const TArray<FName>& tags);
+	void UnregisterItem(const FName itemCode);
+
+	// Same as RegisterItem for each pair, rebuilding the net index table once
+	void RegisterItems(const TMap<FName, TArray<FName>>& itemTags);
+
+	void RegisterCounter(const FName itemCode, const FInventoryCounterPolicy& policy);
+
+	// Null for ordinary items
+	const FInventoryCounterPolicy* GetCounterPolicy(const FName itemCode) const;
+
+	// Every item and counter code registered, in no particular order
+	void GetRegisteredItems(TArray<FName>& outItemCodes) const;
+
+	const TArray<FName>& GetTagsFor(const FName itemCode) const;
+	bool HasTag(const FName itemCode, const FName tag) const;
+
+	/**
+	 * Compact index used on the wire: the position in the sorted set of registered codes. A connection only uses
+	 * indices once both ends have confirmed they hold the same table (see the agreement functions below); until then,
+	 * and for codes registered after that, item codes go out as names. A null connection stands for a local
+	 * round trip and uses the current table. INDEX_NONE / NAME_None when the code or index is not in the table.
+	 */
+	int32 GetNetIndex(const FName itemCode, const UObject* connection) const;
+	FName GetItemForNetIndex(int32 netIndex, const UObject* connection) const;
+
+	uint32 GetNetIndexChecksum() const;
+
+	// Client: the checksum to report to the server. Indices received on this connection decode against the current
+	// table from now on, since the server only sends them once it has matched the checksum. Every inventory owned by
+	// the connection reports the same table, even if the registry changed in between.
+	uint32 BeginNetIndexAgreement(const UObject* connection);
+
+	// Server: a client reported the checksum of its table. Starts using indices on the connection if it matches ours.
+	bool AcceptNetIndexAgreement(const UObject* connection, uint32 checksum);
+
+	// Client: the server matched the checksum we reported, so we may send indices too
+	void ConfirmNetIndexAgreement(const UObject* connection, uint32 checksum);
+
+private:
+	struct FNetIndexAgreement
+	{
+		FInventoryNetIndexTablePtr Table;
+		bool bCanSendIndices = false;
+	};
+
+	// Called on every registration change; the table is rebuilt eagerly so lookups stay plain const reads
+	void RebuildNetIndexTable();
+
+	const FInventoryNetIndexTable* GetTableFor(const UObject* connection, bool bSending) const;
+
+	// Connections come and go for the lifetime of the process
+	void RemoveClosedConnections();
+
+	TMap<FName, TArray<FName>> ItemTags;
+
+	TMap<FName, FInventoryCounterPolicy> CounterPolicies;
+
+	FInventoryNetIndexTablePtr NetIndexTable = MakeShared<FInventoryNetIndexTable, ESPMode::ThreadSafe>();
+
+	// Game thread only, like the rest of net serialization
+	TMap<TWeakObjectPtr<const UObject>, FNetIndexAgreement> Agreements;
+};
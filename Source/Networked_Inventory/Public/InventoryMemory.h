@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Every allocation made on behalf of an inventory is tracked under this tag (run with -llm to see it)
+LLM_DECLARE_TAG_API(NetworkedInventory, NETWORKED_INVENTORY_API);
+
+struct NETWORKED_INVENTORY_API FInventoryMemoryUsage
+{
+	int32 NumEntries = 0;
+
+	// Heap memory held by the inventory's containers, slack included
+	SIZE_T AllocatedBytes = 0;
+
+	// What the live elements need. Secondary indexes count as fully used; slack is measured on the entry
+	// containers, which is where bulk removals leave it.
+	SIZE_T UsedBytes = 0;
+
+	SIZE_T GetSlackBytes() const
+	{
+		return AllocatedBytes > UsedBytes ? AllocatedBytes - UsedBytes : 0;
+	}
+
+	FInventoryMemoryUsage& operator+=(const FInventoryMemoryUsage& other)
+	{
+		NumEntries += other.NumEntries;
+		AllocatedBytes += other.AllocatedBytes;
+		UsedBytes += other.UsedBytes;
+		return *this;
+	}
+};
+
+namespace InventoryMemory
+{
+	template<typename ElementType, typename AllocatorType>
+	SIZE_T GetUsedSize(const TArray<ElementType, AllocatorType>& array)
+	{
+		return array.Num() * sizeof(ElementType);
+	}
+
+	// One element slot plus one hash bucket per element, the least a set of this size can get away with
+	template<typename KeyType, typename ValueType>
+	SIZE_T GetUsedSize(const TMap<KeyType, ValueType>& map)
+	{
+		return map.Num() * (sizeof(TSetElement<TPair<KeyType, ValueType>>) + sizeof(FSetElementId));
+	}
+
+	// Logs entry counts, allocated/used/slack bytes per inventory type and the largest inventories
+	NETWORKED_INVENTORY_API void LogReport(int32 numLargest);
+
+	// Compacts the containers of every live inventory; returns the number of bytes released
+	NETWORKED_INVENTORY_API SIZE_T ShrinkAll();
+}
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPackageMap;
+
+/**
+ * Bit-packing helpers shared by the inventory's custom NetSerialize implementations.
+ */
+namespace InventoryNetSerialization
+{
+	FORCEINLINE uint32 ZigZagEncode(int32 value)
+	{
+		return (static_cast<uint32>(value) << 1) ^ static_cast<uint32>(value >> 31);
+	}
+
+	FORCEINLINE int32 ZigZagDecode(uint32 value)
+	{
+		return static_cast<int32>(value >> 1) ^ -static_cast<int32>(value & 1);
+	}
+
+	// Small signed values (quantities, deltas) as a zig-zag varint: 1 byte for [-64, 63]
+	NETWORKED_INVENTORY_API void SerializeSignedPacked(FArchive& Ar, int32& value);
+
+	// Item codes in the registry table agreed with Map's connection go out as their compact index, anything else as a
+	// regular FName. A null Map uses the current table.
+	NETWORKED_INVENTORY_API void SerializeItemCode(FArchive& Ar, FName& itemCode, UPackageMap* Map);
+}
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/Queue.h"
+
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Full contents of one inventory at the time it was collected for saving.
+ */
+struct NETWORKED_INVENTORY_API FInventoryPersistenceRecord
+{
+	FString InventoryId;
+	TArray<FInventoryEntry> Entries;
+	TArray<FInventoryCounterValue> Counters;
+	TArray<FInventoryItemExpiry> Expiries;
+};
+
+enum class EInventoryLoadResult : uint8
+{
+	Found,
+	// Nothing was ever saved under the id
+	NotFound,
+	// Storage could not be read; the saved contents are unknown
+	Failed
+};
+
+/**
+ * Storage used by the write-behind persistence. SaveBatch() is only ever called from the writer thread;
+ * Load() may be called from any thread, so implementations must guard shared state themselves.
+ */
+class NETWORKED_INVENTORY_API IInventoryPersistenceBackend
+{
+public:
+	virtual ~IInventoryPersistenceBackend() {}
+
+	// Upsert every record of the batch. Returning false makes the writer retry the batch.
+	virtual bool SaveBatch(const TArray<FInventoryPersistenceRecord>& records) = 0;
+
+	// An inventory saved empty is Found with no entries, not NotFound
+	virtual EInventoryLoadResult Load(const FString& inventoryId, FInventoryPersistenceRecord& outRecord) = 0;
+};
+
+struct NETWORKED_INVENTORY_API FWriteBehindSettings
+{
+	FWriteBehindSettings() : FlushIntervalSeconds(5.0f), DirtyCountThreshold(256), MaxQueuedBatches(4), MaxSaveAttempts(3), RetryIntervalSeconds(10.0f) {}
+
+	// Dirty inventories are collected at least this often
+	float FlushIntervalSeconds;
+
+	// ... or as soon as this many inventories are dirty
+	int32 DirtyCountThreshold;
+
+	// Collection is held back (inventories stay dirty) while the writer has this many batches outstanding
+	int32 MaxQueuedBatches;
+
+	int32 MaxSaveAttempts;
+
+	// Records of a batch that failed every attempt are kept and tried again this often
+	float RetryIntervalSeconds;
+};
+
+/**
+ * Worker thread that drains batches of inventory records into a backend, off the game thread.
+ * A batch that fails MaxSaveAttempts times is not dropped: its records are kept and go out again with the next
+ * batch (or after RetryIntervalSeconds), except for inventories a later batch has newer contents for.
+ * On Stop() it finishes every batch already queued, and makes one last attempt at kept records, before exiting.
+ */
+class NETWORKED_INVENTORY_API FWriteBehindInventoryWriter : public FRunnable
+{
+public:
+	FWriteBehindInventoryWriter(TSharedRef<IInventoryPersistenceBackend, ESPMode::ThreadSafe> backend, const FWriteBehindSettings& settings);
+	virtual ~FWriteBehindInventoryWriter();
+
+	// Game thread
+	void Enqueue(TArray<FInventoryPersistenceRecord>&& batch);
+	int32 NumQueuedBatches() const;
+	int32 NumUnsavedInventories() const;
+	void Shutdown();
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	void SaveWithRetries(TArray<FInventoryPersistenceRecord>& batch);
+
+	TSharedRef<IInventoryPersistenceBackend, ESPMode::ThreadSafe> Backend;
+	FWriteBehindSettings Settings;
+
+	TQueue<TArray<FInventoryPersistenceRecord>, EQueueMode::Spsc> Batches;
+	FThreadSafeCounter QueuedBatches;
+
+	// Writer thread: records whose last save failed, by inventory id
+	TMap<FString, FInventoryPersistenceRecord> UnsavedRecords;
+	FThreadSafeCounter NumUnsaved;
+
+	FEvent* WorkEvent;
+	FThreadSafeBool bStopping;
+	FRunnableThread* Thread;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "InventoryPersistence.h"
+#include "InventoryPersistenceSubsystem.generated.h"
+
+class UActorComponent;
+
+/**
+ * Write-behind persistence for server inventories. Components with a PersistenceId report themselves dirty after
+ * each batch of changes; their contents are collected into batched upserts on an interval (or once enough are
+ * dirty) and written by a worker thread, so the game thread never waits on storage.
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryPersistenceSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UInventoryPersistenceSubsystem* Get(const UObject* worldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Starts persisting through the given backend, flushing everything pending to the previous one first
+	void SetBackend(TSharedPtr<IInventoryPersistenceBackend, ESPMode::ThreadSafe> backend, const FWriteBehindSettings& settings = FWriteBehindSettings());
+
+	bool HasBackend() const;
+
+	// The component must implement IInventoryInterface
+	void MarkDirty(UActorComponent* inventoryComponent, const FString& inventoryId);
+
+	// Saves this inventory now if it is dirty, e.g. because its component is going away
+	void FlushInventory(UActorComponent* inventoryComponent);
+
+	// Loads on a worker thread and calls back on the game thread with the saved record, including one saved empty.
+	// The callback is skipped if nothing was saved under the id or the component is gone. If storage cannot be read,
+	// the inventory is not saved for the rest of the session, so its unknown contents are never overwritten.
+	void LoadAsync(UActorComponent* inventoryComponent, const FString& inventoryId, TFunction<void(const FInventoryPersistenceRecord&)> onLoaded);
+
+	// Collects every dirty inventory right away, ignoring backpressure
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void FlushAll();
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 NumDirtyInventories() const;
+
+private:
+	bool Tick(float deltaTime);
+
+	void CollectDirty();
+
+	TSharedPtr<IInventoryPersistenceBackend, ESPMode::ThreadSafe> Backend;
+	TUniquePtr<FWriteBehindInventoryWriter> Writer;
+	FWriteBehindSettings Settings;
+
+	TMap<TWeakObjectPtr<UActorComponent>, FString> DirtyInventories;
+
+	// Ids whose load failed this session
+	TSet<FString> FailedLoads;
+
+	float TimeSinceCollect;
+	bool bLoggedBackpressure;
+
+	FDelegateHandle TickHandle;
+};
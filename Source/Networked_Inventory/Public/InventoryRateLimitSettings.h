@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Enums.h"
+#include "InventoryRateLimitSettings.generated.h"
+
+/**
+ * Limits on how much inventory work clients can make the server do, and on how much inventory traffic it sends them.
+ * Found under Project Settings > Plugins.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Networked Inventory Rate Limits"))
+class NETWORKED_INVENTORY_API UInventoryRateLimitSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryRateLimitSettings();
+
+	virtual FName GetCategoryName() const override;
+
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits")
+		bool bEnableRateLimiting;
+
+	// Sustained modification requests per second, per connection
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits", meta = (ClampMin = "0.1", EditCondition = "bEnableRateLimiting"))
+		float RequestsPerSecond;
+
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits", meta = (ClampMin = "1", EditCondition = "bEnableRateLimiting"))
+		int32 RequestBurst;
+
+	// Sustained entries per second, per connection, summed over all requests
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits", meta = (ClampMin = "1", EditCondition = "bEnableRateLimiting"))
+		float EntriesPerSecond;
+
+	// Also the largest single request that can ever be accepted
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits", meta = (ClampMin = "1", EditCondition = "bEnableRateLimiting"))
+		int32 EntryBurst;
+
+	// What happens to requests over a connection's limits
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits", meta = (EditCondition = "bEnableRateLimiting"))
+		EInventoryThrottlePolicy ThrottlePolicy;
+
+	// Deferred requests held per connection before further ones are dropped
+	UPROPERTY(config, EditAnywhere, Category = "Rate Limits", meta = (ClampMin = "1", EditCondition = "bEnableRateLimiting"))
+		int32 MaxDeferredRequestsPerConnection;
+
+	// Entries applied per frame across all connections; the rest waits for the next frame
+	UPROPERTY(config, EditAnywhere, Category = "Frame Budget", meta = (ClampMin = "1", EditCondition = "bEnableRateLimiting"))
+		int32 FrameEntryBudget;
+
+	// Queues inventory traffic to each client by priority within a byte budget (see UInventoryBandwidthSubsystem).
+	// Off by default: the budget is shared by every inventory on a connection, so it has to be sized for the game.
+	UPROPERTY(config, EditAnywhere, Category = "Outgoing Bandwidth")
+		bool bScheduleOutgoingTraffic;
+
+	// Sustained bytes per second of inventory traffic, per connection. Full syncs are paced by each component's
+	// SyncBytesPerSecond within this, so it should leave room above that for changes.
+	UPROPERTY(config, EditAnywhere, Category = "Outgoing Bandwidth", meta = (ClampMin = "1024", EditCondition = "bScheduleOutgoingTraffic"))
+		float OutgoingBytesPerSecond;
+
+	UPROPERTY(config, EditAnywhere, Category = "Outgoing Bandwidth", meta = (ClampMin = "1024", EditCondition = "bScheduleOutgoingTraffic"))
+		int32 OutgoingBurstBytes;
+};
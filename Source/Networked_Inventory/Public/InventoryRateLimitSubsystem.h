@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryRateLimitSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FInventoryRateLimitStats
+{
+	GENERATED_BODY()
+
+	FInventoryRateLimitStats() : ExecutedRequests(0), DeferredRequests(0), DroppedRequests(0), QueuedRequests(0) {}
+
+	// Executed on arrival or after being deferred
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 ExecutedRequests;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 DeferredRequests;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 DroppedRequests;
+
+	// Currently waiting for tokens or frame budget
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 QueuedRequests;
+};
+
+/**
+ * Refills continuously at a fixed rate up to a capacity; a request goes through only if it can pay its cost.
+ */
+struct NETWORKED_INVENTORY_API FInventoryTokenBucket
+{
+	FInventoryTokenBucket() : Tokens(0.0), LastRefillTime(-1.0) {}
+
+	// Starts full
+	void Refill(double ratePerSecond, double capacity, double now);
+
+	double Tokens;
+	double LastRefillTime;
+};
+
+/**
+ * Server-side admission control for client inventory requests. Each connection gets token buckets for requests
+ * and entries per second (see UInventoryRateLimitSettings), and all connections share a per-frame entry budget.
+ * Requests over their connection's limits are deferred or dropped by policy; requests over the frame budget are
+ * always carried into the next frame. A connection's requests always run in the order they arrived.
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryRateLimitSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UInventoryRateLimitSubsystem* Get(const UObject* worldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Runs the request now, later or never. Requests without a connection are trusted and always run immediately.
+	EInventoryRequestAdmission Submit(const UObject* connection, int32 numEntries, TFunction<void()> request);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		FInventoryRateLimitStats GetStats() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void ResetStats();
+
+	// Requests from this connection that were deferred or dropped
+	int32 GetThrottledCount(const UObject* connection) const;
+
+private:
+	struct FDeferredRequest
+	{
+		int32 NumEntries;
+		TFunction<void()> Request;
+	};
+
+	struct FConnectionBudget
+	{
+		FConnectionBudget() : NumThrottled(0) {}
+
+		FInventoryTokenBucket RequestTokens;
+		FInventoryTokenBucket EntryTokens;
+		TArray<FDeferredRequest> Deferred;
+		int32 NumThrottled;
+	};
+
+	enum class ELimit : uint8
+	{
+		None,
+		Connection,
+		Frame
+	};
+
+	// Takes the tokens and frame budget for the request if all of them are available
+	ELimit TryAdmit(FConnectionBudget& budget, int32 numEntries, double now);
+
+	bool Tick(float deltaTime);
+
+	TMap<TWeakObjectPtr<const UObject>, FConnectionBudget> Connections;
+
+	int32 FrameEntriesUsed;
+
+	FInventoryRateLimitStats Stats;
+
+	FDelegateHandle TickHandle;
+};
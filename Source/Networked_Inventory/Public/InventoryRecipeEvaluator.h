@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+
+class IInventoryInterface;
+
+struct NETWORKED_INVENTORY_API FInventoryRecipe
+{
+	FName RecipeId;
+
+	// Quantity of each item consumed per craft (or price per purchase)
+	TArray<FInventoryEntry> Ingredients;
+};
+
+/**
+ * Answers "which recipes can this inventory afford, and how many times" for a fixed recipe set.
+ * Requirements are compiled into a dense recipe x item matrix over every item used by any recipe, and the
+ * inventory's quantities are gathered into one vector, so each recipe is checked with four-wide SIMD compares
+ * instead of a hash lookup per ingredient. Changes only re-evaluate the recipes that use the changed items.
+ */
+class NETWORKED_INVENTORY_API FInventoryRecipeEvaluator
+{
+public:
+	FInventoryRecipeEvaluator();
+
+	void Compile(const TArray<FInventoryRecipe>& recipes);
+
+	// Gathers every quantity from the inventory and evaluates all recipes
+	void Refresh(const IInventoryInterface& inventory);
+
+	// Incremental updates; affected recipes are re-evaluated on the next Evaluate()
+	void OnQuantityChanged(const FName itemCode, int32 newQuantity);
+	void ApplyChanges(const FInventoryChangeSet& changeSet);
+
+	// Re-evaluates recipes touched since the last call. Returns the number of recipes evaluated.
+	int32 Evaluate();
+
+	int32 NumRecipes() const;
+	int32 FindRecipe(const FName recipeId) const;
+
+	// Results as of the last Evaluate() or Refresh()
+	const TBitArray<>& GetCraftableMask() const;
+	bool CanCraft(int32 recipeIndex) const;
+	int32 GetMaxCraftable(int32 recipeIndex) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	bool EvaluateRecipe(int32 recipeIndex) const;
+	int32 ComputeMaxCraftable(int32 recipeIndex) const;
+
+	// Columns are padded to a multiple of four so rows can be compared a register at a time
+	int32 NumColumns;
+	TMap<FName, int32> ItemColumns;
+
+	// NumRecipes x NumColumns, row major, zero where a recipe does not use an item
+	TArray<int32, TAlignedHeapAllocator<16>> Requirements;
+	TArray<int32, TAlignedHeapAllocator<16>> Quantities;
+
+	// Sparse copy of each row (column, amount) for the scalar max-craftable division
+	TArray<TArray<TPair<int32, int32>>> RecipeIngredients;
+
+	// Recipes that use each column
+	TArray<TArray<int32>> ColumnRecipes;
+
+	TArray<FName> RecipeIds;
+
+	TBitArray<> DirtyRecipes;
+	TArray<int32> DirtyRecipeList;
+
+	TBitArray<> Craftable;
+	TArray<int32> MaxCraftable;
+};
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "InventoryReplayCommandlet.generated.h"
+
+/**
+ * Re-applies a recorded inventory trace headlessly and reports throughput, apply latency percentiles and a checksum
+ * of the final state, so storage and persistence changes can be compared on real traffic.
+ *
+ * -run=InventoryReplay -Trace=<file> [-Storage=Replication|Inventory] [-Backend=None|File|SQLite] [-BackendPath=<path>]
+ *                      [-RealTime] [-IncludeClientOps]
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
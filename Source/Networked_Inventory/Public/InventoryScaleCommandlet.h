@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "InventoryScaleCommandlet.generated.h"
+
+/**
+ * Spawns growing numbers of inventory-bearing actors in a server world with simulated client connections, drives a
+ * randomized mutation workload through them frame by frame and appends frame time, mutation time, replication time,
+ * bytes sent and memory for each count to a CSV, so plugin versions and configurations can be compared. Each
+ * inventory is owned by one client and replicates to it through the net driver; the clients discard what they receive
+ * and never answer, so replies such as hash confirmations are not part of the load.
+ *
+ * -run=InventoryScale [-Counts=1000,5000,10000,25000,50000] [-Component=Replication|RPC] [-Clients=64] [-Frames=300]
+ *                     [-MutationRate=0.05] [-ItemsPerInventory=32] [-Seed=1] [-Label=<name>] [-Csv=<file>]
+ */
+UCLASS()
+class NETWORKED_INVENTORY_API UInventoryScaleCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryScaleCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+/**
+ * Immutable view of an inventory at the end of a committed batch. Safe to query from any thread.
+ * Entries are split into fixed chunks by item code so consecutive snapshots can share untouched chunks.
+ */
+class NETWORKED_INVENTORY_API FInventorySnapshot
+{
+public:
+	static constexpr int32 NumChunks = 32;
+
+	int32 GetQuantityFor(const FName itemCode) const;
+	bool Contains(const FName itemCode) const;
+	int32 Num() const;
+
+	// Increases by one with every published snapshot of the same inventory
+	uint64 GetVersion() const;
+
+	template<typename FuncType>
+	void ForEach(FuncType func) const
+	{
+		for (const FChunkPtr& chunk : Chunks)
+		{
+			for (const auto& pair : *chunk)
+			{
+				func(pair.Key, pair.Value);
+			}
+		}
+	}
+
+private:
+	friend class FInventorySnapshotPublisher;
+
+	using FChunk = TMap<FName, int32>;
+	using FChunkPtr = TSharedPtr<const FChunk, ESPMode::ThreadSafe>;
+
+	static int32 ChunkFor(const FName itemCode);
+
+	TArray<FChunkPtr, TFixedAllocator<NumChunks>> Chunks;
+	int32 NumEntries;
+	uint64 Version;
+};
+
+using FInventorySnapshotPtr = TSharedPtr<const FInventorySnapshot, ESPMode::ThreadSafe>;
+
+/**
+ * Owned by an inventory on the game thread. Changes are recorded as they happen and Publish() turns them into a
+ * new snapshot, copying only the chunks that were touched, and swaps it in for readers.
+ */
+class NETWORKED_INVENTORY_API FInventorySnapshotPublisher
+{
+public:
+	FInventorySnapshotPublisher();
+
+	// Game thread
+	bool IsEnabled() const;
+	void Enable();
+	void OnQuantityChanged(const FName itemCode, int32 newQuantity);
+	void Publish();
+
+	template<typename FuncType>
+	void EnableFrom(FuncType forEachEntry)
+	{
+		Enable();
+		forEachEntry([this](const FName itemCode, int32 quantity)
+		{
+			OnQuantityChanged(itemCode, quantity);
+		});
+		Publish();
+	}
+
+	// Any thread. Null until snapshots are enabled.
+	FInventorySnapshotPtr GetLatest() const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	bool bEnabled;
+
+	// Latest quantity per item since the last Publish(); zero or less means removed
+	TMap<FName, int32> PendingChanges;
+
+	// Last snapshot built by the game thread
+	FInventorySnapshotPtr Current;
+
+	// Readers only hold this long enough to copy the pointer; snapshot queries never lock
+	mutable FRWLock PublishedLock;
+	FInventorySnapshotPtr Published;
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Structs.h"
+#include "Math/RandomStream.h"
+
+/**
+ * The held items of an inventory kept in one sort order, as an indexable skip list: every link also stores how many
+ * entries it skips, so positions can be found on the way down. A change costs O(log n), a rank lookup O(log n) and a
+ * page of m entries O(log n + m), without ever re-sorting.
+ *
+ * Name order is lexical, quantity order is largest first, category order groups items by their first registered tag
+ * (uncategorized items last). Ties are broken by name.
+ */
+class NETWORKED_INVENTORY_API FInventorySortedView
+{
+public:
+	explicit FInventorySortedView(EInventorySortOrder order);
+
+	EInventorySortOrder GetOrder() const;
+
+	void OnQuantityChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity);
+	void Reset();
+
+	int32 Num() const;
+
+	// Zero-based position of the item in the view, INDEX_NONE if it is not held
+	int32 GetRank(const FName itemCode) const;
+
+	// Up to count entries starting at the given zero-based position
+	void GetRange(int32 first, int32 count, TArray<FInventoryEntry>& outEntries) const;
+
+	void GetPage(int32 pageIndex, int32 pageSize, TArray<FInventoryEntry>& outEntries) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+	template<typename MapType>
+	void Rebuild(const MapType& entries)
+	{
+		Reset();
+		for (const auto& pair : entries)
+		{
+			OnQuantityChanged(pair.Key, 0, pair.Value);
+		}
+	}
+
+private:
+	// Enough for 4^16 entries at one level per four nodes
+	static constexpr int32 MaxLevel = 16;
+
+	struct FLink
+	{
+		int32 Next;
+
+		// Entries passed by following this link; only meaningful while Next is set
+		int32 Span;
+	};
+
+	struct FNode
+	{
+		FName ItemCode;
+		FName Category;
+		int32 Quantity;
+		TArray<FLink, TInlineAllocator<4>> Links;
+	};
+
+	bool IsBefore(const FNode& node, const FName itemCode, const FName category, int32 quantity) const;
+
+	// Walks down to the last node before the key on every level, recording it and its position
+	void FindPredecessors(const FName itemCode, const FName category, int32 quantity, int32* outNodes, int32* outRanks) const;
+
+	void Insert(const FName itemCode, int32 quantity);
+	void Remove(const FName itemCode);
+
+	int32 AllocateNode();
+	int32 RandomLevel();
+
+	EInventorySortOrder Order;
+
+	// Node 0 is the head; removed nodes are recycled through FreeNodes
+	TArray<FNode> Nodes;
+	TArray<int32> FreeNodes;
+	TMap<FName, int32> NodeLookup;
+
+	int32 Level;
+	FRandomStream Random;
+};
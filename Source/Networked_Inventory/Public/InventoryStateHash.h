@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Order-independent hash of an inventory's contents, kept up to date in O(1) per entry change.
+ * Each entry hashes to a 64-bit value and the values are summed, so the hash does not depend on the order in which
+ * changes were applied. Item codes are also split into NumBuckets ranges of their (name string) hash, each with its
+ * own sum, so two diverged inventories can tell which ranges differ and repair only those.
+ * Built from the item name string rather than the FName index, so both ends of a connection agree.
+ */
+class NETWORKED_INVENTORY_API FInventoryStateHash
+{
+public:
+	static constexpr int32 NumBuckets = 16;
+
+	FInventoryStateHash();
+
+	void OnQuantityChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity);
+	void Reset();
+
+	uint64 GetHash() const;
+	uint64 GetBucketHash(int32 bucket) const;
+	void GetBucketHashes(TArray<uint64>& outBucketHashes) const;
+
+	// Bit i is set if bucket i differs from the given hashes
+	uint32 GetDifferingBuckets(const TArray<uint64>& otherBucketHashes) const;
+
+	static int32 GetBucketFor(const FName itemCode);
+
+	template<typename MapType>
+	void Rebuild(const MapType& entries)
+	{
+		Reset();
+		for (const auto& pair : entries)
+		{
+			OnQuantityChanged(pair.Key, 0, pair.Value);
+		}
+	}
+
+private:
+	static uint32 HashItemCode(const FName itemCode);
+	static uint64 HashEntry(uint32 itemHash, int32 quantity);
+
+	uint64 Hash;
+	uint64 BucketHashes[NumBuckets];
+};
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "InventoryInstanceData.h"
+
+/**
+ * Encoding of the chunks streamed during a full inventory sync: absolute quantities plus the complete instance data of
+ * those entries that have any, zlib compressed.
+ */
+namespace InventorySyncChunk
+{
+	// Chunks claiming to inflate beyond this are rejected
+	constexpr int32 MaxUncompressedSize = 1 << 20;
+
+	NETWORKED_INVENTORY_API bool Encode(const TArray<FInventoryEntry>& entries, const TArray<FInventoryInstanceRecord>& instances, TArray<uint8>& outCompressed, int32& outUncompressedSize);
+
+	NETWORKED_INVENTORY_API bool Decode(const TArray<uint8>& compressed, int32 uncompressedSize, TArray<FInventoryEntry>& outEntries, TArray<FInventoryInstanceRecord>& outInstances);
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Secondary index over an inventory: for every tag, the item codes held that carry it and their total quantity.
+ * Kept up to date one entry change at a time, so tag queries never walk the whole inventory.
+ */
+class NETWORKED_INVENTORY_API FInventoryTagIndex
+{
+public:
+	void OnQuantityChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity);
+	void Reset();
+
+	int32 CountItemsWithTag(const FName tag) const;
+	int64 GetQuantityForTag(const FName tag) const;
+	const TSet<FName>* GetItemsWithTag(const FName tag) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+	// Drops tags no held item carries any more and releases container slack
+	void Shrink();
+
+	template<typename MapType>
+	void Rebuild(const MapType& entries)
+	{
+		Reset();
+		for (const auto& pair : entries)
+		{
+			OnQuantityChanged(pair.Key, 0, pair.Value);
+		}
+	}
+
+private:
+	struct FTagBucket
+	{
+		FTagBucket() : TotalQuantity(0) {}
+
+		TSet<FName> Members;
+		int64 TotalQuantity;
+	};
+
+	TMap<FName, FTagBucket> Buckets;
+};
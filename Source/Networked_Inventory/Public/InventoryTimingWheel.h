@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+struct FInventoryExpiryTimer
+{
+	FInventoryExpiryTimer() : Inventory(), ItemCode() {}
+	FInventoryExpiryTimer(UObject* inventory, FName itemCode) : Inventory(inventory), ItemCode(itemCode) {}
+
+	TWeakObjectPtr<UObject> Inventory;
+	FName ItemCode;
+};
+
+/**
+ * Hierarchical timing wheel holding the pending expiry of every item in a world. Each level has 64 slots, each slot
+ * spanning 64 slots of the level below; a timer sits in the lowest level whose range covers it and moves down as its
+ * time approaches. Scheduling and cancelling are O(1), and advancing only touches the slots whose time has come, so
+ * the cost per frame follows the number of expiring timers rather than the number tracked. Game thread only.
+ */
+class NETWORKED_INVENTORY_API FInventoryTimingWheel
+{
+public:
+	explicit FInventoryTimingWheel(double secondsPerTick = 0.1);
+
+	// Fires no earlier than expiryTime and at most one tick after it. Returns an id for Cancel().
+	uint64 Schedule(double expiryTime, const FInventoryExpiryTimer& timer);
+
+	bool Cancel(uint64 timerId);
+
+	// Moves the wheel up to currentTime, appending every timer that came due in the order they expired
+	void Advance(double currentTime, TArray<FInventoryExpiryTimer>& outExpired);
+
+	int32 Num() const;
+
+	double GetSecondsPerTick() const;
+
+	SIZE_T GetAllocatedSize() const;
+
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 SlotsPerLevel = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+
+private:
+	struct FScheduledTimer
+	{
+		FInventoryExpiryTimer Timer;
+		int64 ExpiryTick;
+	};
+
+	void Insert(uint64 timerId, int64 expiryTick);
+
+	TArray<uint64>& GetSlot(int32 level, int64 tick);
+
+	double SecondsPerTick;
+	int64 CurrentTick;
+	uint64 NextTimerId;
+
+	// Cancelled timers are only dropped from here; their ids are skipped when their slot comes round
+	TMap<uint64, FScheduledTimer> Timers;
+
+	// NumLevels * SlotsPerLevel timer ids
+	TArray<TArray<uint64>> Slots;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+
+class IFileHandle;
+
+enum class EInventoryTraceOp : uint8
+{
+	// IInventoryInterface entry points
+	Add,
+	Remove,
+	Modify,
+
+	// RPC handlers
+	ServerModify,
+	ClientModify,
+
+	Count
+};
+
+struct NETWORKED_INVENTORY_API FInventoryTraceEvent
+{
+	// Seconds since recording started
+	double Time;
+
+	FString InventoryId;
+	EInventoryTraceOp Op;
+	TArray<FInventoryEntry> Entries;
+};
+
+/**
+ * Captures inventory mutations into a compact binary trace for replay (see UInventoryReplayCommandlet).
+ * Names are written once and referenced by index afterwards; times, counts and quantities are varints.
+ * Game thread only. Started and stopped with the Inventory.Trace.Start / Inventory.Trace.Stop console commands.
+ */
+class NETWORKED_INVENTORY_API FInventoryTraceRecorder
+{
+public:
+	static FInventoryTraceRecorder& Get();
+
+	// Cheap enough to check on every mutation
+	static bool IsRecording() { return bRecording; }
+
+	bool Start(const FString& path);
+	void Stop();
+
+	void Record(const UObject* inventory, EInventoryTraceOp op, const TArray<FInventoryEntry>& entries);
+
+	int64 NumRecordedEvents() const;
+
+private:
+	FInventoryTraceRecorder();
+	~FInventoryTraceRecorder();
+
+	int32 GetNameIndex(const FString& name);
+	void FlushBuffer();
+
+	static bool bRecording;
+
+	TUniquePtr<IFileHandle> File;
+	TArray<uint8> Buffer;
+
+	TMap<FString, int32> NameIndices;
+	TMap<FName, int32> ItemIndices;
+	TMap<TWeakObjectPtr<const UObject>, int32> InventoryIndices;
+
+	double LastEventTime;
+	int64 NumEvents;
+};
+
+class NETWORKED_INVENTORY_API FInventoryTraceReader
+{
+public:
+	FInventoryTraceReader();
+
+	bool Open(const FString& path);
+
+	// False at the end of the trace or if it is corrupt (see IsError)
+	bool Next(FInventoryTraceEvent& outEvent);
+
+	bool IsError() const;
+
+private:
+	TArray<uint8> Data;
+	int32 Offset;
+	TArray<FString> Names;
+	double Time;
+	bool bError;
+};
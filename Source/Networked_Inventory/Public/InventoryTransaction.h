@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Structs.h"
+
+class IInventoryInterface;
+
+/**
+ * Server-side batch of moves between any number of inventories. Every move is validated against the current
+ * quantities before anything changes; Commit() then applies one netted change set per inventory, so each
+ * affected inventory sends a single delta to its client.
+ */
+class NETWORKED_INVENTORY_API FInventoryTransaction
+{
+public:
+	FInventoryTransaction();
+
+	// Moves each entry's (positive) quantity from source to destination
+	void Transfer(IInventoryInterface* source, IInventoryInterface* destination, const TArray<FInventoryEntry>& entries);
+
+	// One-sided change (e.g. a vendor's gold sink) applied as part of the same transaction
+	void Modify(IInventoryInterface* inventory, const TArray<FInventoryEntry>& changes);
+
+	ETransferStatus Validate() const;
+
+	// Validates, then applies everything; nothing is applied if validation fails
+	ETransferStatus Commit();
+
+	// Net change per item for an inventory taking part in the transaction, or null
+	const TMap<FName, int64>* FindChanges(const IInventoryInterface* inventory) const;
+
+	int32 NumInventories() const;
+
+private:
+	struct FInventoryChanges
+	{
+		IInventoryInterface* Inventory;
+		TMap<FName, int64> Changes;
+	};
+
+	FInventoryChanges* FindOrAddChanges(IInventoryInterface* inventory);
+
+	TArray<FInventoryChanges, TInlineAllocator<2>> Participants;
+
+	// Recorded while building, reported by Validate()
+	ETransferStatus BuildStatus;
+
+	bool bCommitted;
+};
+
+namespace InventoryTransfer
+{
+	// Convenience for the common two-inventory case
+	NETWORKED_INVENTORY_API ETransferStatus TransferItems(IInventoryInterface* source, IInventoryInterface* destination, const TArray<FInventoryEntry>& entries);
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Structs.h"
+#include "InventorySnapshot.h"
+
+// State of one inventory captured at the end of a batch
+struct NETWORKED_INVENTORY_API FInventoryVerificationSample
+{
+	// Path of the inventory, for the report
+	FString Context;
+
+	TArray<FInventoryEntry> Entries;
+
+	// Only inventories with an index cache fill this in
+	bool bHasLookupCache = false;
+	TMap<FName, int32> LookupCache;
+
+	// Published at the end of the same batch, if the inventory publishes snapshots
+	FInventorySnapshotPtr Snapshot;
+};
+
+/**
+ * Opt-in consistency checks for inventories, kept off the hot paths: a sampled fraction of mutation batches is
+ * copied on the game thread and checked on the thread pool for entry/cache agreement, non-positive quantities,
+ * duplicate entries and agreement with the published snapshot. Violations are logged with the inventory path.
+ *
+ * Inventory.Verify 1 turns it on; Inventory.Verify.SampleRate sets the fraction of batches checked.
+ */
+class NETWORKED_INVENTORY_API FInventoryVerifier
+{
+public:
+	static FInventoryVerifier& Get();
+
+	// Cheap enough to call at the end of every batch
+	static bool ShouldSample();
+
+	// Checks the sample on a background task; dropped if too many are still running
+	void Submit(FInventoryVerificationSample&& sample);
+
+	// The checks themselves, on the calling thread
+	static void Verify(const FInventoryVerificationSample& sample, TArray<FString>& outViolations);
+
+	int64 NumVerifiedSamples() const;
+	int64 NumViolations() const;
+
+private:
+	FInventoryVerifier();
+
+	static constexpr int32 MaxTasksInFlight = 4;
+
+	TAtomic<int32> NumTasksInFlight;
+	TAtomic<int64> NumVerified;
+	TAtomic<int64> NumFound;
+};
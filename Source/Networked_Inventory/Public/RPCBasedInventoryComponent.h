@@ -6,11 +6,16 @@
 #include "Enums.h"
 #include "Structs.h"
 #include "Inventory.h"
+#include "InventoryInstanceData.h"
+#include "InventoryChanges.h"
+#include "InventoryCounters.h"
 #include "InventoryInterface.h"
+#include "Containers/Queue.h"
 #include "GameFramework/Actor.h"
 #include "Components/ActorComponent.h"
 #include "RPCBasedInventoryComponent.generated.h"
 
+struct FInventoryPersistenceRecord;
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class NETWORKED_INVENTORY_API URPCBasedInventoryComponent : public UActorComponent, public IInventoryInterface
@@ -21,33 +26,213 @@ private:
 	UPROPERTY()
 		UInventory* Inventory;
 
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_ReportItemRegistry(uint32 checksum);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_AcceptItemRegistry(uint32 checksum);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_ModifyInventory(const FInventoryEntryBatch& inventoryChanges);
+
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_ConfirmClientModification(EChangeGroupStatus clientStatus, uint64 clientHash);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_BeginInventorySync(int32 syncId);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_ReceiveInventorySyncChunk(int32 syncId, int32 uncompressedSize, const TArray<uint8>& compressedEntries);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_EndInventorySync(int32 syncId);
+
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_ConfirmInventorySync(ESetStatus clientStatus, uint64 clientHash);
+
+	// Server: items still to be streamed for the current full sync, priority items first
+	TArray<FName> SyncQueue;
+	TSet<FName> SyncQueuedItems;
+	int32 SyncCursor;
+	int32 SyncId;
+	float SyncByteAllowance;
+	bool bSyncInFlight;
+	FTimerHandle SyncTimerHandle;
+
+	// Client: items received during the current full sync; everything else is dropped when it ends
+	TSet<FName> ReceivedSyncItems;
+	int32 ActiveSyncId;
+	bool bSyncFailed;
+
+	void StartInventorySync();
+
+	void SendInventorySyncChunks();
+
+	// Returns the bytes sent
+	int32 SendInventorySyncChunksNow();
+
+	void SendInventorySyncChunk(const TArray<FInventoryEntry>& entries);
+
+	// True while the sync still has items to send, including any added since it started
+	bool QueueItemsAddedDuringSync();
+
 	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
-		void Client_ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges);
+		void Client_CompareBucketHashes(const TArray<uint64>& serverBucketHashes);
 
 	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
-		void Server_ConfirmClientModification(EChangeGroupStatus clientStatus);
+		void Server_RequestBuckets(uint32 bucketMask);
 
 	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
-		void Client_SetInventory(const UInventory* inventoryPtr);
+		void Client_ReplaceBuckets(uint32 bucketMask, const FInventoryEntryBatch& bucketEntries);
 
 	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
-		void Server_ConfirmClientSetInventory(ESetStatus clientStatus);
+		void Server_ConfirmBucketRepair(uint64 clientHash);
+
+	struct FExpectedClientHash
+	{
+		uint64 Hash;
+
+		// Not checked while a full sync is streaming, since the client is knowingly incomplete
+		bool bVerify;
+	};
+
+	// Server: state hash the client should report in each confirmation, in the order the confirmations will arrive
+	TQueue<FExpectedClientHash> ExpectedClientHashes;
+
+	void ExpectClientHash();
+
+	bool bRepairInFlight;
+
+	bool HasRemoteClient() const;
+
+	void StartBucketRepair();
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_ApplyInstanceDataDeltas(const TArray<FInventoryInstanceDataDelta>& deltas);
+
+	FTimerHandle InstanceDataFlushHandle;
+
+	void FlushInstanceData();
+
+	FInventoryCounterReplicator Counters;
+
+	// The aggregate views counter items are counted in; entries are counted by the inventory itself
+	FInventoryAggregateMembership CounterAggregates;
+
+	void QueueCounterValues(const TArray<FInventoryCounterValue>& values);
+
+	void OnCounterChanged(const FName itemCode, int64 oldValue, int64 newValue);
+
+	// Only sent at each counter's policy rate, so reliable delivery stays cheap
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_UpdateCounters(const TArray<FInventoryCounterValue>& counterValues);
+
+	FTimerHandle ChangeBroadcastHandle;
+
+	void OnInventoryChangesPending();
+
+	void MarkPersistenceDirty();
+
+	void ScheduleChangeBroadcast();
+
+	void ApplyLoadedRecord(const FInventoryPersistenceRecord& record);
+
+	// Server: applies the changes and forwards them to the client. outChangedCounters receives the counter items
+	// changed, whose values go out on their own schedule.
+	TTuple<EChangeGroupStatus, TArray<EChangeStatus>> ApplyServerModification(const FInventoryEntryBatch& inventoryBatch, TArray<FName>* outChangedCounters = nullptr);
+
+	// Server: runs a client's request through rate limiting. Request id 0 means nobody waits for an answer.
+	void AdmitClientModification(int32 requestId, const FInventoryEntryBatch& inventoryBatch);
+
+	void ApplyClientModification(int32 requestId, const FInventoryEntryBatch& inventoryBatch);
+
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_ModifyInventoryRequest(int32 requestId, const FInventoryEntryBatch& inventoryChanges);
+
+	// Sent on the same reliable channel as the changes, so requests are answered in order, after their deltas
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_CompleteRequests(const TArray<FInventoryRequestResult>& results);
+
+	// Client: requests made with ModifyInventoryAsync that the server has not answered yet
+	TMap<int32, TPromise<FInventoryRequestResult>> PendingRequests;
+	int32 NextRequestId;
+
+	// Server: answers held back until the queued deltas and counter values they describe have been sent
+	TArray<FInventoryRequestResult> UnsentResults;
+
+	// Server: counters changed by a held answer's request that their rate has not let out yet
+	TSet<FName> AwaitedCounters;
+
+	void CompleteRequest(const FInventoryRequestResult& result, const TArray<FName>& changedCounters = TArray<FName>());
+
+	void CancelPendingRequests();
+
+	// Server: each changed item's quantity before the first change the client has not been sent yet
+	TMap<FName, int32> UnsentDeltaBases;
+
+	// Server: latest counter values due for the client, sent with the deltas
+	TMap<FName, int64> UnsentCounterValues;
+
+	// Queues SendQueuedDeltas() on the client's connection, or sends right away if traffic is not scheduled
+	void ScheduleDeltaSend();
+
+	// Sends the net change of every item in UnsentDeltaBases as one batch, then the unsent counter values; returns
+	// the bytes sent
+	int32 SendQueuedDeltas();
+
+	// Applies directly on the server, bypassing rate limits; asks the server otherwise
+	void SubmitModification(const TArray<FInventoryEntry>& inventoryChanges);
+
+	void BroadcastPendingChanges();
 
 public:
 	URPCBasedInventoryComponent();
 
+	// Fired at most once per frame with every entry change made since the last broadcast
+	UPROPERTY(BlueprintAssignable, Category = "Networked Inventory")
+		FOnInventoryChanged OnInventoryChanged;
+
+	// Items carrying any of these tags are streamed first when the client's inventory is synced, in tag order
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory|Sync")
+		TArray<FName> PrioritySyncTags;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory|Sync", meta = (ClampMin = "1"))
+		int32 SyncChunkEntries;
+
+	// Compressed bytes per second a full sync may use; at least one chunk is always sent per interval
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory|Sync", meta = (ClampMin = "1024"))
+		int32 SyncBytesPerSecond;
+
+	// How urgently changes to this inventory are sent when the client's bandwidth is short. Full syncs always come last.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory|Sync")
+		EInventorySendPriority SendPriority;
+
+	// When set, the server loads this inventory on BeginPlay and saves it through UInventoryPersistenceSubsystem
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory|Persistence")
+		FString PersistenceId;
+
 	UFUNCTION(Category = "Networked Inventory")
 		UInventory* GetInventory();
 
+	// Client requests are subject to UInventoryRateLimitSubsystem; server code should call ModifyInventory instead
 	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
-		void Server_ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges);
+		void Server_ModifyInventory(const FInventoryEntryBatch& inventoryChanges);
 
+	// Streams the whole inventory to the owning client in compressed, prioritized chunks
 	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
 		void Server_SetClientInventory();
 
+	// Client: true while a full sync is streaming; entries not received yet may be stale or missing
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		bool IsSyncing() const;
+
 	UFUNCTION(Category = "Networked Inventory")
 		virtual void ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
 
+	// Sent to the server like ModifyInventory and resolved when the answer comes back. Applied and answered at once on
+	// the server.
+	virtual TFuture<FInventoryRequestResult> ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges) override;
+
 	UFUNCTION(Category = "Networked Inventory")
 		virtual void AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
 
@@ -57,12 +242,103 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
 		virtual FString ToString() const override;
 
+	virtual void GetEntries(TArray<FInventoryEntry>& outEntries) const override;
+
+	virtual void GetCounterValues(TArray<FInventoryCounterValue>& outValues) const override;
+
+	virtual void GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const override;
+
+	UFUNCTION(Category = "Networked Inventory")
+		virtual int32 GetQuantityFor(const FName itemCode) const override;
+
 	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
 		int32 Num() const;
 
 	UFUNCTION(Category = "Networked Inventory")
 		bool Contains(const FName itemCode) const;
 
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		bool SetInstanceField(const FName itemCode, EInstanceDataField field, int32 value);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 GetInstanceField(const FName itemCode, EInstanceDataField field) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 CountItemsWithTag(const FName tag) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int64 GetQuantityForTag(const FName tag) const;
+
+	const TSet<FName>* GetItemsWithTag(const FName tag) const;
+
+	// Counts this inventory towards a view registered with UInventoryAggregateSubsystem
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		bool JoinAggregateView(const FName view);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		bool LeaveAggregateView(const FName view);
+
+	// Server only. The item's whole stack is removed once lifetimeSeconds of world time have passed, together with
+	// anything else expiring in the same frame. False if the item is not held. With a PersistenceId the expiry is
+	// saved as a UTC time, so it keeps running while the server is down.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		bool SetItemExpiry(const FName itemCode, float lifetimeSeconds);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		bool ClearItemExpiry(const FName itemCode);
+
+	// Negative if the item does not expire
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		float GetItemLifetimeRemaining(const FName itemCode) const;
+
+	// Starts publishing a read-only snapshot after every committed batch. Game thread only.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void EnableSnapshots();
+
+	// Latest committed state, safe to read from any thread. Null until snapshots are enabled.
+	FInventorySnapshotPtr GetSnapshot() const;
+
+	// Keeps the entries sorted in this order from now on, so UI paging never re-sorts. Game thread only.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void EnableSortedView(EInventorySortOrder order);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void DisableSortedView(EInventorySortOrder order);
+
+	// Empty unless the view is enabled
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		TArray<FInventoryEntry> GetSortedPage(EInventorySortOrder order, int32 pageIndex, int32 pageSize) const;
+
+	// INDEX_NONE unless the view is enabled and the item is held
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 GetSortedRank(EInventorySortOrder order, const FName itemCode) const;
+
+	// Server only. Changes to items registered as counters are routed here by ModifyEntry as well.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		bool AddToCounter(const FName itemCode, int64 delta);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		bool SetCounter(const FName itemCode, int64 value);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		int64 GetCounterValue(const FName itemCode) const;
+
+	// Eased towards each replicated value on clients; meant for display
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		int64 GetDisplayedCounterValue(const FName itemCode) const;
+
+	// The wrapped inventory plus any sync state currently held
+	FInventoryMemoryUsage GetMemoryUsage() const;
+
+	void Shrink();
+
 protected:
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// How requests and their answers travel; the RPCs by default. Overridden by tests that run both ends in one world.
+	virtual void SendRequest(int32 requestId, const FInventoryEntryBatch& inventoryBatch);
+	virtual void SendAnswers(const TArray<FInventoryRequestResult>& results);
+	virtual void SendCounterValues(const TArray<FInventoryCounterValue>& counterValues);
 };
@@ -4,6 +4,16 @@
 
 #include "Enums.h"
 #include "Structs.h"
+#include "InventoryInstanceData.h"
+#include "InventoryTagIndex.h"
+#include "InventoryChanges.h"
+#include "InventorySnapshot.h"
+#include "InventoryMemory.h"
+#include "InventorySortedView.h"
+#include "InventoryCounters.h"
+#include "InventoryAggregates.h"
+#include "InventoryExpirySubsystem.h"
+#include "InventoryEntryStream.h"
 #include "CoreMinimal.h"
 #include "Templates/Tuple.h"
 #include "Net/UnrealNetwork.h"
@@ -11,6 +21,7 @@
 #include "Components/ActorComponent.h"
 #include "ReplicationInventoryComponent.generated.h"
 
+struct FInventoryPersistenceRecord;
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class NETWORKED_INVENTORY_API UReplicationInventoryComponent : public UActorComponent, public IInventoryInterface
@@ -20,7 +31,7 @@ class NETWORKED_INVENTORY_API UReplicationInventoryComponent : public UActorComp
 private:
 
 	UPROPERTY(ReplicatedUsing = OnRep_InventoryArray)
-		TArray<FInventoryEntry> InventoryArray;
+		FInventoryEntryStream InventoryArray;
 
 	UPROPERTY()
 		TMap<FName, int32> LookupCache;
@@ -31,9 +42,120 @@ private:
 	UFUNCTION()
 		void OnRep_InventoryArray();
 
+	FTimerHandle EntryStreamTimerHandle;
+
+	// Server: keeps the entry array replicating while a connection has not received all of it
+	void ContinueEntryStreams();
+
+	UFUNCTION(Server, Reliable, Category = "Networked Inventory")
+		void Server_ReportItemRegistry(uint32 checksum);
+
+	UFUNCTION(Client, Reliable, Category = "Networked Inventory")
+		void Client_AcceptItemRegistry(uint32 checksum);
+
+	FInventoryTagIndex TagIndex;
+
+	FInventoryChangeAccumulator PendingChanges;
+
+	FInventorySnapshotPublisher Snapshots;
+
+	TArray<FInventorySortedView> SortedViews;
+
+	FInventoryAggregateMembership Aggregates;
+
+	FInventoryExpiryTracker Expiries;
+
+	FTimerHandle ChangeBroadcastHandle;
+
+	void BroadcastPendingChanges();
+
+	ERemovalStatus RemoveEntry(const FName itemCode, int32 previousQuantity);
+
+	void OnEntryChanged(const FName itemCode, int32 oldQuantity, int32 newQuantity);
+
+	FInventoryInstanceStore InstanceData;
+
+	UPROPERTY(ReplicatedUsing = OnRep_InstanceRecords)
+		TArray<FInventoryInstanceRecord> InstanceRecords;
+
+	TMap<FName, int32> InstanceRecordLookup;
+
+	FTimerHandle InstanceDataFlushHandle;
+
+	void FlushInstanceData();
+
+	void RemoveInstanceRecord(const FName itemCode);
+
+	UFUNCTION()
+		void OnRep_InstanceRecords();
+
+	friend class FInventoryMutationScope;
+
+	int32 MutationDepth;
+
+	// Push-model dirtiness gathered during a batch and reported once in EndMutation()
+	bool bInventoryArrayDirty;
+	bool bInstanceRecordsDirty;
+
+	// Called on entry to / exit from the outermost mutating call, so each batch is handled once
+	void BeginMutation();
+	void EndMutation();
+
+	// Hands a copy of the current state to FInventoryVerifier
+	void SubmitVerificationSample() const;
+
+	FInventoryCounterReplicator Counters;
+
+	// Server: latest sent value of every counter, replicated as a whole so the newest value always wins
+	UPROPERTY(ReplicatedUsing = OnRep_CounterValues)
+		TArray<FInventoryCounterValue> CounterValues;
+
+	TMap<FName, int32> CounterValueLookup;
+
+	bool bCounterValuesDirty;
+
+	void SendCounters(const TArray<FInventoryCounterValue>& values);
+
+	void OnCounterChanged(const FName itemCode, int64 oldValue, int64 newValue);
+
+	void MarkPersistenceDirty();
+
+	UFUNCTION()
+		void OnRep_CounterValues();
+
+	FTimerHandle DormancyTimerHandle;
+
+	void EnterDormancy();
+
+	void ApplyLoadedRecord(const FInventoryPersistenceRecord& record);
+
 public:
 	UReplicationInventoryComponent();
 
+	// Fired at most once per frame with every entry change made since the last broadcast
+	UPROPERTY(BlueprintAssignable, Category = "Networked Inventory")
+		FOnInventoryChanged OnInventoryChanged;
+
+	// Puts the owning actor into net dormancy while the inventory is idle, waking it for each batch of changes
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory|Dormancy")
+		bool bManageNetDormancy;
+
+	// How long the inventory must go unchanged before the owner goes dormant again
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory|Dormancy", meta = (ClampMin = "0.5", EditCondition = "bManageNetDormancy"))
+		float DormancyIdleSeconds;
+
+	// Items carrying any of these tags reach a joining client first; each net update sends it at most SyncChunkEntries
+	// changed entries. Read on BeginPlay.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory|Sync")
+		TArray<FName> PrioritySyncTags;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Networked Inventory|Sync", meta = (ClampMin = "1"))
+		int32 SyncChunkEntries;
+
+	// When set, the server loads this inventory on BeginPlay and saves it through UInventoryPersistenceSubsystem
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory|Persistence")
+		FString PersistenceId;
+
 	//UFUNCTION(Category = "Networked Inventory")  // FIXME: Unrecognised type 'TTuple' - type must be a UCLASS, USTRUCT, or UENUM
 	TTuple<EChangeGroupStatus, TArray<EChangeStatus>> ModifyGroupOfEntries(const TArray<FInventoryEntry>& inventoryChanges);
 
@@ -57,7 +179,7 @@ public:
 		ERemovalStatus RemoveItem(const FName itemCode);
 
 	UFUNCTION(Category = "Networked Inventory")
-		int32 GetQuantityFor(const FName itemCode) const;
+		virtual int32 GetQuantityFor(const FName itemCode) const override;
 
 	UFUNCTION(Category = "Networked Inventory")
 		bool Contains(const FName itemCode) const;
@@ -68,6 +190,9 @@ public:
 	UFUNCTION(Category = "Networked Inventory")
 		virtual void ModifyInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
 
+	// Answered at once on the server. Clients cannot change a replicated inventory, so their requests are rejected.
+	virtual TFuture<FInventoryRequestResult> ModifyInventoryAsync(const TArray<FInventoryEntry>& inventoryChanges) override;
+
 	UFUNCTION(Category = "Networked Inventory")
 		virtual void AddItemsToInventory(const TArray<FInventoryEntry>& inventoryChanges) override;
 
@@ -77,9 +202,106 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
 		virtual FString ToString() const override;
 
+	virtual void GetEntries(TArray<FInventoryEntry>& outEntries) const override;
+
+	virtual void GetCounterValues(TArray<FInventoryCounterValue>& outValues) const override;
+
+	virtual void GetItemExpiries(TArray<FInventoryItemExpiry>& outExpiries) const override;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		bool SetInstanceField(const FName itemCode, EInstanceDataField field, int32 value);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 GetInstanceField(const FName itemCode, EInstanceDataField field) const;
+
+	const FInventoryInstanceData* FindInstanceData(const FName itemCode) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 CountItemsWithTag(const FName tag) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int64 GetQuantityForTag(const FName tag) const;
+
+	const TSet<FName>* GetItemsWithTag(const FName tag) const;
+
+	// Only needed if item tags are registered after the inventory already holds items. Also rebuilds sorted views.
+	UFUNCTION(Category = "Networked Inventory")
+		void RebuildTagIndex();
+
+	// Keeps the entries sorted in this order from now on, so UI paging never re-sorts. Game thread only.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void EnableSortedView(EInventorySortOrder order);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void DisableSortedView(EInventorySortOrder order);
+
+	// Null unless the view is enabled
+	const FInventorySortedView* GetSortedView(EInventorySortOrder order) const;
+
+	// Empty unless the view is enabled
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		TArray<FInventoryEntry> GetSortedPage(EInventorySortOrder order, int32 pageIndex, int32 pageSize) const;
+
+	// INDEX_NONE unless the view is enabled and the item is held
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		int32 GetSortedRank(EInventorySortOrder order, const FName itemCode) const;
+
+	// Counts this inventory towards a view registered with UInventoryAggregateSubsystem. False if the view is not
+	// registered or already joined.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		bool JoinAggregateView(const FName view);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Aggregates")
+		bool LeaveAggregateView(const FName view);
+
+	void LeaveAllAggregateViews();
+
+	// Server only. The item's whole stack is removed once lifetimeSeconds of world time have passed, together with
+	// anything else expiring in the same frame. False if the item is not held. With a PersistenceId the expiry is
+	// saved as a UTC time, so it keeps running while the server is down.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		bool SetItemExpiry(const FName itemCode, float lifetimeSeconds);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		bool ClearItemExpiry(const FName itemCode);
+
+	// Negative if the item does not expire
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Expiry")
+		float GetItemLifetimeRemaining(const FName itemCode) const;
+
+	// Starts publishing a read-only snapshot after every committed batch. Game thread only.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory")
+		void EnableSnapshots();
+
+	// Latest committed state, safe to read from any thread. Null until snapshots are enabled.
+	FInventorySnapshotPtr GetSnapshot() const;
+
+	// Server only. Changes to items registered as counters are routed here by ModifyEntry as well.
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		bool AddToCounter(const FName itemCode, int64 delta);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		bool SetCounter(const FName itemCode, int64 value);
+
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		int64 GetCounterValue(const FName itemCode) const;
+
+	// Eased towards each replicated value on clients; meant for display
+	UFUNCTION(BlueprintCallable, Category = "Networked Inventory|Counters")
+		int64 GetDisplayedCounterValue(const FName itemCode) const;
+
+	FInventoryMemoryUsage GetMemoryUsage() const;
+
+	// Compacts the containers, e.g. after a bulk removal. Not allowed inside a batch.
+	void Shrink();
+
+	virtual void BeginDestroy() override;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 		
 };
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryPersistence.h"
+
+class FSQLiteDatabase;
+
+/**
+ * Reference backend storing every inventory's entries in one SQLite table, plus a row per saved inventory so one saved
+ * empty can be told apart from one never saved. Each batch is written in a single transaction.
+ */
+class NETWORKED_INVENTORY_API FSQLiteInventoryPersistenceBackend : public IInventoryPersistenceBackend
+{
+public:
+	FSQLiteInventoryPersistenceBackend(const FString& databasePath);
+	virtual ~FSQLiteInventoryPersistenceBackend();
+
+	bool IsValid() const;
+
+	virtual bool SaveBatch(const TArray<FInventoryPersistenceRecord>& records) override;
+	virtual EInventoryLoadResult Load(const FString& inventoryId, FInventoryPersistenceRecord& outRecord) override;
+
+private:
+	TUniquePtr<FSQLiteDatabase> Database;
+
+	// Saves run on the writer thread while loads may come from elsewhere
+	FCriticalSection DatabaseLock;
+};
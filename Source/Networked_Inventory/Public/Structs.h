@@ -3,9 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Enums.h"
 #include "Structs.generated.h"
 
-USTRUCT()
+USTRUCT(BlueprintType)
 struct FInventoryEntry
 {
 	GENERATED_BODY()
@@ -13,10 +14,10 @@ struct FInventoryEntry
 	FInventoryEntry() : ItemCode(), Quantity(0) {}
 	FInventoryEntry(FName code, int32 quantity) : ItemCode(code), Quantity(quantity) {}
 
-	UPROPERTY()
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory")
 		FName ItemCode;
 
-	UPROPERTY()
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory")
 		int32 Quantity;
 
 	//check to see if the aggro record matches another aggro record by overloading the "==" operator.
@@ -24,4 +25,175 @@ struct FInventoryEntry
 	{
 		return ItemCode == Other.ItemCode && Quantity == Other.Quantity;
 	}
+
+	// Packs the item code as a registry index and the quantity as a zig-zag varint
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryEntry> : public TStructOpsTypeTraitsBase2<FInventoryEntry>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Entry array sent by the inventory RPCs. Serialized as sign runs followed by unsigned varint magnitudes.
+ */
+USTRUCT()
+struct FInventoryEntryBatch
+{
+	GENERATED_BODY()
+
+	FInventoryEntryBatch() : Entries() {}
+	FInventoryEntryBatch(const TArray<FInventoryEntry>& entries) : Entries(entries) {}
+
+	UPROPERTY()
+		TArray<FInventoryEntry> Entries;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryEntryBatch> : public TStructOpsTypeTraitsBase2<FInventoryEntryBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+USTRUCT(BlueprintType)
+struct FInventoryQuantityChange
+{
+	GENERATED_BODY()
+
+	FInventoryQuantityChange() : ItemCode(), OldQuantity(0), NewQuantity(0) {}
+	FInventoryQuantityChange(FName code, int32 oldQuantity, int32 newQuantity) : ItemCode(code), OldQuantity(oldQuantity), NewQuantity(newQuantity) {}
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		FName ItemCode;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 OldQuantity;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 NewQuantity;
+};
+
+USTRUCT(BlueprintType)
+struct FInventoryChangeSet
+{
+	GENERATED_BODY()
+
+	// Items that were not held before; OldQuantity is always 0
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		TArray<FInventoryQuantityChange> Added;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		TArray<FInventoryQuantityChange> Changed;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		TArray<FName> Removed;
+
+	FORCEINLINE bool IsEmpty() const
+	{
+		return Added.Num() == 0 && Changed.Num() == 0 && Removed.Num() == 0;
+	}
+};
+
+// Latest absolute value of a high-frequency counter item (see FInventoryCounterSet)
+USTRUCT()
+struct FInventoryCounterValue
+{
+	GENERATED_BODY()
+
+	FInventoryCounterValue() : ItemCode(), Value(0) {}
+	FInventoryCounterValue(FName code, int64 value) : ItemCode(code), Value(value) {}
+
+	UPROPERTY()
+		FName ItemCode;
+
+	UPROPERTY()
+		int64 Value;
+};
+
+// When an item's stack expires, in absolute UTC so the expiry outlives the session that set it
+USTRUCT()
+struct FInventoryItemExpiry
+{
+	GENERATED_BODY()
+
+	FInventoryItemExpiry() : ItemCode(), ExpiresUtc() {}
+	FInventoryItemExpiry(FName code, const FDateTime& expiresUtc) : ItemCode(code), ExpiresUtc(expiresUtc) {}
+
+	UPROPERTY()
+		FName ItemCode;
+
+	UPROPERTY()
+		FDateTime ExpiresUtc;
+};
+
+// Item stack held in one container of a UContainerInventoryComponent
+USTRUCT()
+struct FInventoryContainerEntry
+{
+	GENERATED_BODY()
+
+	FInventoryContainerEntry() : Container(0), ItemCode(), Quantity(0) {}
+	FInventoryContainerEntry(uint8 container, FName code, int32 quantity) : Container(container), ItemCode(code), Quantity(quantity) {}
+
+	// Index into the component's container list
+	UPROPERTY()
+		uint8 Container;
+
+	UPROPERTY()
+		FName ItemCode;
+
+	UPROPERTY()
+		int32 Quantity;
+};
+
+USTRUCT(BlueprintType)
+struct FInventoryContainerChange
+{
+	GENERATED_BODY()
+
+	FInventoryContainerChange() : Container(), ItemCode(), Quantity(0) {}
+	FInventoryContainerChange(FName container, FName code, int32 quantity) : Container(container), ItemCode(code), Quantity(quantity) {}
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory")
+		FName Container;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory")
+		FName ItemCode;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networked Inventory")
+		int32 Quantity;
+};
+
+// Answer to one asynchronous inventory request (see IInventoryInterface::ModifyInventoryAsync)
+USTRUCT(BlueprintType)
+struct FInventoryRequestResult
+{
+	GENERATED_BODY()
+
+	FInventoryRequestResult() : RequestId(0), Outcome(EInventoryRequestOutcome::Committed), GroupStatus(EChangeGroupStatus::AllSuccessful), EntryStatuses() {}
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		int32 RequestId;
+
+	// Rejected when the server refused the request (rate limiting, no authority); cancelled when the inventory went
+	// away before it was answered
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		EInventoryRequestOutcome Outcome;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		EChangeGroupStatus GroupStatus;
+
+	// One per requested entry, in request order. Empty unless committed.
+	UPROPERTY(BlueprintReadOnly, Category = "Networked Inventory")
+		TArray<EChangeStatus> EntryStatuses;
 };